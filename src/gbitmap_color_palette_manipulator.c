@@ -123,6 +123,100 @@ void gbitmap_fill_all_except(GColor color_to_not_change, GColor fill_color, bool
 
 }
 
+void gcolor_lut_init_identity(GColor *lut){
+
+	for(int i = 0; i < GCOLOR_LUT_SIZE; i++){
+		lut[i].argb = 0xC0 | i;
+	}
+
+}
+
+void gcolor_lut_set(GColor *lut, GColor color_to_replace, GColor replace_with_color){
+
+	lut[color_to_replace.argb & 0x3F] = replace_with_color;
+
+}
+
+static void remap_8bit_span(uint8_t *p, int count, const uint8_t *byte_lut){
+
+	//Leading bytes up to word alignment
+	while(count > 0 && ((uintptr_t)p & 0x3)){
+		*p = byte_lut[*p];
+		p++;
+		count--;
+	}
+
+	//Four pixels per word
+	uint32_t *w = (uint32_t *)p;
+	for(; count >= 4; count -= 4, w++){
+		uint32_t v = *w;
+		*w = (uint32_t)byte_lut[v & 0xFF] |
+			((uint32_t)byte_lut[(v >> 8) & 0xFF] << 8) |
+			((uint32_t)byte_lut[(v >> 16) & 0xFF] << 16) |
+			((uint32_t)byte_lut[v >> 24] << 24);
+	}
+
+	//Trailing bytes
+	p = (uint8_t *)w;
+	while(count > 0){
+		*p = byte_lut[*p];
+		p++;
+		count--;
+	}
+
+}
+
+void remap_gbitmap_colors(const GColor *lut, GBitmap *im, BitmapLayer *bml){
+
+	GBitmapFormat format = gbitmap_get_format(im);
+
+	if(format == GBitmapFormat8Bit || format == GBitmapFormat8BitCircular){
+
+		//Expand the table to every argb byte so the pixel loop is a plain lookup,
+		//keeping each pixel's alpha
+		uint8_t byte_lut[256];
+		for(int i = 0; i < 256; i++){
+			byte_lut[i] = (i & 0xC0) | (lut[i & 0x3F].argb & 0x3F);
+		}
+
+		GRect bounds = gbitmap_get_bounds(im);
+		for(int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h; y++){
+			GBitmapDataRowInfo row = gbitmap_get_data_row_info(im, y);
+			int min_x = (row.min_x > bounds.origin.x) ? row.min_x : bounds.origin.x;
+			int max_x = (row.max_x < bounds.origin.x + bounds.size.w - 1) ? row.max_x : bounds.origin.x + bounds.size.w - 1;
+			if(max_x >= min_x){
+				remap_8bit_span(row.data + min_x, max_x - min_x + 1, byte_lut);
+			}
+		}
+
+		#ifdef SHOW_APP_LOGS
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "--Remap 8Bit %d rows--", bounds.size.h);
+		#endif
+
+	}
+	else{
+
+		//Single pass over the palette, so mapping A->B and B->A at once needs no temporary color
+		int num_palette_items = get_num_palette_colors(im);
+		GColor *current_palette = gbitmap_get_palette(im);
+
+		for(int i = 0; i < num_palette_items; i++){
+			current_palette[i].argb = (current_palette[i].argb & 0xC0) | (lut[current_palette[i].argb & 0x3F].argb & 0x3F);
+		}
+
+		#ifdef SHOW_APP_LOGS
+		APP_LOG(APP_LOG_LEVEL_DEBUG, "--Remap Palette %d items--", num_palette_items);
+		#endif
+
+	}
+
+	//Mark the bitmaplayer dirty
+	if(bml != NULL){
+		layer_mark_dirty(bitmap_layer_get_layer(bml));
+	}
+
+}
+
 bool gbitmap_color_palette_contains_color(GColor m_color, GBitmap *im){
 
 	int num_palette_items = get_num_palette_colors(im);
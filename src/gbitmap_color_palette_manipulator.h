@@ -4,8 +4,15 @@
 #ifdef PBL_COLOR
 char* get_gbitmapformat_text(GBitmapFormat format);
 const char* get_gcolor_text(GColor m_color);
+int get_num_palette_colors(GBitmap *b);
 void replace_gbitmap_color(GColor color_to_replace, GColor replace_with_color, GBitmap *im, BitmapLayer *bml);
 void spit_gbitmap_color_palette(GBitmap *im);
 bool gbitmap_color_palette_contains_color(GColor m_color, GBitmap *im);
 void gbitmap_fill_all_except(GColor color_to_not_change, GColor fill_color, bool fill_gcolorclear, GBitmap *im, BitmapLayer *bml);
+
+//Color mapping table indexed by the rgb bits (argb & 0x3F) of the source color
+#define GCOLOR_LUT_SIZE 64
+void gcolor_lut_init_identity(GColor *lut);
+void gcolor_lut_set(GColor *lut, GColor color_to_replace, GColor replace_with_color);
+void remap_gbitmap_colors(const GColor *lut, GBitmap *im, BitmapLayer *bml);
 #endif
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "gbitmap_downscale.h"
+
+#define MAX_PALETTE_SIZE  16
+
+static int get_bits_per_pixel(GBitmapFormat format)
+{
+  switch (format)
+  {
+    case GBitmapFormat1Bit:         return 1;
+#ifdef PBL_COLOR
+    case GBitmapFormat1BitPalette:  return 1;
+    case GBitmapFormat2BitPalette:  return 2;
+    case GBitmapFormat4BitPalette:  return 4;
+#endif
+    default:                        return 0;
+  }
+}
+
+// GBitmapFormat1Bit stores the leftmost pixel in the lowest bit,
+// palettized formats in the highest bits
+static int get_pixel(const uint8_t* row, int x, int bpp, bool is_lsb_first)
+{
+  if (is_lsb_first) return (row[x >> 3] >> (x & 7)) & 1;
+
+  int bit = x * bpp;
+  return (row[bit >> 3] >> (8 - bpp - (bit & 7))) & ((1 << bpp) - 1);
+}
+
+static void set_pixel(uint8_t* row, int x, int bpp, bool is_lsb_first, int value)
+{
+  if (is_lsb_first)
+  {
+    if (value) row[x >> 3] |= (1 << (x & 7));
+    else       row[x >> 3] &= ~(1 << (x & 7));
+    return;
+  }
+
+  int bit = x * bpp;
+  int shift = 8 - bpp - (bit & 7);
+  int mask = ((1 << bpp) - 1) << shift;
+  row[bit >> 3] = (row[bit >> 3] & ~mask) | ((value << shift) & mask);
+}
+
+// source pixel i covers [i * num, (i + 1) * num), output pixel o covers [o * den, (o + 1) * den)
+static int get_weight(int i, int o, int num, int den)
+{
+  int start = (i * num > o * den) ? i * num : o * den;
+  int end = ((i + 1) * num < (o + 1) * den) ? (i + 1) * num : (o + 1) * den;
+  return (end > start) ? end - start : 0;
+}
+
+GBitmap* gbitmap_create_blank_like(GBitmap* src, GSize size, const GColor* palette)
+{
+  if (src == NULL) return NULL;
+
+  GBitmapFormat format = gbitmap_get_format(src);
+  int bpp = get_bits_per_pixel(format);
+  if (bpp == 0) return NULL;
+
+#ifdef PBL_COLOR
+  if (format != GBitmapFormat1Bit)
+  {
+    int palette_size = 1 << bpp;
+    GColor* dest_palette = malloc(sizeof(GColor) * palette_size);
+    if (dest_palette == NULL) return NULL;
+    memcpy(dest_palette, palette ? palette : gbitmap_get_palette(src), sizeof(GColor) * palette_size);
+
+    GBitmap* dest = gbitmap_create_blank_with_palette(size, format, dest_palette, true);
+    if (dest == NULL) free(dest_palette);
+    return dest;
+  }
+#endif
+  return gbitmap_create_blank(size, format);
+}
+
+bool gbitmap_downscale_rect(GBitmap* dest, GPoint dest_origin, GBitmap* src, GRect src_rect, int num, int den)
+{
+  if (dest == NULL || src == NULL) return false;
+  if (num <= 0 || num > den) return false;
+
+  GBitmapFormat format = gbitmap_get_format(src);
+  int bpp = get_bits_per_pixel(format);
+  if (bpp == 0 || gbitmap_get_format(dest) != format) return false;
+
+  bool is_lsb_first = (format == GBitmapFormat1Bit);
+  GRect src_bounds = gbitmap_get_bounds(src);
+  GRect dest_bounds = gbitmap_get_bounds(dest);
+  GSize size = GSize(src_rect.size.w * num / den, src_rect.size.h * num / den);
+  if (src_rect.origin.x < 0 || src_rect.origin.y < 0 ||
+      src_rect.origin.x + src_rect.size.w > src_bounds.size.w || src_rect.origin.y + src_rect.size.h > src_bounds.size.h ||
+      dest_origin.x < 0 || dest_origin.y < 0 ||
+      dest_origin.x + size.w > dest_bounds.size.w || dest_origin.y + size.h > dest_bounds.size.h) return false;
+
+  uint8_t* src_data = gbitmap_get_data(src);
+  int src_stride = gbitmap_get_bytes_per_row(src);
+  uint8_t* dest_data = gbitmap_get_data(dest);
+  int dest_stride = gbitmap_get_bytes_per_row(dest);
+  int src_x = src_bounds.origin.x + src_rect.origin.x;
+  int src_y = src_bounds.origin.y + src_rect.origin.y;
+
+  int coverage[MAX_PALETTE_SIZE];
+  for (int oy = 0; oy < size.h; ++oy)
+  {
+    int first_y = oy * den / num;
+    int last_y = ((oy + 1) * den - 1) / num;
+    uint8_t* dest_row = dest_data + (dest_bounds.origin.y + dest_origin.y + oy) * dest_stride;
+
+    for (int ox = 0; ox < size.w; ++ox)
+    {
+      int first_x = ox * den / num;
+      int last_x = ((ox + 1) * den - 1) / num;
+
+      memset(coverage, 0, sizeof(int) * (1 << bpp));
+      for (int iy = first_y; iy <= last_y; ++iy)
+      {
+        int weight_y = get_weight(iy, oy, num, den);
+        const uint8_t* src_row = src_data + (src_y + iy) * src_stride;
+
+        for (int ix = first_x; ix <= last_x; ++ix)
+        {
+          int value = get_pixel(src_row, src_x + ix, bpp, is_lsb_first);
+          coverage[value] += weight_y * get_weight(ix, ox, num, den);
+        }
+      }
+
+      // ties keep the set bit for GBitmapFormat1Bit and the first palette entry
+      // otherwise, the glyph color in the font atlases, so thin strokes survive
+      int best = is_lsb_first ? 1 : 0;
+      for (int i = 0; i < (1 << bpp); ++i)
+      {
+        if (coverage[i] > coverage[best]) best = i;
+      }
+
+      set_pixel(dest_row, dest_bounds.origin.x + dest_origin.x + ox, bpp, is_lsb_first, best);
+    }
+  }
+
+  return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <pebble.h>
+
+// create a blank bitmap of src's format, a palettized one with a copy of
+// palette, or of src's own if NULL. return NULL if the format is unsupported.
+GBitmap* gbitmap_create_blank_like(GBitmap* src, GSize size, const GColor* palette);
+
+// scale src_rect of src by num/den (num <= den) into dest at dest_origin with an
+// integer box filter. each output pixel takes the value covering the largest
+// area of its source box. both bitmaps share a format and palette. return false
+// if the format is unsupported or either rect falls outside its bitmap.
+bool gbitmap_downscale_rect(GBitmap* dest, GPoint dest_origin, GBitmap* src, GRect src_rect, int num, int den);
@@ -0,0 +1,9 @@
+#pragma once
+
+// the glyph tables of tools/atlasgen.py, or those of a host build variant that
+// packs atlases of its own, see tools/host/Makefile
+#ifdef GLYPH_ATLAS_HEADER
+#include GLYPH_ATLAS_HEADER
+#else
+#include "generated/glyph_atlas.h"
+#endif
@@ -0,0 +1,153 @@
+#include "glyph_blit.h"
+
+// GBitmapFormat1Bit rows are word aligned and store the leftmost pixel in the
+// lowest bit, so on the little endian watch bit i of a row word is pixel i
+static uint32_t load_bits(const uint32_t* row, int row_words, int bit)
+{
+  int word = bit >> 5;
+  int shift = bit & 31;
+  uint32_t bits = row[word] >> shift;
+  if (shift && word + 1 < row_words) bits |= row[word + 1] << (32 - shift);
+  return bits;
+}
+
+// pixels [from, to) of a row word
+static uint32_t get_word_mask(int from, int to)
+{
+  uint32_t mask = (to >= 32) ? 0xFFFFFFFF : ((1u << to) - 1);
+  return mask & ~((1u << from) - 1);
+}
+
+static void blit_1bit(GBitmap* frame_buffer, const GBitmap* src, GPoint src_origin, GRect dest, GCompOp comp_op)
+{
+  uint32_t* dest_data = (uint32_t*)gbitmap_get_data(frame_buffer);
+  int dest_words = gbitmap_get_bytes_per_row(frame_buffer) / 4;
+  const uint32_t* src_data = (const uint32_t*)gbitmap_get_data(src);
+  int src_words = gbitmap_get_bytes_per_row(src) / 4;
+
+  int left = dest.origin.x;
+  int right = dest.origin.x + dest.size.w;
+  int first_word = left >> 5;
+  int last_word = (right - 1) >> 5;
+
+  // the edge masks are the same for every row
+  uint32_t first_mask = get_word_mask(left & 31, (first_word == last_word) ? right - first_word * 32 : 32);
+  uint32_t last_mask = get_word_mask(0, right - last_word * 32);
+
+  for (int y = 0; y < dest.size.h; ++y)
+  {
+    uint32_t* dest_row = dest_data + (dest.origin.y + y) * dest_words;
+    const uint32_t* src_row = src_data + (src_origin.y + y) * src_words;
+
+    for (int word = first_word; word <= last_word; ++word)
+    {
+      // source pixel under the first pixel of this word, the first word starts mid word
+      int offset = word * 32 - left;
+      uint32_t bits = (offset < 0) ? load_bits(src_row, src_words, src_origin.x) << -offset
+                                   : load_bits(src_row, src_words, src_origin.x + offset);
+      uint32_t mask = (word == first_word) ? first_mask : (word == last_word) ? last_mask : 0xFFFFFFFF;
+
+      if (comp_op == GCompOpSet)
+        dest_row[word] |= ~bits & mask;   // black source pixels paint white, the rest stays
+      else
+        dest_row[word] = (dest_row[word] & ~mask) | (bits & mask);
+    }
+  }
+}
+
+#ifdef PBL_COLOR
+static void blit_8bit(GBitmap* frame_buffer, const GBitmap* src, GPoint src_origin, GRect dest, GCompOp comp_op)
+{
+  // four pixels per nibble of the source, leftmost (highest bit) in the lowest byte.
+  // GCompOpSet leaves the pixels of transparent palette entries as they are
+  const GColor* palette = gbitmap_get_palette(src);
+  uint32_t nibble_words[16];
+  uint32_t nibble_masks[16];
+  for (int nibble = 0; nibble < 16; ++nibble)
+  {
+    nibble_words[nibble] = 0;
+    nibble_masks[nibble] = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+      GColor color = palette[(nibble >> (3 - i)) & 1];
+      nibble_words[nibble] |= (uint32_t)color.argb << (8 * i);
+      if (comp_op != GCompOpSet || (color.argb & 0xC0)) nibble_masks[nibble] |= 0xFFu << (8 * i);
+    }
+  }
+
+  const uint8_t* src_data = gbitmap_get_data(src);
+  int src_stride = gbitmap_get_bytes_per_row(src);
+
+  for (int y = 0; y < dest.size.h; ++y)
+  {
+    // the round display's rows are shorter
+    GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, dest.origin.y + y);
+    int x = (row.min_x > dest.origin.x) ? row.min_x : dest.origin.x;
+    int end = (row.max_x + 1 < dest.origin.x + dest.size.w) ? row.max_x + 1 : dest.origin.x + dest.size.w;
+
+    const uint8_t* src_row = src_data + (src_origin.y + y) * src_stride;
+    int src_x = src_origin.x + (x - dest.origin.x);
+
+    while (x < end)
+    {
+      if ((src_x & 3) == 0 && end - x >= 4)
+      {
+        int nibble = (src_row[src_x >> 3] >> ((src_x & 4) ? 0 : 4)) & 0xF;
+        uint32_t word;
+        memcpy(&word, row.data + x, 4);
+        word = (word & ~nibble_masks[nibble]) | (nibble_words[nibble] & nibble_masks[nibble]);
+        memcpy(row.data + x, &word, 4);
+        x += 4;
+        src_x += 4;
+        continue;
+      }
+
+      // unaligned head and tail, a pixel at a time
+      GColor color = palette[(src_row[src_x >> 3] >> (7 - (src_x & 7))) & 1];
+      if (comp_op != GCompOpSet || (color.argb & 0xC0)) row.data[x] = color.argb;
+      ++x;
+      ++src_x;
+    }
+  }
+}
+#endif
+
+bool glyph_blit(GBitmap* frame_buffer, const GBitmap* src, GPoint src_origin, GRect dest, GCompOp comp_op)
+{
+  if (frame_buffer == NULL || src == NULL) return false;
+
+  // clip to the frame buffer
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+  if (dest.origin.x < bounds.origin.x)
+  {
+    src_origin.x += bounds.origin.x - dest.origin.x;
+    dest.size.w -= bounds.origin.x - dest.origin.x;
+    dest.origin.x = bounds.origin.x;
+  }
+  if (dest.origin.y < bounds.origin.y)
+  {
+    src_origin.y += bounds.origin.y - dest.origin.y;
+    dest.size.h -= bounds.origin.y - dest.origin.y;
+    dest.origin.y = bounds.origin.y;
+  }
+  if (dest.origin.x + dest.size.w > bounds.origin.x + bounds.size.w) dest.size.w = bounds.origin.x + bounds.size.w - dest.origin.x;
+  if (dest.origin.y + dest.size.h > bounds.origin.y + bounds.size.h) dest.size.h = bounds.origin.y + bounds.size.h - dest.origin.y;
+  if (dest.size.w <= 0 || dest.size.h <= 0) return true;
+
+  GBitmapFormat dest_format = gbitmap_get_format(frame_buffer);
+  GBitmapFormat src_format = gbitmap_get_format(src);
+
+  if (dest_format == GBitmapFormat1Bit && src_format == GBitmapFormat1Bit)
+  {
+    blit_1bit(frame_buffer, src, src_origin, dest, comp_op);
+    return true;
+  }
+#ifdef PBL_COLOR
+  if ((dest_format == GBitmapFormat8Bit || dest_format == GBitmapFormat8BitCircular) && src_format == GBitmapFormat1BitPalette)
+  {
+    blit_8bit(frame_buffer, src, src_origin, dest, comp_op);
+    return true;
+  }
+#endif
+  return false;
+}
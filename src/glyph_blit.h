@@ -0,0 +1,13 @@
+#pragma once
+#include <pebble.h>
+
+// draw glyphs straight into the captured frame buffer, a 32 bit word of pixels
+// at a time, instead of compositing a BitmapLayer per glyph.
+//
+// src is a GBitmapFormat1Bit glyph cell from the glyph cache on the black and
+// white platforms, a GBitmapFormat1BitPalette font atlas on the color ones.
+// src_origin is the glyph's top left in src, dest its frame on screen, clipped
+// to the frame buffer and the round display's rows. comp_op is GCompOpAssign
+// or GCompOpSet, as the time rows use them. return false if the formats are
+// not supported.
+bool glyph_blit(GBitmap* frame_buffer, const GBitmap* src, GPoint src_origin, GRect dest, GCompOp comp_op);
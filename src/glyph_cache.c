@@ -0,0 +1,200 @@
+#include "glyph_cache.h"
+#include "profile.h"
+
+#ifdef GLYPH_ATLAS_CELLS
+
+#define GLYPH_CACHE_SLOT_NUM  32
+
+struct GlyphCacheSlot
+{
+  GBitmap* bitmap;          // over the slot's cell in the store, kept until deinit
+  uint32_t resource_id;
+  uint32_t last_used;
+  uint16_t offset;          // of the cell in the store
+  uint16_t bytes;           // 0 if the slot is free
+  uint8_t cell;
+  uint8_t ref_count;        // layers showing the glyph
+};
+
+// the cells, one after another, in a store of the budget allocated once. the
+// slots' bitmaps are sub bitmaps of it, so they own no data and are pointed at
+// their cells with gbitmap_set_data
+static GBitmap* s_store;
+static struct GlyphCacheSlot s_slots[GLYPH_CACHE_SLOT_NUM];
+static int s_budget_bytes;
+static int s_resident_bytes;
+static int s_store_end;     // the cells end here, past it is free
+static uint32_t s_use_clock;
+
+// cells are stored like the rows of a GBitmapFormat1Bit bitmap, word aligned
+static int get_cell_row_bytes(int size)
+{
+  return (size + 31) / 32 * 4;
+}
+
+static void point_slot(struct GlyphCacheSlot* slot, int size)
+{
+  gbitmap_set_data(slot->bitmap, gbitmap_get_data(s_store) + slot->offset, GBitmapFormat1Bit, get_cell_row_bytes(size), false);
+  gbitmap_set_bounds(slot->bitmap, GRect(0, 0, size, size));
+}
+
+static void load_cell(struct GlyphCacheSlot* slot, uint32_t resource_id, int size, int cell)
+{
+  int bytes = get_cell_row_bytes(size) * size;
+  resource_load_byte_range(resource_get_handle(resource_id), cell * bytes, gbitmap_get_data(s_store) + slot->offset, bytes);
+  point_slot(slot, size);
+}
+
+// move the cells down over the gaps dropped ones left, in store order, and
+// point their bitmaps at where they went. layers keep the same bitmaps
+static void compact_store()
+{
+  uint8_t* data = gbitmap_get_data(s_store);
+  int end = 0;
+  for (;;)
+  {
+    struct GlyphCacheSlot* next = NULL;
+    for (int i = 0; i < GLYPH_CACHE_SLOT_NUM; ++i)
+    {
+      struct GlyphCacheSlot* slot = &s_slots[i];
+      if (slot->bytes == 0 || slot->offset < end) continue;
+      if (next == NULL || slot->offset < next->offset) next = slot;
+    }
+    if (next == NULL) break;
+
+    if (next->offset != end)
+    {
+      memmove(data + end, data + next->offset, next->bytes);
+      next->offset = end;
+      point_slot(next, gbitmap_get_bounds(next->bitmap).size.w);
+    }
+    end += next->bytes;
+  }
+  s_store_end = end;
+}
+
+static struct GlyphCacheSlot* find_free_slot()
+{
+  for (int i = 0; i < GLYPH_CACHE_SLOT_NUM; ++i)
+  {
+    if (s_slots[i].bytes == 0) return &s_slots[i];
+  }
+  return NULL;
+}
+
+// return false if every cached glyph is on screen
+static bool drop_least_recent()
+{
+  struct GlyphCacheSlot* oldest = NULL;
+  for (int i = 0; i < GLYPH_CACHE_SLOT_NUM; ++i)
+  {
+    struct GlyphCacheSlot* slot = &s_slots[i];
+    if (slot->bytes == 0 || slot->ref_count > 0) continue;
+    if (oldest == NULL || slot->last_used < oldest->last_used) oldest = slot;
+  }
+  if (oldest == NULL) return false;
+
+  s_resident_bytes -= oldest->bytes;
+  oldest->bytes = 0;
+  return true;
+}
+
+void glyph_cache_init(int budget_bytes)
+{
+  memset(s_slots, 0, sizeof(s_slots));
+  s_budget_bytes = budget_bytes;
+  s_resident_bytes = 0;
+  s_store_end = 0;
+  s_use_clock = 0;
+
+  // a 32 pixel wide 1-bit bitmap has 4 byte rows
+  s_store = gbitmap_create_blank(GSize(32, (budget_bytes + 3) / 4), GBitmapFormat1Bit);
+  for (int i = 0; s_store && i < GLYPH_CACHE_SLOT_NUM; ++i)
+  {
+    s_slots[i].bitmap = gbitmap_create_as_sub_bitmap(s_store, GRect(0, 0, 1, 1));
+    if (s_slots[i].bitmap == NULL)
+    {
+      glyph_cache_deinit();
+      break;
+    }
+  }
+  if (s_store == NULL) APP_LOG(APP_LOG_LEVEL_ERROR, "glyph cache: cannot allocate %d bytes", budget_bytes);
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "glyph cache: %d bytes budget, whole atlases take %d", budget_bytes, GLYPH_ATLAS_RESIDENT_BYTES);
+}
+
+void glyph_cache_deinit()
+{
+  for (int i = 0; i < GLYPH_CACHE_SLOT_NUM; ++i)
+  {
+    if (s_slots[i].bitmap) gbitmap_destroy(s_slots[i].bitmap);
+    s_slots[i].bitmap = NULL;
+    s_slots[i].bytes = 0;
+  }
+  if (s_store) gbitmap_destroy(s_store);
+  s_store = NULL;
+  s_resident_bytes = 0;
+  s_store_end = 0;
+}
+
+GBitmap* glyph_cache_acquire(uint32_t resource_id, int size, int cell)
+{
+  for (int i = 0; i < GLYPH_CACHE_SLOT_NUM; ++i)
+  {
+    struct GlyphCacheSlot* slot = &s_slots[i];
+    if (slot->bytes > 0 && slot->resource_id == resource_id && slot->cell == cell)
+    {
+      slot->ref_count++;
+      slot->last_used = ++s_use_clock;
+      PROFILE_ADD(PROFILE_GLYPH_CACHE_HITS, 1);
+      return slot->bitmap;
+    }
+  }
+
+  PROFILE_ADD(PROFILE_GLYPH_CACHE_MISSES, 1);
+
+  if (s_store == NULL) return NULL;
+
+  int bytes = get_cell_row_bytes(size) * size;
+  while (s_resident_bytes + bytes > s_budget_bytes && drop_least_recent()) {}
+
+  struct GlyphCacheSlot* slot = find_free_slot();
+  if (slot == NULL && drop_least_recent()) slot = find_free_slot();
+  if (slot == NULL || s_resident_bytes + bytes > s_budget_bytes)
+  {
+    APP_LOG(APP_LOG_LEVEL_ERROR, "glyph cache: the glyphs on screen fill it");
+    return NULL;
+  }
+  if (s_store_end + bytes > s_budget_bytes) compact_store();
+
+  slot->offset = s_store_end;
+  s_store_end += bytes;
+  load_cell(slot, resource_id, size, cell);
+
+  slot->resource_id = resource_id;
+  slot->cell = cell;
+  slot->bytes = bytes;
+  slot->ref_count = 1;
+  slot->last_used = ++s_use_clock;
+  s_resident_bytes += bytes;
+  PROFILE_MAX(PROFILE_FONT_RESIDENT_BYTES, s_resident_bytes);
+
+  return slot->bitmap;
+}
+
+void glyph_cache_release(const GBitmap* bitmap)
+{
+  for (int i = 0; i < GLYPH_CACHE_SLOT_NUM; ++i)
+  {
+    struct GlyphCacheSlot* slot = &s_slots[i];
+    if (slot->bytes > 0 && slot->bitmap == bitmap && slot->ref_count > 0)
+    {
+      // on screen until now, so used more recently than anything acquired since
+      slot->ref_count--;
+      slot->last_used = ++s_use_clock;
+      return;
+    }
+  }
+}
+
+#endif
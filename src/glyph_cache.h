@@ -0,0 +1,18 @@
+#pragma once
+#include <pebble.h>
+#include "glyph_atlas.h"
+
+// glyph bitmaps for platforms built with GLYPH_ATLAS_CELLS. cells are read one
+// at a time from the FONT_*_CELLS raw resources written by tools/atlasgen.py
+// into a store of the budget allocated once by glyph_cache_init, so the heap
+// is not churned as the numerals change. glyphs on screen stay pinned until
+// released, the least recently used of the others are dropped once the cell
+// data held would exceed the budget.
+
+void glyph_cache_init(int budget_bytes);
+void glyph_cache_deinit();
+
+// GBitmapFormat1Bit bitmap of cell `cell` of a size x size cell resource,
+// pinned until released. return NULL if it cannot be loaded.
+GBitmap* glyph_cache_acquire(uint32_t resource_id, int size, int cell);
+void glyph_cache_release(const GBitmap* bitmap);
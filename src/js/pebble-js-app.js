@@ -2,21 +2,171 @@
 
 // -----------------------------------------------------------------------------
 
-function sendToPebble(msg) {
-  Pebble.sendAppMessage(msg,
+// config keys go to the watch only when they differ from what it has acked,
+// "config" holds the latest settings, "configSent" what the watch has.
+// sends are queued one at a time and retried with exponential backoff, keys
+// still unacked after the last retry are sent again on the next save or launch,
+// all of them once the watch reports it has no config.
+
+var SEND_MAX_ATTEMPTS = 5;
+var SEND_RETRY_BASE_MS = 500;
+
+var sendQueue = [];
+var isSending = false;
+var retryTimer = null;
+var sentMessages = 0;
+var sentBytes = 0;
+
+function loadStoredObject(name) {
+  var json = localStorage.getItem(name);
+  return (json === null) ? {} : JSON.parse(json);
+}
+
+function getChangedKeys(config, sentConfig) {
+  var changed = {};
+  var count = 0;
+
+  for (var key in config) {
+    if (config[key] !== sentConfig[key]) {
+      changed[key] = config[key];
+      ++count;
+    }
+  }
+
+  return (count > 0) ? changed : null;
+}
+
+// size on the air: dictionary header, then per tuple 4 byte key, 1 byte type,
+// 2 byte length and the data (cstrings with terminator, numbers as int32)
+function getPayloadBytes(msg) {
+  var bytes = 1;
+  for (var key in msg) {
+    bytes += 7 + ((typeof msg[key] === "string") ? msg[key].length + 1 : 4);
+  }
+  return bytes;
+}
+
+function sendNext() {
+  if (isSending || sendQueue.length === 0)
+    return;
+
+  var item = sendQueue[0];
+  var bytes = getPayloadBytes(item.msg);
+
+  isSending = true;
+  ++item.attempts;
+  ++sentMessages;
+  sentBytes += bytes;
+  console.log("Sending " + Object.keys(item.msg).length + " keys, " + bytes + " bytes, attempt " + item.attempts);
+
+  Pebble.sendAppMessage(item.msg,
     function(e) {
       console.log("Successfully delivered message with transactionId: " + e.data.transactionId);
+
+      var sentConfig = loadStoredObject("configSent");
+      for (var key in item.msg) {
+        sentConfig[key] = item.msg[key];
+      }
+      localStorage.setItem("configSent", JSON.stringify(sentConfig));
+
+      sendQueue.shift();
+      isSending = false;
+
+      if (sendQueue.length === 0) {
+        console.log("Config synced: " + sentMessages + " messages, " + sentBytes + " bytes");
+        sentMessages = 0;
+        sentBytes = 0;
+      }
+      sendNext();
     },
     function(e) {
       console.log("Unable to deliver message with transactionId: " + e.data.transactionId + " Error is: " + e.error.message);
+
+      isSending = false;
+      if (item.attempts >= SEND_MAX_ATTEMPTS) {
+        console.log("Giving up after " + item.attempts + " attempts, keys are resent on the next save");
+        sendQueue.shift();
+        sendNext();
+        return;
+      }
+
+      retryTimer = setTimeout(function() {
+        retryTimer = null;
+        sendNext();
+      }, SEND_RETRY_BASE_MS * Math.pow(2, item.attempts - 1));
     }
   );
 }
 
+function sendToPebble(msg) {
+  // fold into the message waiting in the queue, or for its retry, the newer
+  // values replacing its keys. one on the air is left as it was sent
+  var last = sendQueue[sendQueue.length - 1];
+  if (last && !(isSending && last === sendQueue[0])) {
+    for (var key in msg) {
+      last.msg[key] = msg[key];
+    }
+  }
+  else {
+    sendQueue.push({ msg: msg, attempts: 0 });
+  }
+
+  // a pending retry sends it when its backoff is over
+  if (retryTimer === null) {
+    sendNext();
+  }
+}
+
+function syncConfig() {
+  var config = loadStoredObject("config");
+  var changed = getChangedKeys(config, loadStoredObject("configSent"));
+  if (changed === null) {
+    console.log("Config unchanged, nothing to send");
+    return;
+  }
+
+  console.log("Changed keys: " + JSON.stringify(changed) + ", " + getPayloadBytes(changed) +
+    " bytes instead of " + getPayloadBytes(config) + " for the full config");
+  sendToPebble(changed);
+}
+
+// -----------------------------------------------------------------------------
+
+// with isEnableTelemetry set the watch sends the counters of each day once the
+// day is over, see the telemetry section of pebble-klk.c. the last days are kept
+// by date for the bundled config page to show, and dropped once it is unset.
+
+var TELEMETRY_MAX_DAYS = 30;
+
+function storeTelemetry(payload) {
+  var days = loadStoredObject("telemetry");
+  days[payload.telemetryDate] = {
+    transitions: payload.telemetryTransitions,
+    animMs: payload.telemetryAnimMs,
+    configApplies: payload.telemetryConfigApplies,
+    persistWrites: payload.telemetryPersistWrites,
+    batterySamples: payload.telemetryBatterySamples,
+    chargingSamples: payload.telemetryChargingSamples,
+    batteryFirst: payload.telemetryBatteryFirst,
+    batteryLast: payload.telemetryBatteryLast,
+    batteryMin: payload.telemetryBatteryMin
+  };
+
+  var dates = Object.keys(days).sort();
+  while (dates.length > TELEMETRY_MAX_DAYS) {
+    delete days[dates.shift()];
+  }
+  localStorage.setItem("telemetry", JSON.stringify(days));
+  console.log("Telemetry of " + payload.telemetryDate + " stored, " + dates.length + " days kept");
+}
+
 // -----------------------------------------------------------------------------
 
 Pebble.addEventListener("ready", function(e) {
   console.log("JavaScript app ready and running! payload: " + JSON.stringify(e.payload));
+
+  // finish a sync an earlier session gave up on
+  syncConfig();
 });
 
 // -----------------------------------------------------------------------------
@@ -34,11 +184,21 @@ Pebble.addEventListener("showConfiguration", function(e) {
 
   var watch = Pebble.getActiveWatchInfo ? Pebble.getActiveWatchInfo() : null;
   if(watch) {
-    config.isPebbleColor = (watch.platform === "aplite") ? 0 : 1;
+    config.isPebbleColor = (watch.platform === "aplite" || watch.platform === "diorite") ? 0 : 1;
     config.isAplite = (watch.platform === "aplite") ? 1 : 0;
   }
 
-  if (config) {
+  // CONFIG_PAGE_URI is the page bundled at build time, see tools/configbundle.py
+  if (typeof CONFIG_PAGE_URI !== "undefined") {
+    console.log("stored config: " + JSON.stringify(config));
+
+    // shown on the page only, it is not part of the settings sent back. the
+    // hosted page below never gets it, its query string reaches the server
+    config.telemetry = localStorage.getItem("telemetry") || "{}";
+
+    configUrl = CONFIG_PAGE_URI + "#" + encodeURIComponent(JSON.stringify(config));
+  }
+  else if (config) {
     console.log("stored config: " + JSON.stringify(config));
 
     var params = "";
@@ -58,7 +218,7 @@ Pebble.addEventListener("showConfiguration", function(e) {
     configUrl += params;
   }
 
-  console.log("Opening Url: " + configUrl);
+  console.log("Opening Url: " + ((configUrl.length > 200) ? configUrl.substring(0, 200) + "... (" + configUrl.length + " bytes)" : configUrl));
   Pebble.openURL(configUrl);
 });
 
@@ -70,7 +230,10 @@ Pebble.addEventListener("webviewclosed", function(e) {
 
   if (response.length > 0) {
     localStorage.setItem("config", response);
-    sendToPebble(JSON.parse(response));
+    if (!JSON.parse(response).isEnableTelemetry) {
+      localStorage.removeItem("telemetry");
+    }
+    syncConfig();
   }
 });
 
@@ -78,4 +241,16 @@ Pebble.addEventListener("webviewclosed", function(e) {
 
 Pebble.addEventListener("appmessage", function(e) {
   console.log("AppMessage received! payload: " + JSON.stringify(e.payload));
+
+  if (e.payload.telemetryDate !== undefined && loadStoredObject("config").isEnableTelemetry) {
+    storeTelemetry(e.payload);
+  }
+
+  // the watch has no config at all (reinstalled or cleared), whatever it
+  // acked before is gone and the whole config goes again
+  if (e.payload.configRequest !== undefined) {
+    console.log("Watch has no config, sending all of it");
+    localStorage.removeItem("configSent");
+    syncConfig();
+  }
 });
@@ -0,0 +1,56 @@
+#include "lunar_calendar.h"
+
+// aplite never shows the lunar month names, keep the table out of its memory
+#ifndef PBL_PLATFORM_APLITE
+
+#include "lunar_calendar_table.h"
+
+// days since 1970-01-01 of a proleptic gregorian date
+static int32_t days_from_civil(int year, int month, int mday)
+{
+  year -= (month <= 2) ? 1 : 0;
+  int era = (year >= 0 ? year : year - 399) / 400;
+  int year_of_era = year - era * 400;
+  int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + mday - 1;
+  int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+
+  return era * 146097 + day_of_era - 719468;
+}
+
+bool lunar_calendar_get_month(int year, int month, int mday, int* lunar_month, bool* is_leap)
+{
+  int32_t days = days_from_civil(year, month, mday) - days_from_civil(LUNAR_EPOCH_YEAR, LUNAR_EPOCH_MONTH, LUNAR_EPOCH_MDAY);
+  if (days < 0) return false;
+
+  for (int y = 0; y < LUNAR_YEAR_NUM; ++y)
+  {
+    const uint8_t* entry = s_lunar_years[y];
+    uint32_t packed = entry[0] | (entry[1] << 8) | ((uint32_t)entry[2] << 16);
+    int leap = (packed >> 13) & 0xF;
+    int month_num = (leap > 0) ? 13 : 12;
+
+    for (int i = 0; i < month_num; ++i)
+    {
+      int length = ((packed >> i) & 1) ? 30 : 29;
+      if (days < length)
+      {
+        // months from the leap month on are one index behind their number
+        *lunar_month = (leap > 0 && i >= leap) ? i : i + 1;
+        *is_leap = (leap > 0 && i == leap);
+        return true;
+      }
+      days -= length;
+    }
+  }
+
+  return false;
+}
+
+#else
+
+bool lunar_calendar_get_month(int year, int month, int mday, int* lunar_month, bool* is_leap)
+{
+  return false;
+}
+
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+#include <pebble.h>
+
+// lunisolar month of a gregorian date (month 1-12), from the table generated by
+// tools/lunargen.py, lunar years 1900-2100. lunar_month is 1-12, is_leap is set
+// for a leap month, which carries the number of the month it follows.
+// return false if the date is out of the table.
+bool lunar_calendar_get_month(int year, int month, int mday, int* lunar_month, bool* is_leap);
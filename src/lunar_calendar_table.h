@@ -0,0 +1,216 @@
+// generated by tools/lunargen.py (utc offset 9), do not edit
+#pragma once
+#include <pebble.h>
+
+#define LUNAR_FIRST_YEAR  1900
+#define LUNAR_YEAR_NUM    201
+
+// first day of lunar year LUNAR_FIRST_YEAR
+#define LUNAR_EPOCH_YEAR  1900
+#define LUNAR_EPOCH_MONTH 1
+#define LUNAR_EPOCH_MDAY  31
+
+// bits 0-12 month lengths in order (1 = 30 days), bits 13-16 month the leap month follows
+static const uint8_t s_lunar_years[LUNAR_YEAR_NUM][3] = {
+  { 0xd2, 0x16, 0x01 },   // 1900-01-31
+  { 0x52, 0x07, 0x00 },   // 1901-02-19
+  { 0xa5, 0x0e, 0x00 },   // 1902-02-08
+  { 0x4a, 0xad, 0x00 },   // 1903-01-29
+  { 0x4b, 0x05, 0x00 },   // 1904-02-16
+  { 0x97, 0x0a, 0x00 },   // 1905-02-04
+  { 0x56, 0x95, 0x00 },   // 1906-01-25
+  { 0x5a, 0x05, 0x00 },   // 1907-02-13
+  { 0x55, 0x0b, 0x00 },   // 1908-02-02
+  { 0xd2, 0x56, 0x00 },   // 1909-01-22
+  { 0x52, 0x07, 0x00 },   // 1910-02-10
+  { 0x25, 0xd7, 0x00 },   // 1911-01-30
+  { 0x25, 0x0b, 0x00 },   // 1912-02-18
+  { 0x4b, 0x0a, 0x00 },   // 1913-02-06
+  { 0x9b, 0xb2, 0x00 },   // 1914-01-26
+  { 0xad, 0x0a, 0x00 },   // 1915-02-14
+  { 0x6a, 0x05, 0x00 },   // 1916-02-04
+  { 0x69, 0x4b, 0x00 },   // 1917-01-23
+  { 0xa9, 0x0b, 0x00 },   // 1918-02-11
+  { 0x52, 0xfb, 0x00 },   // 1919-02-01
+  { 0x92, 0x0d, 0x00 },   // 1920-02-20
+  { 0x25, 0x0d, 0x00 },   // 1921-02-08
+  { 0x4d, 0xba, 0x00 },   // 1922-01-28
+  { 0x56, 0x09, 0x00 },   // 1923-02-16
+  { 0xb5, 0x02, 0x00 },   // 1924-02-05
+  { 0xad, 0x95, 0x00 },   // 1925-01-24
+  { 0xd4, 0x06, 0x00 },   // 1926-02-13
+  { 0xa9, 0x0d, 0x00 },   // 1927-02-02
+  { 0x92, 0x5d, 0x00 },   // 1928-01-23
+  { 0x92, 0x0e, 0x00 },   // 1929-02-10
+  { 0x26, 0xcd, 0x00 },   // 1930-01-30
+  { 0x27, 0x05, 0x00 },   // 1931-02-17
+  { 0x57, 0x0a, 0x00 },   // 1932-02-06
+  { 0xb6, 0xb2, 0x00 },   // 1933-01-26
+  { 0xda, 0x0a, 0x00 },   // 1934-02-14
+  { 0xd4, 0x06, 0x00 },   // 1935-02-04
+  { 0xa9, 0x6e, 0x00 },   // 1936-01-24
+  { 0x49, 0x07, 0x00 },   // 1937-02-11
+  { 0x93, 0xf6, 0x00 },   // 1938-01-31
+  { 0x93, 0x0a, 0x00 },   // 1939-02-19
+  { 0x2b, 0x05, 0x00 },   // 1940-02-08
+  { 0x5b, 0xca, 0x00 },   // 1941-01-27
+  { 0x6d, 0x09, 0x00 },   // 1942-02-15
+  { 0x6a, 0x0b, 0x00 },   // 1943-02-05
+  { 0x54, 0x9b, 0x00 },   // 1944-01-26
+  { 0xa4, 0x0b, 0x00 },   // 1945-02-13
+  { 0x49, 0x0b, 0x00 },   // 1946-02-02
+  { 0x93, 0x5a, 0x00 },   // 1947-01-22
+  { 0x95, 0x0a, 0x00 },   // 1948-02-10
+  { 0x2b, 0xf5, 0x00 },   // 1949-01-29
+  { 0x2d, 0x05, 0x00 },   // 1950-02-17
+  { 0xad, 0x0a, 0x00 },   // 1951-02-06
+  { 0x6a, 0xb5, 0x00 },   // 1952-01-27
+  { 0xb2, 0x0d, 0x00 },   // 1953-02-14
+  { 0xa4, 0x0d, 0x00 },   // 1954-02-04
+  { 0x49, 0x7d, 0x00 },   // 1955-01-24
+  { 0x4a, 0x0d, 0x00 },   // 1956-02-12
+  { 0x95, 0x1a, 0x01 },   // 1957-01-31
+  { 0x96, 0x0a, 0x00 },   // 1958-02-19
+  { 0x56, 0x05, 0x00 },   // 1959-02-08
+  { 0xb5, 0xca, 0x00 },   // 1960-01-28
+  { 0xd5, 0x0a, 0x00 },   // 1961-02-15
+  { 0xd2, 0x06, 0x00 },   // 1962-02-05
+  { 0xa5, 0x8e, 0x00 },   // 1963-01-25
+  { 0xa5, 0x0e, 0x00 },   // 1964-02-13
+  { 0x4a, 0x0e, 0x00 },   // 1965-02-02
+  { 0x96, 0x6c, 0x00 },   // 1966-01-22
+  { 0x9b, 0x0a, 0x00 },   // 1967-02-09
+  { 0x56, 0xf5, 0x00 },   // 1968-01-30
+  { 0x6a, 0x05, 0x00 },   // 1969-02-17
+  { 0x59, 0x0b, 0x00 },   // 1970-02-06
+  { 0x52, 0xb7, 0x00 },   // 1971-01-27
+  { 0x52, 0x07, 0x00 },   // 1972-02-15
+  { 0x25, 0x07, 0x00 },   // 1973-02-03
+  { 0x4b, 0x96, 0x00 },   // 1974-01-23
+  { 0x4b, 0x0a, 0x00 },   // 1975-02-11
+  { 0xab, 0x12, 0x01 },   // 1976-01-31
+  { 0xad, 0x02, 0x00 },   // 1977-02-18
+  { 0x6b, 0x05, 0x00 },   // 1978-02-07
+  { 0x69, 0xcb, 0x00 },   // 1979-01-28
+  { 0xa9, 0x0d, 0x00 },   // 1980-02-16
+  { 0x92, 0x0d, 0x00 },   // 1981-02-05
+  { 0x25, 0x9b, 0x00 },   // 1982-01-25
+  { 0x25, 0x0d, 0x00 },   // 1983-02-13
+  { 0x4d, 0x5a, 0x01 },   // 1984-02-02
+  { 0x56, 0x0a, 0x00 },   // 1985-02-20
+  { 0xb6, 0x02, 0x00 },   // 1986-02-09
+  { 0xad, 0xd5, 0x00 },   // 1987-01-29
+  { 0xd4, 0x06, 0x00 },   // 1988-02-18
+  { 0xa9, 0x0d, 0x00 },   // 1989-02-06
+  { 0x92, 0xbd, 0x00 },   // 1990-01-27
+  { 0x92, 0x0e, 0x00 },   // 1991-02-15
+  { 0x26, 0x0d, 0x00 },   // 1992-02-04
+  { 0x56, 0x6a, 0x00 },   // 1993-01-23
+  { 0x57, 0x0a, 0x00 },   // 1994-02-10
+  { 0xb6, 0x12, 0x01 },   // 1995-01-31
+  { 0x5a, 0x0b, 0x00 },   // 1996-02-19
+  { 0xd4, 0x06, 0x00 },   // 1997-02-08
+  { 0xc9, 0xae, 0x00 },   // 1998-01-28
+  { 0x49, 0x07, 0x00 },   // 1999-02-16
+  { 0x93, 0x06, 0x00 },   // 2000-02-05
+  { 0x27, 0x95, 0x00 },   // 2001-01-24
+  { 0x2b, 0x05, 0x00 },   // 2002-02-12
+  { 0x5b, 0x0a, 0x00 },   // 2003-02-01
+  { 0x5a, 0x55, 0x00 },   // 2004-01-22
+  { 0x6a, 0x03, 0x00 },   // 2005-02-09
+  { 0x55, 0xfb, 0x00 },   // 2006-01-29
+  { 0xa4, 0x0b, 0x00 },   // 2007-02-18
+  { 0x49, 0x0b, 0x00 },   // 2008-02-07
+  { 0x93, 0xba, 0x00 },   // 2009-01-26
+  { 0x95, 0x0a, 0x00 },   // 2010-02-14
+  { 0x2d, 0x05, 0x00 },   // 2011-02-03
+  { 0x5d, 0x6a, 0x00 },   // 2012-01-23
+  { 0xad, 0x0a, 0x00 },   // 2013-02-10
+  { 0xaa, 0x35, 0x01 },   // 2014-01-31
+  { 0xd2, 0x05, 0x00 },   // 2015-02-19
+  { 0xa5, 0x0d, 0x00 },   // 2016-02-08
+  { 0x4a, 0xbd, 0x00 },   // 2017-01-28
+  { 0x4a, 0x0d, 0x00 },   // 2018-02-16
+  { 0x95, 0x0a, 0x00 },   // 2019-02-05
+  { 0x2d, 0x95, 0x00 },   // 2020-01-25
+  { 0x56, 0x05, 0x00 },   // 2021-02-12
+  { 0xb5, 0x0a, 0x00 },   // 2022-02-01
+  { 0xaa, 0x55, 0x00 },   // 2023-01-22
+  { 0xd2, 0x06, 0x00 },   // 2024-02-10
+  { 0xa5, 0xce, 0x00 },   // 2025-01-29
+  { 0xa5, 0x0e, 0x00 },   // 2026-02-17
+  { 0x4a, 0x0e, 0x00 },   // 2027-02-07
+  { 0x96, 0xac, 0x00 },   // 2028-01-27
+  { 0x9b, 0x0c, 0x00 },   // 2029-02-13
+  { 0x5a, 0x05, 0x00 },   // 2030-02-03
+  { 0xd5, 0x6a, 0x00 },   // 2031-01-23
+  { 0x69, 0x0b, 0x00 },   // 2032-02-11
+  { 0x52, 0x77, 0x01 },   // 2033-01-31
+  { 0x52, 0x07, 0x00 },   // 2034-02-19
+  { 0x25, 0x0b, 0x00 },   // 2035-02-08
+  { 0x4b, 0xd6, 0x00 },   // 2036-01-28
+  { 0x4b, 0x0a, 0x00 },   // 2037-02-15
+  { 0xab, 0x04, 0x00 },   // 2038-02-04
+  { 0x5b, 0xa5, 0x00 },   // 2039-01-24
+  { 0x6d, 0x05, 0x00 },   // 2040-02-12
+  { 0x69, 0x0b, 0x00 },   // 2041-02-01
+  { 0x52, 0x5b, 0x00 },   // 2042-01-22
+  { 0x92, 0x0d, 0x00 },   // 2043-02-10
+  { 0x25, 0xfd, 0x00 },   // 2044-01-30
+  { 0x25, 0x0d, 0x00 },   // 2045-02-17
+  { 0x4d, 0x0a, 0x00 },   // 2046-02-06
+  { 0xad, 0xb4, 0x00 },   // 2047-01-26
+  { 0xb6, 0x02, 0x00 },   // 2048-02-14
+  { 0xb5, 0x05, 0x00 },   // 2049-02-02
+  { 0xa9, 0x6d, 0x00 },   // 2050-01-23
+  { 0xa9, 0x0e, 0x00 },   // 2051-02-11
+  { 0x92, 0x1d, 0x01 },   // 2052-02-01
+  { 0x92, 0x0e, 0x00 },   // 2053-02-19
+  { 0x26, 0x0d, 0x00 },   // 2054-02-08
+  { 0x56, 0xca, 0x00 },   // 2055-01-28
+  { 0x57, 0x0a, 0x00 },   // 2056-02-15
+  { 0xd6, 0x04, 0x00 },   // 2057-02-04
+  { 0xb5, 0x86, 0x00 },   // 2058-01-24
+  { 0xd5, 0x06, 0x00 },   // 2059-02-12
+  { 0xc9, 0x0e, 0x00 },   // 2060-02-02
+  { 0x92, 0x6e, 0x00 },   // 2061-01-22
+  { 0x93, 0x06, 0x00 },   // 2062-02-09
+  { 0x2b, 0xf5, 0x00 },   // 2063-01-29
+  { 0x2b, 0x05, 0x00 },   // 2064-02-17
+  { 0x5b, 0x0a, 0x00 },   // 2065-02-05
+  { 0x5a, 0xb5, 0x00 },   // 2066-01-26
+  { 0x6a, 0x05, 0x00 },   // 2067-02-14
+  { 0x55, 0x0b, 0x00 },   // 2068-02-03
+  { 0x49, 0x97, 0x00 },   // 2069-01-23
+  { 0x49, 0x0b, 0x00 },   // 2070-02-11
+  { 0x93, 0x1a, 0x01 },   // 2071-01-31
+  { 0x95, 0x0a, 0x00 },   // 2072-02-19
+  { 0x2d, 0x05, 0x00 },   // 2073-02-07
+  { 0xad, 0xca, 0x00 },   // 2074-01-27
+  { 0xb5, 0x0a, 0x00 },   // 2075-02-15
+  { 0xaa, 0x05, 0x00 },   // 2076-02-05
+  { 0xa5, 0x8b, 0x00 },   // 2077-01-24
+  { 0xa5, 0x0d, 0x00 },   // 2078-02-12
+  { 0x4a, 0x0d, 0x00 },   // 2079-02-02
+  { 0x95, 0x7a, 0x00 },   // 2080-01-22
+  { 0x95, 0x0c, 0x00 },   // 2081-02-09
+  { 0x2e, 0xf5, 0x00 },   // 2082-01-29
+  { 0x56, 0x05, 0x00 },   // 2083-02-17
+  { 0xb5, 0x0a, 0x00 },   // 2084-02-06
+  { 0xb2, 0xb5, 0x00 },   // 2085-01-26
+  { 0xd2, 0x06, 0x00 },   // 2086-02-14
+  { 0xa5, 0x0e, 0x00 },   // 2087-02-03
+  { 0x4a, 0x9e, 0x00 },   // 2088-01-24
+  { 0x4a, 0x06, 0x00 },   // 2089-02-11
+  { 0x97, 0x0c, 0x01 },   // 2090-01-30
+  { 0xab, 0x0c, 0x00 },   // 2091-02-18
+  { 0x5a, 0x05, 0x00 },   // 2092-02-08
+  { 0xd5, 0xca, 0x00 },   // 2093-01-27
+  { 0x69, 0x0b, 0x00 },   // 2094-02-15
+  { 0x52, 0x07, 0x00 },   // 2095-02-05
+  { 0xa5, 0x96, 0x00 },   // 2096-01-25
+  { 0x25, 0x0b, 0x00 },   // 2097-02-12
+  { 0x4b, 0x06, 0x00 },   // 2098-02-01
+  { 0x97, 0x74, 0x00 },   // 2099-01-21
+  { 0xab, 0x04, 0x00 },   // 2100-02-09
+};
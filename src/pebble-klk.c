@@ -1,96 +1,88 @@
 #include <pebble.h>
 #include <ctype.h>
+#include <stddef.h>
 #include "gbitmap_color_palette_manipulator.h"
+#include "screen_geometry.h"
+#include "gbitmap_downscale.h"
+#include "profile.h"
+#include "lunar_calendar.h"
+#include "glyph_cache.h"
+#include "glyph_blit.h"
+#include "glyph_atlas.h"
 
 //#define DEBUG
 
-#define NUM_S_SIZE  24
-#define NUM_M_SIZE  36
-#define NUM_L_SIZE  48
-#define NUM_SPAN_SIZE 2
-
-#ifdef PBL_PLATFORM_CHALK
-  #define NUM_OFFSET  6
-  #define NUM_OFFSET_TWO_CHAR   8
-  #define NUM_OFFSET_DATE_MONTH 4
-#else
-  #define NUM_OFFSET  12
-  #define NUM_OFFSET_TWO_CHAR   0
-  #define NUM_OFFSET_DATE_MONTH 0
+// start the transition for the next minute ahead of the boundary, so the new
+// time shows on the boundary itself instead of a quarter transition later
+#ifndef DEBUG
+  #define PREROLL_TRANSITION
 #endif
 
-#ifdef PBL_PLATFORM_APLITE
-  #define ATLAS_NUM_X       16
-  #define ATLAS_NUM_Y_ML    1
-  #define ATLAS_NUM_Y_S     1
-#else
-  #define ATLAS_NUM_X       11
-  #define ATLAS_NUM_Y_ML    3
-  #define ATLAS_NUM_Y_S     5
+// keep a snapshot of the background and time rows and restore it on star
+// transition frames instead of compositing every glyph again. it takes a frame
+// buffer of heap, 3360 bytes on aplite and diorite, so it is off there unless
+// built with --snapshot <platforms>, which defines SCENE_SNAPSHOT.
+// --no-snapshot <platforms> defines NO_SCENE_SNAPSHOT to turn it off anywhere
+#if defined(NO_SCENE_SNAPSHOT)
+  #undef SCENE_SNAPSHOT
+#elif !defined(PBL_PLATFORM_APLITE) && !defined(PBL_PLATFORM_DIORITE)
+  #define SCENE_SNAPSHOT
 #endif
 
+// glyph sizes (NUM_S/M/L_SIZE) and layout offsets come per platform from
+// generated/glyph_atlas.h, see the layouts in resources/glyphs/manifest.json
+
 #define CHAR_MAX_LENGTH   6
-#define NORMAL_NUM_ROW    0
-#define FORMAL_NUM_ROW    1
+#define NUMERAL_MAX_LENGTH  7   // 九千九百九十九
+
+#ifdef GLYPH_ATLAS_CELLS
+  #define GLYPH_CACHE_BUDGET  (GLYPH_ATLAS_RESIDENT_BYTES / 2)   // bytes of cell data
+#endif
 
 #ifdef DEBUG
 static int debug_hour =   1;
 static int debug_min =    11;
 static int debug_date =   31;
 static int debug_month =  11;
+static int debug_year =   2026;
 #endif
 
 // -----------------------------------------------------------------------------
 // atlas setting
 // -----------------------------------------------------------------------------
 
+// cell positions of each glyph are generated from resources/glyphs/manifest.json
+// by tools/atlasgen.py, see generated/glyph_atlas.h
+
 struct CharAtlas {
   int num;                          // character num
-  int atlas[CHAR_MAX_LENGTH][2];    // atlas array({{x,y}, {x,y}, ..})
+  uint8_t glyphs[CHAR_MAX_LENGTH];  // glyph array({GLYPH_*, GLYPH_*, ..})
 };
 
-// 2 時分秒年月日午前後AMPM
-#ifdef PBL_PLATFORM_APLITE
-  static struct CharAtlas s_atlas_hour_suffix =  { 1, { { 11, 0 } } };
-  static struct CharAtlas s_atlas_min_suffix =   { 1, { { 12, 0 } } };
-  static struct CharAtlas s_atlas_sec_suffix =   { 1, { { 13, 0 } } };
-  static struct CharAtlas s_atlas_year_suffix =  { 1, { { 11, 0 } } };
-  static struct CharAtlas s_atlas_month_suffix = { 1, { { 12, 0 } } };
-  static struct CharAtlas s_atlas_date_suffix =  { 1, { { 13, 0 } } };
-  static struct CharAtlas s_atlas_am_suffix =    { 1, { { 14, 0 } } };
-  static struct CharAtlas s_atlas_pm_suffix =    { 1, { { 15, 0 } } };
-#else
-  static struct CharAtlas s_atlas_hour_suffix =  { 1, { { 0, 2 } } };
-  static struct CharAtlas s_atlas_min_suffix =   { 1, { { 1, 2 } } };
-  static struct CharAtlas s_atlas_sec_suffix =   { 1, { { 2, 2 } } };
-  static struct CharAtlas s_atlas_year_suffix =  { 1, { { 3, 2 } } };
-  static struct CharAtlas s_atlas_month_suffix = { 1, { { 4, 2 } } };
-  static struct CharAtlas s_atlas_date_suffix =  { 1, { { 5, 2 } } };
-  static struct CharAtlas s_atlas_am_suffix =    { 1, { { 9, 2 } } };
-  static struct CharAtlas s_atlas_pm_suffix =    { 1, { { 10, 2 } } };
-#endif
-
-// 3 睦如弥生卯皐水無第
-// 4 文葉長神在霜師走月
-static struct CharAtlas s_atlas_lunar[12] = {
-  { 2, { { 0,3 },{ 8,4 } } },           // 睦月
-  { 2, { { 1,3 },{ 8,4 } } },           // 如月
-  { 2, { { 2,3 },{ 3,3 } } },           // 弥生
-  { 2, { { 4,3 },{ 8,4 } } },           // 卯月
-  { 2, { { 5,3 },{ 8,4 } } },           // 皐月
-  { 3, { { 6,3 },{ 7,3 },{ 8,4 } } },   // 水無月
-  { 2, { { 0,4 },{ 8,4 } } },           // 文月
-  { 2, { { 1,4 },{ 8,4 } } },           // 葉月
-  { 2, { { 2,4 },{ 8,4 } } },           // 長月
-  { 3, { { 3,4 },{ 7,3 },{ 8,4 } } },   // 神無月
-  { 2, { { 5,4 },{ 8,4 } } },           // 霜月
-  { 2, { { 6,4 },{ 7,4 } } }            // 師走
+static struct CharAtlas s_atlas_hour_suffix =  { 1, { GLYPH_HOUR } };
+static struct CharAtlas s_atlas_min_suffix =   { 1, { GLYPH_MIN } };
+static struct CharAtlas s_atlas_sec_suffix =   { 1, { GLYPH_SEC } };
+static struct CharAtlas s_atlas_year_suffix =  { 1, { GLYPH_YEAR } };
+static struct CharAtlas s_atlas_month_suffix = { 1, { GLYPH_MONTH } };
+static struct CharAtlas s_atlas_date_suffix =  { 1, { GLYPH_DATE } };
+static struct CharAtlas s_atlas_am_suffix =    { 1, { GLYPH_AM } };
+static struct CharAtlas s_atlas_pm_suffix =    { 1, { GLYPH_PM } };
+
+static const struct CharAtlas s_atlas_lunar[12] = {
+  { 2, { GLYPH_LUNAR_MUTSU, GLYPH_MONTH } },                  // 睦月
+  { 2, { GLYPH_LUNAR_KISA, GLYPH_MONTH } },                   // 如月
+  { 2, { GLYPH_LUNAR_YA, GLYPH_LUNAR_I } },                   // 弥生
+  { 2, { GLYPH_LUNAR_U, GLYPH_MONTH } },                      // 卯月
+  { 2, { GLYPH_LUNAR_SATSU, GLYPH_MONTH } },                  // 皐月
+  { 3, { GLYPH_LUNAR_MI, GLYPH_LUNAR_NA, GLYPH_MONTH } },     // 水無月
+  { 2, { GLYPH_LUNAR_FUMI, GLYPH_MONTH } },                   // 文月
+  { 2, { GLYPH_LUNAR_HA, GLYPH_MONTH } },                     // 葉月
+  { 2, { GLYPH_LUNAR_NAGA, GLYPH_MONTH } },                   // 長月
+  { 3, { GLYPH_LUNAR_KAN, GLYPH_LUNAR_NA, GLYPH_MONTH } },    // 神無月
+  { 2, { GLYPH_LUNAR_SHIMO, GLYPH_MONTH } },                  // 霜月
+  { 2, { GLYPH_LUNAR_SHI, GLYPH_LUNAR_WASU } }                // 師走
 };
-#ifdef PBL_PLATFORM_APLITE
-  static struct CharAtlas s_atlas_prefix = { 1, { { 14,0 } } };
-#else
-  static struct CharAtlas s_atlas_prefix = { 1, { { 8,3 } } };
-#endif
+static const struct CharAtlas s_atlas_prefix = { 1, { GLYPH_PREFIX } };
 
 // -----------------------------------------------------------------------------
 // config
@@ -98,7 +90,9 @@ static struct CharAtlas s_atlas_lunar[12] = {
 
 enum PersistKey
 {
-  PERSIST_CONFIG = 0
+  PERSIST_CONFIG = 0,
+  PERSIST_TELEMETRY,          // counters of the current day
+  PERSIST_TELEMETRY_UNSENT    // a finished day the companion has not received
 };
 
 enum MessageKey
@@ -114,7 +108,25 @@ enum MessageKey
   MSG_CONFIG_IS_USE_LUNAR,
   MSG_CONFIG_IS_USE_PREFIX,
   MSG_CONFIG_IS_USE_FORMAL,
-  MSG_CONFIG_DATE_POSITION_TYPE
+  MSG_CONFIG_DATE_POSITION_TYPE,
+  MSG_CONFIG_IS_ENABLE_YEAR,
+
+  // watch to phone, one message per finished day, see send_telemetry
+  MSG_TELEMETRY_DATE,
+  MSG_TELEMETRY_TRANSITIONS,
+  MSG_TELEMETRY_ANIM_MS,
+  MSG_TELEMETRY_CONFIG_APPLIES,
+  MSG_TELEMETRY_PERSIST_WRITES,
+  MSG_TELEMETRY_BATTERY_SAMPLES,
+  MSG_TELEMETRY_CHARGING_SAMPLES,
+  MSG_TELEMETRY_BATTERY_FIRST,
+  MSG_TELEMETRY_BATTERY_LAST,
+  MSG_TELEMETRY_BATTERY_MIN,
+
+  // watch to phone, the watch has no config and needs all of it
+  MSG_CONFIG_REQUEST,
+
+  MSG_CONFIG_IS_ENABLE_TELEMETRY
 };
 
 enum DatePositionType
@@ -139,10 +151,36 @@ struct ConfigData
   bool is_use_prefix;
   bool is_use_formal;
   enum DatePositionType date_position_type;
+  bool is_enable_year;      // added later, older saved configs end before it
+  bool is_enable_telemetry; // in what was padding after is_enable_year, zero in older saves
 };
 
 static struct ConfigData config_data;
 
+// nothing persisted, the companion is asked for the whole config, see
+// send_config_request. it only sends what it thinks the watch lacks
+static bool is_config_missing = false;
+
+// counters of a day on the watch, for correlating battery drain with the
+// transitions and theme changes. counted in every build, kept and sent only
+// with is_enable_telemetry, see the telemetry section
+struct TelemetryData
+{
+  int32_t date;               // yyyymmdd, local time
+  uint32_t persist_time;      // utc seconds of the last write
+  uint32_t anim_ms;           // time stepping and drawing star transitions
+  uint16_t transitions;
+  uint16_t config_applies;
+  uint16_t persist_writes;    // config saves and telemetry writes
+  uint16_t battery_samples;
+  uint16_t charging_samples;
+  uint8_t battery_first;      // charge percent
+  uint8_t battery_last;
+  uint8_t battery_min;
+};
+
+static struct TelemetryData telemetry;
+
 // -----------------------------------------------------------------------------
 
 static void init_config()
@@ -155,6 +193,8 @@ static void init_config()
 
   config_data.is_enable_date = true;
   config_data.is_enable_month = false;
+  config_data.is_enable_year = false;
+  config_data.is_enable_telemetry = false;
   config_data.date_position_type = DATE_POSITION_TOP;
 
 #ifdef PBL_PLATFORM_APLITE
@@ -173,10 +213,16 @@ static void init_config()
   {
     int config_size = sizeof(config_data);
     int persist_size = persist_get_size(PERSIST_CONFIG);
+    if (persist_size == (int)offsetof(struct ConfigData, is_enable_year))
+    {
+      // older config, the new fields keep their defaults
+      config_size = persist_size;
+    }
     if (persist_size != config_size)
     {
       APP_LOG(APP_LOG_LEVEL_WARNING, "config data size not match! need (%d), load (%d). discard config!", config_size, persist_size);
       persist_delete(PERSIST_CONFIG);
+      is_config_missing = true;
       return;
     }
 
@@ -186,9 +232,17 @@ static void init_config()
   else
   {
     APP_LOG(APP_LOG_LEVEL_INFO, "config not exist, inited.");
+    is_config_missing = true;
   }
 }
 
+// every write and delete wears the flash alike
+static void count_persist_write()
+{
+  PROFILE_ADD(PROFILE_PERSIST_WRITES, 1);
+  ++telemetry.persist_writes;
+}
+
 static void save_config()
 {
   int config_size = sizeof(config_data);
@@ -199,6 +253,8 @@ static void save_config()
   }
 
   persist_write_data(PERSIST_CONFIG, &config_data, config_size);
+  is_config_missing = false;
+  count_persist_write();
   APP_LOG(APP_LOG_LEVEL_INFO, "config saved.");
 }
 
@@ -207,16 +263,44 @@ static void save_config()
 // -----------------------------------------------------------------------------
 
 static Window* window;
+static Layer* star_layer;
 
-static GBitmap* font_s_bitmap_date = NULL;
-static GBitmap* font_s_bitmap_month = NULL;
-static GBitmap* font_m_bitmap = NULL;
-static GBitmap* font_l_bitmap = NULL;
+enum FontType
+{
+  FONT_S_DATE = 0,
+  FONT_S_MONTH,
+  FONT_M,
+  FONT_L,
+  FONT_NUM
+};
 
+// loaded on first use and kept until the window unloads, see get_font_bitmap
+static GBitmap* font_bitmaps[FONT_NUM];
+
+// created on first use, see create_row_layers
 static BitmapLayer* hour_layers[CHAR_MAX_LENGTH];
 static BitmapLayer* min_layers[CHAR_MAX_LENGTH];
 static BitmapLayer* month_layers[CHAR_MAX_LENGTH];
 static BitmapLayer* date_layers[CHAR_MAX_LENGTH];
+static BitmapLayer* year_layers[CHAR_MAX_LENGTH];
+static GCompOp time_comp_mode = GCompOpAssign;
+
+// holds the row layers, or glyph_layer, below the stars
+static Layer* rows_layer;
+
+#ifdef GLYPH_BLIT
+// draws the glyphs of every row, see glyph_layer_update_callback
+static Layer* glyph_layer;
+#endif
+
+#ifdef SCENE_SNAPSHOT
+// the frame as drawn up to the stars, see scene_layer_update_callback
+static Layer* scene_layer;
+static uint8_t* scene_snapshot = NULL;
+static size_t scene_snapshot_size = 0;
+static bool is_scene_snapshot_valid = false;
+static bool is_scene_snapshot_failed = false;   // no heap for it, the rows composite as before
+#endif
 
 static int window_width, window_height;
 
@@ -257,6 +341,22 @@ int current_hr = -1;
 int current_min = -1;
 int current_date = -1;
 int current_month = -1;
+int current_year = -1;
+int current_lunar_month = -1;
+
+// month index (0-11) of the lunisolar calendar, computed when the date changes.
+// leap months have no 閏 glyph and show the name of the month they repeat
+static int calculate_lunar_month(int year, int month, int date)
+{
+#ifndef PBL_PLATFORM_APLITE
+  int lunar_month;
+  bool is_leap;
+  if (lunar_calendar_get_month(year, month + 1, date, &lunar_month, &is_leap)) return lunar_month - 1;
+#endif
+
+  // out of the table, keep the gregorian month
+  return month;
+}
 
 static int format_hr(int hr, int min, bool is_24h)
 {
@@ -273,36 +373,41 @@ static int format_hr(int hr, int min, bool is_24h)
   return result;
 }
 
-static int calculate_digits(int value, int* result_digits)
-{
-  int digit_num = 0;
+// japanese numerals, digit indexes 0-9 are the digits, 10-12 the place glyphs
+// 十, 百, 千 (拾, 佰, 仟 in formal), one is left out before a place glyph.
+// each entry holds up to two indexes, high nibble first, NUMERAL_NONE if unused
+#define NUMERAL_NONE  0xF
 
-  int in_ones = value % 10;
-  int in_tens = value / 10;
+static const uint8_t s_numeral_places[4][10] = {
+  { 0xFF, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9 },   // ones
+  { 0xFF, 0xFA, 0x2A, 0x3A, 0x4A, 0x5A, 0x6A, 0x7A, 0x8A, 0x9A },   // tens
+  { 0xFF, 0xFB, 0x2B, 0x3B, 0x4B, 0x5B, 0x6B, 0x7B, 0x8B, 0x9B },   // hundreds
+  { 0xFF, 0xFC, 0x2C, 0x3C, 0x4C, 0x5C, 0x6C, 0x7C, 0x8C, 0x9C },   // thousands
+};
 
-  if (in_tens > 1 && in_ones > 0)
-  {
-    digit_num = 3;
-    result_digits[0] = in_tens;
-    result_digits[1] = 10;
-    result_digits[2] = in_ones;
-  }
-  else if (value > 10)
+// value in 0-9999, result_digits needs NUMERAL_MAX_LENGTH entries
+static int calculate_digits(int value, int* result_digits)
+{
+  if (value <= 0)
   {
-    digit_num = 2;
-    result_digits[0] = in_tens >= 2 ? in_tens : 10;
-    result_digits[1] = in_tens >= 2 ? 10 : in_ones;
+    result_digits[0] = 0;
+    return 1;
   }
-  else
+
+  int digit_num = 0;
+  int place_digits[4] = { value / 1000 % 10, value / 100 % 10, value / 10 % 10, value % 10 };
+
+  for (int i = 0; i < 4; ++i)
   {
-    digit_num = 1;
-    result_digits[0] = in_tens > 0 ? 10 : in_ones;
+    uint8_t entry = s_numeral_places[3 - i][place_digits[i]];
+    if ((entry >> 4) != NUMERAL_NONE) result_digits[digit_num++] = entry >> 4;
+    if ((entry & 0xF) != NUMERAL_NONE) result_digits[digit_num++] = entry & 0xF;
   }
 
   return digit_num;
 }
 
-static int append_atlas(struct CharAtlas* dest_atlas, struct CharAtlas* src_atlas, int start_index)
+static int append_atlas(struct CharAtlas* dest_atlas, const struct CharAtlas* src_atlas, int start_index)
 {
   if (dest_atlas == NULL) return start_index;
   if (src_atlas == NULL) return start_index;
@@ -311,8 +416,7 @@ static int append_atlas(struct CharAtlas* dest_atlas, struct CharAtlas* src_atla
   for (int i = 0; i < src_atlas->num; i++)
   {
     if (index >= CHAR_MAX_LENGTH) break;
-    dest_atlas->atlas[index][0] = src_atlas->atlas[i][0];
-    dest_atlas->atlas[index][1] = src_atlas->atlas[i][1];
+    dest_atlas->glyphs[index] = src_atlas->glyphs[i];
     dest_atlas->num = index+1;
     index++;
   }
@@ -325,13 +429,13 @@ static bool get_num_atlas(struct CharAtlas* atlas, int value, bool is_use_formal
 {
   if (atlas == NULL) return false;
 
-  int digit_idxs[CHAR_MAX_LENGTH];
-  int row = (is_use_formal) ? FORMAL_NUM_ROW : NORMAL_NUM_ROW;
+  int digit_idxs[NUMERAL_MAX_LENGTH];
+  int glyph_base = (is_use_formal) ? GLYPH_FORMAL_0 : GLYPH_NUM_0;
 
   atlas->num = calculate_digits(value, digit_idxs);
+  if (atlas->num > CHAR_MAX_LENGTH) atlas->num = CHAR_MAX_LENGTH;
   for (int i=0; i<atlas->num; i++) {
-    atlas->atlas[i][0] = digit_idxs[i];
-    atlas->atlas[i][1] = row;
+    atlas->glyphs[i] = glyph_base + digit_idxs[i];
   }
 
   return true;
@@ -344,8 +448,7 @@ static bool get_lunar_atlas(struct CharAtlas* atlas, int value)
 
   atlas->num = s_atlas_lunar[value].num;
   for (int i=0; i<atlas->num; i++) {
-    atlas->atlas[i][0] = s_atlas_lunar[value].atlas[i][0];
-    atlas->atlas[i][1] = s_atlas_lunar[value].atlas[i][1];
+    atlas->glyphs[i] = s_atlas_lunar[value].glyphs[i];
   }
 
   return true;
@@ -409,6 +512,20 @@ static void get_date_atlas(struct CharAtlas* atlas, int date, bool is_use_prefix
   index = append_atlas(atlas, &s_atlas_date_suffix, index);
 }
 
+static void get_year_atlas(struct CharAtlas* atlas, int year, bool is_use_formal)
+{
+  if (atlas == NULL) return;
+
+  int index = 0;
+  struct CharAtlas atlas_num;
+
+  // years up to 2099 fit, ones like 2222 (二千二百二十二) lose the suffix
+  get_num_atlas(&atlas_num, year, is_use_formal);
+  index = append_atlas(atlas, &atlas_num, index);
+
+  index = append_atlas(atlas, &s_atlas_year_suffix, index);
+}
+
 static void get_month_atlas(struct CharAtlas* atlas, int month, bool is_use_lunar, bool is_use_prefix, bool is_use_formal)
 {
   if (atlas == NULL) return;
@@ -434,413 +551,1596 @@ static void get_month_atlas(struct CharAtlas* atlas, int month, bool is_use_luna
 }
 
 // -----------------------------------------------------------------------------
-// time rendering
+// font
 // -----------------------------------------------------------------------------
 
-static void apply_bitmap_atlas(BitmapLayer* bitmap_layer, GBitmap* bitmap, int unit, int idx_x, int idx_y, int num_x, int num_y)
+#ifndef GLYPH_ATLAS_CELLS
+#ifdef PBL_COLOR
+#define FONT_PALETTE_MAX_SIZE 16
+
+// palettes as loaded. theme changes recolor from these in place, so the atlases
+// are not freed and reloaded at other sizes and addresses on every config save
+static GColor font_palettes[FONT_NUM][FONT_PALETTE_MAX_SIZE];
+// glyph color each font has now
+static GColor font_colors[FONT_NUM];
+
+static void save_font_palette(enum FontType type)
 {
-  bitmap_layer_set_bitmap(bitmap_layer, bitmap);
+  int palette_size = get_num_palette_colors(font_bitmaps[type]);
+  if (palette_size > 0) memcpy(font_palettes[type], gbitmap_get_palette(font_bitmaps[type]), sizeof(GColor) * palette_size);
+}
 
-  int bound_origin_x = -idx_x * unit;
-  int bound_origin_y = -idx_y * unit;
-#ifdef PBL_PLATFORM_APLITE
-  // bound_origin_x /= 2; // why need to divide 2?
-  // bound_origin_y /= 2; // why need to divide 2?
+static void restore_font_palette(enum FontType type)
+{
+  int palette_size = get_num_palette_colors(font_bitmaps[type]);
+  memcpy(gbitmap_get_palette(font_bitmaps[type]), font_palettes[type], sizeof(GColor) * palette_size);
+}
 #endif
 
-  layer_set_bounds(bitmap_layer_get_layer(bitmap_layer), GRect(bound_origin_x, bound_origin_y, num_x * unit, num_y * unit));
+// the atlas background is transparent (see tools/atlasgen.py) and the window
+// background shows through it, only the white glyph entry is recolored
+static void set_color(GBitmap* image, GColor color){
+  if(image == NULL) return;
+
+#ifdef PBL_COLOR
+  GColor lut[GCOLOR_LUT_SIZE];
+  gcolor_lut_init_identity(lut);
+  gcolor_lut_set(lut, GColorWhite, color);
+  remap_gbitmap_colors(lut, image, NULL);
+#endif
 }
 
-static void render_atlas(BitmapLayer** bitmap_layers, GBitmap* bitmap, struct CharAtlas* atlas, int size, int top, int left, int num_x, int num_y)
+#ifdef GLYPH_ATLAS_DERIVED
+// a smaller font scaled down a cell at a time from the loaded master, or from
+// its own image for the glyphs the master lacks. scaling reads palette indices,
+// which recoloring leaves alone, and the cells take the master's palette as
+// loaded, so the master may be recolored already
+static GBitmap* create_derived_font_bitmap(const struct GlyphAtlasInfo* atlas_info, const struct GlyphAtlasInfo* source_info, uint32_t resource_id)
 {
-  if (bitmap_layers == NULL) return;
-  if (bitmap == NULL) return;
-  if (atlas == NULL) return;
+  GBitmap* master = font_bitmaps[FONT_L];
+  if (master == NULL) return NULL;
 
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "render atlas: %d", atlas->num);
-  for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
+  GSize size = GSize(atlas_info->num_x * atlas_info->size, atlas_info->num_y * atlas_info->size);
+  GBitmap* bitmap = gbitmap_create_blank_like(master, size, PBL_IF_COLOR_ELSE(font_palettes[FONT_L], NULL));
+  if (bitmap == NULL) return NULL;
+
+  GBitmap* source = NULL;
+  for (int glyph = 0; glyph < GLYPH_NUM; ++glyph)
   {
-    Layer* layer = bitmap_layer_get_layer(bitmap_layers[i]);
+    int cell = atlas_info->cells[glyph];
+    if (cell == GLYPH_NONE) continue;
 
-    if (i < atlas->num)
+    GBitmap* from = master;
+    const struct GlyphAtlasInfo* from_info = &s_glyph_atlas_l;
+    if (source_info->cells[glyph] != GLYPH_NONE)
     {
-      APP_LOG(APP_LOG_LEVEL_DEBUG, "render: %d (%d,%d)", i, atlas->atlas[i][0], atlas->atlas[i][1]);
-
-      apply_bitmap_atlas(bitmap_layers[i], bitmap, size, atlas->atlas[i][0], atlas->atlas[i][1], num_x, num_y);
-      layer_set_frame(layer, GRect(left + size * i, top, size, size));
-      layer_set_hidden(layer, false);
+      if (source == NULL) source = gbitmap_create_with_resource(resource_id);
+      from = source;
+      from_info = source_info;
     }
-    else
+
+    int from_cell = from_info->cells[glyph];
+    GRect from_rect = GRect(from_cell % from_info->num_x * from_info->size, from_cell / from_info->num_x * from_info->size,
+                            from_info->size, from_info->size);
+    GPoint origin = GPoint(cell % atlas_info->num_x * atlas_info->size, cell / atlas_info->num_x * atlas_info->size);
+    if (from_cell == GLYPH_NONE || !gbitmap_downscale_rect(bitmap, origin, from, from_rect, atlas_info->size, from_info->size))
     {
-      layer_set_hidden(layer, true);
+      APP_LOG(APP_LOG_LEVEL_ERROR, "cannot derive glyph %d at %d px", glyph, atlas_info->size);
     }
   }
+
+  if (source) gbitmap_destroy(source);
+  return bitmap;
 }
+#endif
 
-static void refresh_time()
+static GBitmap* create_font_bitmap(enum FontType type)
 {
-  struct CharAtlas atlas_hour;
-  struct CharAtlas atlas_min;
-  struct CharAtlas atlas_date;
-  struct CharAtlas atlas_month;
+  switch (type)
+  {
+  case FONT_L:
+    return gbitmap_create_with_resource(RESOURCE_ID_FONT_48);
 
-  // make atlas
+#ifdef GLYPH_ATLAS_DERIVED
+  case FONT_M:
+    return create_derived_font_bitmap(&s_glyph_atlas_m, &s_glyph_atlas_m_source, RESOURCE_ID_FONT_36);
 
-  get_hour_atlas(&atlas_hour, current_hr, current_min, clock_is_24h_style(), config_data.is_use_ampm, config_data.is_use_formal);
-  if (current_min > 0)
-    get_min_atlas(&atlas_min, current_min, config_data.is_use_formal);
-  else
-    atlas_min.num = 0;          // if 0 min, hide it
+  default:
+    return create_derived_font_bitmap(&s_glyph_atlas_s, &s_glyph_atlas_s_source, RESOURCE_ID_FONT_24);
+#else
+  case FONT_M:
+    return gbitmap_create_with_resource(RESOURCE_ID_FONT_36);
 
-  int hr_size = NUM_M_SIZE;
-  GBitmap* hr_font_bitmap = font_m_bitmap;
-  if (atlas_hour.num <= 3)
-  {
-    hr_size = NUM_L_SIZE;
-    hr_font_bitmap = font_l_bitmap;
+  default:
+    return gbitmap_create_with_resource(RESOURCE_ID_FONT_24);
+#endif
   }
-  int hr_left = (window_width - (atlas_hour.num * hr_size)) / 2;
+}
 
-  int min_size = NUM_M_SIZE;
-  GBitmap* min_font_bitmap = font_m_bitmap;
-  if (atlas_min.num <= 3)
+static GColor get_font_color(enum FontType type)
+{
+  switch (type)
   {
-    min_size = NUM_L_SIZE;
-    min_font_bitmap = font_l_bitmap;
+  case FONT_S_DATE:   return config_data.date_color;
+  case FONT_S_MONTH:  return config_data.month_color;
+  default:            return config_data.time_color;
   }
-  int min_left = (window_width - (atlas_min.num  * min_size)) / 2;
-
-  int min_size_y = (atlas_min.num == 0) ? 0 : min_size;       // tm_min == 0
-  int hr_top = (window_height - (hr_size + min_size_y)) / 2;
-  int min_top = hr_top + hr_size;
+}
 
-  int date_size = NUM_S_SIZE;
-  int date_top = 0;
-  int date_left = 0;
-  GBitmap* date_font_bitmap = font_s_bitmap_date;
-  if (config_data.is_enable_date)
+#ifdef PROFILE
+static int get_fonts_resident_bytes()
+{
+  int bytes = 0;
+  for (int i = 0; i < FONT_NUM; ++i)
   {
-    bool is_use_prefix = (config_data.is_use_prefix && (!config_data.is_enable_month || config_data.date_position_type == DATE_POSITION_TOP));
-    get_date_atlas(&atlas_date, current_date, is_use_prefix, config_data.is_use_formal);
-
-    date_top = (config_data.date_position_type == DATE_POSITION_TOP) ? hr_top - (date_size + NUM_SPAN_SIZE) : min_top + (min_size_y + NUM_SPAN_SIZE);
-    date_left = (window_width - (atlas_date.num * date_size)) / 2;
-  }
-  else {
-    for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
-    {
-      layer_set_hidden(bitmap_layer_get_layer(date_layers[i]), true);
-    }
+    if (font_bitmaps[i]) bytes += gbitmap_get_bytes_per_row(font_bitmaps[i]) * gbitmap_get_bounds(font_bitmaps[i]).size.h;
   }
+  return bytes;
+}
+#endif
+#endif
 
-  int month_size = NUM_S_SIZE;
-  int month_top = 0;
-  int month_left = 0;
-  GBitmap* month_font_bitmap = font_s_bitmap_month;
-  if (config_data.is_enable_month)
-  {
-    bool is_use_prefix = (config_data.is_use_prefix && (!config_data.is_enable_date || config_data.date_position_type == DATE_POSITION_BOTTOM));
-    get_month_atlas(&atlas_month, current_month, config_data.is_use_lunar, is_use_prefix, config_data.is_use_formal);
+// load and recolor a font the first time a row needs it, so startup only pays
+// for the rows on screen
+static GBitmap* get_font_bitmap(enum FontType type)
+{
+#ifdef GLYPH_ATLAS_CELLS
+  // no atlases, rows take their glyphs from the glyph cache
+  return NULL;
+#else
+#ifdef PBL_PLATFORM_APLITE
+  // aplite shares one small font between date and month
+  if (type == FONT_S_MONTH) type = FONT_S_DATE;
+#endif
 
-    month_top = (config_data.date_position_type != DATE_POSITION_TOP) ? hr_top - (month_size + NUM_SPAN_SIZE) : min_top + (min_size_y + NUM_SPAN_SIZE);
-    month_left = (window_width - (atlas_month.num * month_size)) / 2;
-  }
-  else {
-    for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
-    {
-      layer_set_hidden(bitmap_layer_get_layer(month_layers[i]), true);
-    }
-  }
+  if (font_bitmaps[type]) return font_bitmaps[type];
 
-  // calc offset
+#ifdef GLYPH_ATLAS_DERIVED
+  // the smaller fonts are scaled down from the master, loaded first
+  if (type != FONT_L && get_font_bitmap(FONT_L) == NULL) return NULL;
+#endif
 
-  int offset = 0;
-  if (config_data.is_enable_date && !config_data.is_enable_month)
-  {
-    if (config_data.date_position_type == DATE_POSITION_TOP)
-    {
-      offset = NUM_OFFSET + ((atlas_min.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0);
-    }
-    else
-    {
-      offset = -(NUM_OFFSET + ((atlas_hour.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0));
-    }
-  }
-  if (!config_data.is_enable_date && config_data.is_enable_month)
-  {
-    if (config_data.date_position_type == DATE_POSITION_TOP)
-    {
-      offset = -(NUM_OFFSET + ((atlas_hour.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0));
-    }
-    else
-    {
-      offset = NUM_OFFSET + ((atlas_min.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0);
-    }
-  }
-  if (config_data.is_enable_date && config_data.is_enable_month)
-  {
-    if (config_data.date_position_type == DATE_POSITION_TOP)
-    {
-      if      (atlas_date.num < atlas_month.num) offset = -NUM_OFFSET_DATE_MONTH;
-      else if (atlas_date.num > atlas_month.num) offset =  NUM_OFFSET_DATE_MONTH;
-    }
-    else
-    {
-      if      (atlas_date.num < atlas_month.num) offset =  NUM_OFFSET_DATE_MONTH;
-      else if (atlas_date.num > atlas_month.num) offset = -NUM_OFFSET_DATE_MONTH;
-    }
-  }
+  PROFILE_TIME_BEGIN(font_load);
+  PROFILE_HEAP_BEGIN(font_load);
 
-  // render
+  font_bitmaps[type] = create_font_bitmap(type);
+  if (font_bitmaps[type] == NULL) return NULL;
+#ifdef PBL_COLOR
+  save_font_palette(type);
+  font_colors[type] = get_font_color(type);
+#endif
 
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "window: (%d, %d)", window_width, window_height);
+  PROFILE_TIME_BEGIN(recolor);
+  set_color(font_bitmaps[type], get_font_color(type));
+  PROFILE_TIME_END(recolor, PROFILE_RECOLOR_MS);
 
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "hour: %d, size=%d, top=%d, left=%d", current_hr, hr_size, hr_top, hr_left);
-  render_atlas(hour_layers, hr_font_bitmap, &atlas_hour, hr_size, hr_top + offset, hr_left, ATLAS_NUM_X, ATLAS_NUM_Y_ML);
+  PROFILE_HEAP_END(font_load, PROFILE_FONT_HEAP_BYTES);
+  PROFILE_TIME_END(font_load, PROFILE_FONT_LOAD_MS);
+  PROFILE_ADD(PROFILE_FONT_LOADS, 1);
+  PROFILE_MAX(PROFILE_FONT_RESIDENT_BYTES, get_fonts_resident_bytes());
 
-  APP_LOG(APP_LOG_LEVEL_DEBUG, "min: %d, size=%d, top=%d, left=%d", current_min, min_size_y, min_top, min_left);
-  render_atlas(min_layers, min_font_bitmap, &atlas_min, min_size_y, min_top + offset, min_left, ATLAS_NUM_X, ATLAS_NUM_Y_ML);
+  return font_bitmaps[type];
+#endif
+}
 
-  if (config_data.is_enable_date)
+// recolor the loaded fonts for a new theme, a new background alone changes none
+static void recolor_font_bitmaps()
+{
+#ifndef GLYPH_ATLAS_CELLS
+  PROFILE_TIME_BEGIN(recolor);
+  for (int i = 0; i < FONT_NUM; ++i)
   {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "date: %d, size=%d, top=%d, left=%d", current_date, date_size, date_top, date_left);
-    render_atlas(date_layers, date_font_bitmap, &atlas_date, date_size, date_top + offset, date_left, ATLAS_NUM_X, ATLAS_NUM_Y_S);
-  }
+    if (font_bitmaps[i] == NULL) continue;
 
-  if (config_data.is_enable_month)
-  {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "month: %d, size=%d, top=%d, left=%d", current_month, month_size, month_top, month_left);
-    render_atlas(month_layers, month_font_bitmap, &atlas_month, month_size, month_top + offset, month_left, ATLAS_NUM_X, ATLAS_NUM_Y_S);
+#ifdef PBL_COLOR
+    if (get_num_palette_colors(font_bitmaps[i]) <= 0)
+    {
+      // pixels recolored in place cannot be told apart any more
+      gbitmap_destroy(font_bitmaps[i]);
+      font_bitmaps[i] = NULL;
+      continue;
+    }
+    if (gcolor_equal(font_colors[i], get_font_color(i))) continue;
+
+    restore_font_palette(i);
+    font_colors[i] = get_font_color(i);
+#endif
+    set_color(font_bitmaps[i], get_font_color(i));
   }
+  PROFILE_TIME_END(recolor, PROFILE_RECOLOR_MS);
+#endif
 }
 
-// -----------------------------------------------------------------------------
-// star
-// -----------------------------------------------------------------------------
-
-#define STAR_TRANSITION_PERIOD 1.6f
-#define STAR_HALF_SIZE 5.f
-#define SCALE_SPEED 10.f
-#define MAX_SCALE 6.f
-#define SPAWN_PERIOD 0.02f
-
-static Layer* star_layer;
-static GPath* star_path;
-
-static GPathInfo base_star_path_info =
+static void destroy_font_bitmaps()
 {
-  // This is the amount of points
-  8,
-  // A path can be concave, but it should not twist on itself
-  // The points should be defined in clockwise order due to the rendering
-  // implementation. Counter-clockwise will work in older firmwares, but
-  // it is not officially supported
-  (GPoint [])
+  for (int i = 0; i < FONT_NUM; ++i)
   {
-    { 0, -STAR_HALF_SIZE },
-    { 1,              -1 },
-    { STAR_HALF_SIZE,  0 },
-    { 1,               1 },
-    { 0,  STAR_HALF_SIZE },
-    { -1,              1 },
-    { -STAR_HALF_SIZE, 0 },
-    { -1,             -1 }
+    if (font_bitmaps[i]) gbitmap_destroy(font_bitmaps[i]);
+    font_bitmaps[i] = NULL;
   }
-};
+}
 
-static GPathInfo curr_star_path_info;
+// -----------------------------------------------------------------------------
+// time rendering
+// -----------------------------------------------------------------------------
 
-static void ApplyPathBaseToCurrent(float scale)
+#ifdef GLYPH_ATLAS_CELLS
+static uint32_t get_cells_resource(int size)
 {
-  for (unsigned int i = 0; i < base_star_path_info.num_points; ++i)
+  switch (size)
   {
-    curr_star_path_info.points[i].x = base_star_path_info.points[i].x * scale;
-    curr_star_path_info.points[i].y = base_star_path_info.points[i].y * scale;
+  case NUM_L_SIZE:  return RESOURCE_ID_FONT_48_CELLS;
+  case NUM_M_SIZE:  return RESOURCE_ID_FONT_36_CELLS;
+  default:          return RESOURCE_ID_FONT_24_CELLS;
   }
 }
 
-// -----------------------------------------------------------------------------
-
-#define START_POOL_SIZE 16
-
-typedef struct
+// unpin the glyph a layer shows, hidden layers hold none
+static void release_layer_glyph(BitmapLayer* bitmap_layer)
 {
-  float scale;
-  GPoint pos;
-  bool in_use;
-} StarInfo;
+  const GBitmap* bitmap = bitmap_layer_get_bitmap(bitmap_layer);
+  if (bitmap == NULL) return;
 
-static StarInfo star_pool[START_POOL_SIZE];
+  bitmap_layer_set_bitmap(bitmap_layer, NULL);
+  glyph_cache_release(bitmap);
+}
+#endif
 
-static void spawn_star()
+static bool apply_bitmap_atlas(BitmapLayer* bitmap_layer, GBitmap* bitmap, const struct GlyphAtlasInfo* atlas_info, int glyph)
 {
-  StarInfo* star = NULL;
-  for (int i = 0; i < START_POOL_SIZE; ++i)
-  {
-    if (!star_pool[i].in_use)
-    {
-      star = &star_pool[i];
-      break;
-    }
-  }
+  int cell = atlas_info->cells[glyph];
+  if (cell == GLYPH_NONE) return false;
 
-  if (star)
-  {
-    star->scale = 1.f;
+#ifdef GLYPH_ATLAS_CELLS
+  // acquired before the old glyph is released, so one still on screen stays cached
+  GBitmap* glyph_bitmap = glyph_cache_acquire(get_cells_resource(atlas_info->size), atlas_info->size, cell);
+  if (glyph_bitmap == NULL) return false;
 
-    float border = MAX_SCALE * STAR_HALF_SIZE;
-    star->pos.x = range_random(border, window_width - border);
-    star->pos.y = range_random(border, window_height - border);
+  release_layer_glyph(bitmap_layer);
+  bitmap_layer_set_bitmap(bitmap_layer, glyph_bitmap);
+  layer_set_bounds(bitmap_layer_get_layer(bitmap_layer), GRect(0, 0, atlas_info->size, atlas_info->size));
+  return true;
+#else
+  if (bitmap == NULL) return false;
 
-    star->in_use = true;
-  }
-  else
-  {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "No usable star in pool");
-  }
-}
+  bitmap_layer_set_bitmap(bitmap_layer, bitmap);
 
-// -----------------------------------------------------------------------------
+  int unit = atlas_info->size;
+  int bound_origin_x = -(cell % atlas_info->num_x) * unit;
+  int bound_origin_y = -(cell / atlas_info->num_x) * unit;
 
-static bool need_refresh_time = false;
+  layer_set_bounds(bitmap_layer_get_layer(bitmap_layer), GRect(bound_origin_x, bound_origin_y, atlas_info->num_x * unit, atlas_info->num_y * unit));
+  return true;
+#endif
+}
 
-static AnimationImplementation anim_impl;
-static Animation* anim = NULL;
+// rows that were never shown have no layers, they go in rows_layer
+static void create_row_layers(BitmapLayer** bitmap_layers)
+{
+  GRect rect = GRect(0, 0, NUM_M_SIZE, NUM_M_SIZE);
+  for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
+  {
+    bitmap_layers[i] = bitmap_layer_create(rect);
+    bitmap_layer_set_compositing_mode(bitmap_layers[i], time_comp_mode);
 
-static float prev_ratio, max_spawn_ratio, spawn_timer;
-static bool time_refreshed;
+    Layer* layer = bitmap_layer_get_layer(bitmap_layers[i]);
+#ifndef GLYPH_BLIT
+    layer_add_child(rows_layer, layer);
+#endif
+    layer_set_hidden(layer, true);
+  }
+}
 
-static void anim_setup(struct Animation* animation)
+// row layers redraw by themselves, unless glyph_layer draws them. either way
+// the scene snapshot is stale, the rows show again until it is retaken
+static void mark_glyphs_dirty()
 {
-  prev_ratio = 0.f;
-  max_spawn_ratio = (STAR_TRANSITION_PERIOD - ((MAX_SCALE - 1.f) / SCALE_SPEED)) / STAR_TRANSITION_PERIOD;
-  spawn_timer = 0.f;
-  time_refreshed = false;
+#ifdef GLYPH_BLIT
+  if (glyph_layer) layer_mark_dirty(glyph_layer);
+#endif
+#ifdef SCENE_SNAPSHOT
+  is_scene_snapshot_valid = false;
+  if (rows_layer) layer_set_hidden(rows_layer, false);
+#endif
 }
 
-static void anim_update(struct Animation* animation, const AnimationProgress time_normalized)
+static void render_atlas(BitmapLayer** bitmap_layers, GBitmap* bitmap, const struct GlyphAtlasInfo* atlas_info, struct CharAtlas* atlas, int size, int top, int left)
 {
-  float ratio = (float)time_normalized / ANIMATION_NORMALIZED_MAX;
-  float delta_time = (ratio - prev_ratio) * STAR_TRANSITION_PERIOD;
-  prev_ratio = ratio;
+  if (bitmap_layers == NULL) return;
+  if (atlas_info == NULL) return;
+  if (atlas == NULL) return;
 
-  if (need_refresh_time && !time_refreshed && ratio >= 0.25f) // refresh time in transition
+  if (bitmap_layers[0] == NULL)
   {
-    refresh_time();
-
-    time_refreshed = true;
-    need_refresh_time = false;
+    if (atlas->num <= 0) return;
+    create_row_layers(bitmap_layers);
   }
 
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "render atlas: %d", atlas->num);
+  for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
+  {
+    Layer* layer = bitmap_layer_get_layer(bitmap_layers[i]);
+
+    if (i < atlas->num && apply_bitmap_atlas(bitmap_layers[i], bitmap, atlas_info, atlas->glyphs[i]))
+    {
+      APP_LOG(APP_LOG_LEVEL_DEBUG, "render: %d (%d)", i, atlas->glyphs[i]);
+
+      layer_set_frame(layer, GRect(left + size * i, top, size, size));
+      layer_set_hidden(layer, false);
+      PROFILE_ADD(PROFILE_LAYER_MUTATIONS, 1);
+      PROFILE_ADD(PROFILE_PIXELS_TOUCHED, size * size);
+    }
+    else
+    {
+      if (!layer_get_hidden(layer))
+      {
+        PROFILE_ADD(PROFILE_LAYER_MUTATIONS, 1);
+      }
+      layer_set_hidden(layer, true);
+#ifdef GLYPH_ATLAS_CELLS
+      release_layer_glyph(bitmap_layers[i]);
+#endif
+    }
+  }
+
+  mark_glyphs_dirty();
+}
+
+enum RowType
+{
+  ROW_HOUR = 0,
+  ROW_MIN,
+  ROW_DATE,
+  ROW_MONTH,
+  ROW_YEAR,
+  ROW_NUM
+};
+
+struct RowLayout
+{
+  struct CharAtlas atlas;   // atlas.num == 0 if row is hidden
+  GBitmap* bitmap;
+  int size;
+  int top;
+  int left;
+  const struct GlyphAtlasInfo* atlas_info;
+};
+
+struct TimeLayout
+{
+  struct RowLayout rows[ROW_NUM];
+};
+
+static BitmapLayer** row_layers[ROW_NUM] = { hour_layers, min_layers, date_layers, month_layers, year_layers };
+
+#if defined(GLYPH_BLIT) || defined(PROFILE)
+#define GLYPH_MAX_NUM (ROW_NUM * CHAR_MAX_LENGTH)
+
+// bitmap, top left in the bitmap and frame on screen of each glyph shown
+static int get_visible_glyphs(const GBitmap** bitmaps, GPoint* origins, GRect* frames)
+{
+  int num = 0;
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+    {
+      Layer* layer = bitmap_layer_get_layer(row_layers[i][j]);
+      const GBitmap* bitmap = bitmap_layer_get_bitmap(row_layers[i][j]);
+      if (layer_get_hidden(layer) || bitmap == NULL) continue;
+
+      GRect bounds = layer_get_bounds(layer);
+      bitmaps[num] = bitmap;
+      origins[num] = GPoint(-bounds.origin.x, -bounds.origin.y);
+      frames[num] = layer_get_frame(layer);
+      ++num;
+    }
+  }
+  return num;
+}
+#endif
+
+#ifdef GLYPH_BLIT
+// the row layers are left out of the layer tree and only hold each glyph's
+// bitmap, frame and atlas offset. this draws them all into the frame buffer
+// in one pass instead of compositing a layer per glyph
+static void glyph_layer_update_callback(Layer* me, GContext* ctx)
+{
+  PROFILE_TIME_BEGIN(glyph_draw);
+
+  const GBitmap* bitmaps[GLYPH_MAX_NUM];
+  GPoint origins[GLYPH_MAX_NUM];
+  GRect frames[GLYPH_MAX_NUM];
+  int num = get_visible_glyphs(bitmaps, origins, frames);
+
+  // the frame buffer already captured, nothing is drawn but the time is counted
+  GBitmap* frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer)
+  {
+    for (int i = 0; i < num; ++i)
+    {
+      if (!glyph_blit(frame_buffer, bitmaps[i], origins[i], frames[i], time_comp_mode))
+        APP_LOG(APP_LOG_LEVEL_ERROR, "glyph blit: unsupported bitmap format %d", (int)gbitmap_get_format(bitmaps[i]));
+    }
+
+    graphics_release_frame_buffer(ctx, frame_buffer);
+  }
+
+  PROFILE_TIME_END(glyph_draw, PROFILE_GLYPH_DRAW_MS);
+  PROFILE_TIME_END(glyph_draw, PROFILE_AWAKE_MS);
+}
+#endif
+
+#ifdef SCENE_SNAPSHOT
+static size_t get_frame_buffer_size(GBitmap* frame_buffer)
+{
+#ifdef PBL_ROUND
+  // rows are packed, each as long as the circle is wide there
+  GBitmapDataRowInfo last_row = gbitmap_get_data_row_info(frame_buffer, gbitmap_get_bounds(frame_buffer).size.h - 1);
+  return last_row.data + last_row.max_x + 1 - gbitmap_get_data(frame_buffer);
+#else
+  return gbitmap_get_bytes_per_row(frame_buffer) * gbitmap_get_bounds(frame_buffer).size.h;
+#endif
+}
+
+#endif
+
+#ifdef PROFILE
+// the firmware's compositing, as each BitmapLayer gets it, against glyph_blit
+// and the scene snapshot restore over the glyphs of the first frame
+static void bench_glyph_draw(GContext* ctx)
+{
+  const GBitmap* bitmaps[GLYPH_MAX_NUM];
+  GPoint origins[GLYPH_MAX_NUM];
+  GRect frames[GLYPH_MAX_NUM];
+  GBitmap* glyphs[GLYPH_MAX_NUM];
+  int num = get_visible_glyphs(bitmaps, origins, frames);
+
+  for (int i = 0; i < num; ++i)
+    glyphs[i] = gbitmap_create_as_sub_bitmap(bitmaps[i], (GRect) { origins[i], frames[i].size });
+
+  graphics_context_set_compositing_mode(ctx, time_comp_mode);
+  PROFILE_BENCH("glyph_draw_bitmap", 20,
+    for (int i = 0; i < num; ++i) graphics_draw_bitmap_in_rect(ctx, glyphs[i], frames[i]));
+  PROFILE_BENCH("glyph_blit", 20,
+    GBitmap* frame_buffer = graphics_capture_frame_buffer(ctx);
+    for (int i = 0; i < num; ++i) glyph_blit(frame_buffer, bitmaps[i], origins[i], frames[i], time_comp_mode);
+    graphics_release_frame_buffer(ctx, frame_buffer));
+#ifdef SCENE_SNAPSHOT
+  {
+    GBitmap* frame_buffer = graphics_capture_frame_buffer(ctx);
+    size_t size = get_frame_buffer_size(frame_buffer);
+    uint8_t* snapshot = malloc(size);
+    if (snapshot)
+    {
+      // the frame's own pixels, restoring them leaves it as drawn
+      memcpy(snapshot, gbitmap_get_data(frame_buffer), size);
+      PROFILE_BENCH("snapshot_restore", 20, memcpy(gbitmap_get_data(frame_buffer), snapshot, size));
+      free(snapshot);
+    }
+    graphics_release_frame_buffer(ctx, frame_buffer);
+  }
+#endif
+  APP_LOG(APP_LOG_LEVEL_INFO, "glyph draw bench: %d glyphs", num);
+
+  for (int i = 0; i < num; ++i)
+    gbitmap_destroy(glyphs[i]);
+}
+#endif
+
+#ifdef PBL_ROUND
+// pixels of the widest row side that fall outside the visible circle, a row
+// off the top or bottom of the screen counts whole
+static int get_rows_overflow(struct TimeLayout* layout, int width, int height, int offset)
+{
+  int overflow = 0;
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    struct RowLayout* row = &layout->rows[i];
+    if (row->atlas.num <= 0) continue;
+
+    int left = (width - row->atlas.num * row->size) / 2;
+    if (row->top + offset < 0 || row->top + offset + row->size > height)
+    {
+      overflow += width - left;
+      continue;
+    }
+    int inset = screen_geometry_get_row_inset(row->top + offset, row->size);
+    if (inset > left) overflow += inset - left;
+  }
+
+  return overflow;
+}
+
+// offset closest to the vertically centered block that keeps rows inside the circle
+static int get_round_offset(struct TimeLayout* layout, int width, int height)
+{
+  int block_top = height;
+  int block_bottom = 0;
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    struct RowLayout* row = &layout->rows[i];
+    if (row->atlas.num <= 0) continue;
+    if (row->top < block_top) block_top = row->top;
+    if (row->top + row->size > block_bottom) block_bottom = row->top + row->size;
+  }
+  if (block_top >= block_bottom) return 0;
+
+  int centered = (height - (block_top + block_bottom)) / 2;
+  int best_offset = centered;
+  int best_overflow = get_rows_overflow(layout, width, height, centered);
+
+  for (int d = ROUND_OFFSET_SEARCH_STEP; d <= height / 4 && best_overflow > 0; d += ROUND_OFFSET_SEARCH_STEP)
+  {
+    for (int sign = -1; sign <= 1; sign += 2)
+    {
+      int overflow = get_rows_overflow(layout, width, height, centered + sign * d);
+      if (overflow < best_overflow)
+      {
+        best_overflow = overflow;
+        best_offset = centered + sign * d;
+      }
+    }
+  }
+
+  return best_offset;
+}
+#endif
+
+static void calculate_layout(struct TimeLayout* layout, int width, int height)
+{
+  struct RowLayout* hour = &layout->rows[ROW_HOUR];
+  struct RowLayout* min = &layout->rows[ROW_MIN];
+  struct RowLayout* date = &layout->rows[ROW_DATE];
+  struct RowLayout* month = &layout->rows[ROW_MONTH];
+  struct RowLayout* year = &layout->rows[ROW_YEAR];
+
+  // make atlas
+
+  get_hour_atlas(&hour->atlas, current_hr, current_min, clock_is_24h_style(), config_data.is_use_ampm, config_data.is_use_formal);
+  if (current_min > 0)
+    get_min_atlas(&min->atlas, current_min, config_data.is_use_formal);
+  else
+    min->atlas.num = 0;         // if 0 min, hide it
+
+  hour->size = NUM_M_SIZE;
+  hour->atlas_info = &s_glyph_atlas_m;
+  if (hour->atlas.num <= 3)
+  {
+    hour->size = NUM_L_SIZE;
+    hour->atlas_info = &s_glyph_atlas_l;
+  }
+  hour->bitmap = get_font_bitmap((hour->size == NUM_L_SIZE) ? FONT_L : FONT_M);
+  hour->left = (width - (hour->atlas.num * hour->size)) / 2;
+
+  min->size = NUM_M_SIZE;
+  min->atlas_info = &s_glyph_atlas_m;
+  if (min->atlas.num <= 3)
+  {
+    min->size = NUM_L_SIZE;
+    min->atlas_info = &s_glyph_atlas_l;
+  }
+  min->bitmap = (min->atlas.num > 0) ? get_font_bitmap((min->size == NUM_L_SIZE) ? FONT_L : FONT_M) : NULL;
+  min->left = (width - (min->atlas.num * min->size)) / 2;
+
+  if (min->atlas.num == 0) min->size = 0;   // tm_min == 0
+  hour->top = (height - (hour->size + min->size)) / 2;
+  min->top = hour->top + hour->size;
+
+  // drop year/month/date rows that do not fit, e.g. while a timeline peek covers the screen
+
+  bool is_show_date = config_data.is_enable_date;
+  bool is_show_month = config_data.is_enable_month;
+  bool is_show_year = config_data.is_enable_year;
+  int row_height = NUM_S_SIZE + NUM_SPAN_SIZE;
+  int block_height = hour->size + min->size;
+  if (is_show_year && block_height + (1 + is_show_date + is_show_month) * row_height > height) is_show_year = false;
+  if (is_show_month && block_height + (is_show_date ? 2 : 1) * row_height > height) is_show_month = false;
+  if (is_show_date && block_height + row_height > height) is_show_date = false;
+
+  date->size = NUM_S_SIZE;
+  date->bitmap = NULL;
+  date->atlas_info = &s_glyph_atlas_s;
+  date->atlas.num = 0;
+  date->top = 0;
+  date->left = 0;
+  if (is_show_date)
+  {
+    bool is_use_prefix = (config_data.is_use_prefix && (!is_show_month || config_data.date_position_type == DATE_POSITION_TOP));
+    get_date_atlas(&date->atlas, current_date, is_use_prefix, config_data.is_use_formal);
+    date->bitmap = get_font_bitmap(FONT_S_DATE);
+
+    date->top = (config_data.date_position_type == DATE_POSITION_TOP) ? hour->top - (date->size + NUM_SPAN_SIZE) : min->top + (min->size + NUM_SPAN_SIZE);
+    date->left = (width - (date->atlas.num * date->size)) / 2;
+  }
+
+  month->size = NUM_S_SIZE;
+  month->bitmap = NULL;
+  month->atlas_info = &s_glyph_atlas_s;
+  month->atlas.num = 0;
+  month->top = 0;
+  month->left = 0;
+  if (is_show_month)
+  {
+    bool is_use_prefix = (config_data.is_use_prefix && (!is_show_date || config_data.date_position_type == DATE_POSITION_BOTTOM));
+    get_month_atlas(&month->atlas, config_data.is_use_lunar ? current_lunar_month : current_month, config_data.is_use_lunar, is_use_prefix, config_data.is_use_formal);
+    month->bitmap = get_font_bitmap(FONT_S_MONTH);
+
+    month->top = (config_data.date_position_type != DATE_POSITION_TOP) ? hour->top - (month->size + NUM_SPAN_SIZE) : min->top + (min->size + NUM_SPAN_SIZE);
+    month->left = (width - (month->atlas.num * month->size)) / 2;
+  }
+
+  // year sits on the date side, past the date row if shown
+
+  year->size = NUM_S_SIZE;
+  year->bitmap = NULL;
+  year->atlas_info = &s_glyph_atlas_s;
+  year->atlas.num = 0;
+  year->top = 0;
+  year->left = 0;
+  if (is_show_year)
+  {
+    get_year_atlas(&year->atlas, current_year, config_data.is_use_formal);
+    year->bitmap = get_font_bitmap(FONT_S_DATE);
+
+    int rows_before = is_show_date ? 2 : 1;
+    year->top = (config_data.date_position_type == DATE_POSITION_TOP) ? hour->top - rows_before * (year->size + NUM_SPAN_SIZE) : min->top + min->size + (rows_before - 1) * (year->size + NUM_SPAN_SIZE) + NUM_SPAN_SIZE;
+    year->left = (width - (year->atlas.num * year->size)) / 2;
+  }
+
+  // calc offset
+
+  int offset = 0;
+#ifdef PBL_ROUND
+  offset = get_round_offset(layout, width, height);
+#else
+  if (is_show_date && !is_show_month)
+  {
+    if (config_data.date_position_type == DATE_POSITION_TOP)
+    {
+      offset = NUM_OFFSET + ((min->atlas.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0);
+    }
+    else
+    {
+      offset = -(NUM_OFFSET + ((hour->atlas.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0));
+    }
+  }
+  if (!is_show_date && is_show_month)
+  {
+    if (config_data.date_position_type == DATE_POSITION_TOP)
+    {
+      offset = -(NUM_OFFSET + ((hour->atlas.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0));
+    }
+    else
+    {
+      offset = NUM_OFFSET + ((min->atlas.num <= 2) ? NUM_OFFSET_TWO_CHAR : 0);
+    }
+  }
+  if (is_show_date && is_show_month)
+  {
+    if (config_data.date_position_type == DATE_POSITION_TOP)
+    {
+      if      (date->atlas.num < month->atlas.num) offset = -NUM_OFFSET_DATE_MONTH;
+      else if (date->atlas.num > month->atlas.num) offset =  NUM_OFFSET_DATE_MONTH;
+    }
+    else
+    {
+      if      (date->atlas.num < month->atlas.num) offset =  NUM_OFFSET_DATE_MONTH;
+      else if (date->atlas.num > month->atlas.num) offset = -NUM_OFFSET_DATE_MONTH;
+    }
+  }
+  if (is_show_year)
+  {
+    // half a row away from the date side
+    offset += (config_data.date_position_type == DATE_POSITION_TOP) ? NUM_OFFSET : -NUM_OFFSET;
+  }
+#endif
+
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    layout->rows[i].top += offset;
+  }
+}
+
+static void apply_layout(struct TimeLayout* layout)
+{
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "window: (%d, %d)", window_width, window_height);
+
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    struct RowLayout* row = &layout->rows[i];
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "row %d: size=%d, top=%d, left=%d", i, row->size, row->top, row->left);
+    render_atlas(row_layers[i], row->bitmap, row->atlas_info, &row->atlas, row->size, row->top, row->left);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// unobstructed area
+// -----------------------------------------------------------------------------
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+static struct TimeLayout current_layout;
+static struct TimeLayout peek_from_layout, peek_to_layout;
+static int peek_to_height;
+static AnimationProgress peek_progress;
+static bool is_unobstructed_area_changing = false;
+
+// layouts are computed once per peek and per minute during it, frames are
+// only interpolated per frame
+static void start_peek_layout(const struct TimeLayout* from)
+{
+  peek_from_layout = *from;
+  calculate_layout(&peek_to_layout, window_width, peek_to_height);
+
+  // rows that will not fit are hidden up front
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    if (peek_to_layout.rows[i].atlas.num != peek_from_layout.rows[i].atlas.num)
+    {
+      for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+        layer_set_hidden(bitmap_layer_get_layer(row_layers[i][j]), true);
+      PROFILE_ADD(PROFILE_LAYER_MUTATIONS, peek_from_layout.rows[i].atlas.num);
+
+      peek_from_layout.rows[i].atlas.num = 0;
+    }
+  }
+  mark_glyphs_dirty();
+}
+
+static void place_peek_rows(AnimationProgress progress)
+{
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    struct RowLayout* from = &peek_from_layout.rows[i];
+    struct RowLayout* to = &peek_to_layout.rows[i];
+    if (from->atlas.num == 0) continue;
+
+    int top = from->top + (to->top - from->top) * (int)progress / ANIMATION_NORMALIZED_MAX;
+    int left = from->left + (to->left - from->left) * (int)progress / ANIMATION_NORMALIZED_MAX;
+    for (int j = 0; j < from->atlas.num; ++j)
+    {
+      layer_set_frame(bitmap_layer_get_layer(row_layers[i][j]), GRect(left + from->size * j, top, from->size, from->size));
+    }
+    PROFILE_ADD(PROFILE_LAYER_MUTATIONS, from->atlas.num);
+  }
+  mark_glyphs_dirty();
+}
+#endif
+
+static void refresh_time()
+{
+  PROFILE_TIME_BEGIN(refresh_time);
+
+  struct TimeLayout layout;
+  calculate_layout(&layout, window_width, window_height);
+  apply_layout(&layout);
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  current_layout = layout;
+  if (is_unobstructed_area_changing)
+  {
+    // time changed during the peek animation: the new glyphs go where the
+    // animation has got to, and the rows the peek hid stay hidden
+    start_peek_layout(&layout);
+    place_peek_rows(peek_progress);
+  }
+#endif
+
+  PROFILE_TIME_END(refresh_time, PROFILE_REFRESH_TIME_MS);
+  PROFILE_ADD(PROFILE_REFRESH_TIME, 1);
+}
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+static void unobstructed_will_change(GRect final_unobstructed_screen_area, void *context)
+{
+  peek_to_height = final_unobstructed_screen_area.size.h;
+  peek_progress = 0;
+  is_unobstructed_area_changing = true;
+  start_peek_layout(&current_layout);
+}
+
+static void unobstructed_change(AnimationProgress progress, void *context)
+{
+  if (!is_unobstructed_area_changing) return;
+
+  peek_progress = progress;
+  place_peek_rows(progress);
+}
+
+static void unobstructed_did_change(void *context)
+{
+  is_unobstructed_area_changing = false;
+
+  GRect unobstructed_bounds = layer_get_unobstructed_bounds(window_get_root_layer(window));
+  window_height = unobstructed_bounds.size.h;
+  screen_geometry_init(PBL_IF_ROUND_ELSE(layer_get_bounds(window_get_root_layer(window)), unobstructed_bounds));
+
+  refresh_time();
+}
+#endif
+
+// -----------------------------------------------------------------------------
+// star
+// -----------------------------------------------------------------------------
+
+#define STAR_TRANSITION_PERIOD 1.6f
+#define STAR_HALF_SIZE 5.f
+#define SCALE_SPEED 10.f
+#define MAX_SCALE 6.f
+#define SPAWN_PERIOD 0.033f   // the rate 30 fps frames used to cap it at, a star lives 0.5 s in a pool of 16
+#define SPAWN_RETRY_NUM 4
+#define STAR_POINT_NUM 8
+
+// transition frame rate cap, frames arriving before the next one is due are
+// skipped and their time carries over. frames are due every ANIM_FRAME_TIME
+// from the start, not that long after the last one: the firmware's 30 fps
+// frames are 33 ms apart, a hair under 1/30 s, and a cap on the time since the
+// last frame stepped only every other one. ANIM_FRAME_SLACK absorbs jitter
+#ifdef PBL_PLATFORM_APLITE
+  #define ANIM_MAX_FPS  20
+#else
+  #define ANIM_MAX_FPS  30
+#endif
+#define ANIM_FRAME_TIME   (1.f / ANIM_MAX_FPS)
+#define ANIM_FRAME_SLACK  (ANIM_FRAME_TIME / 4)
+
+static GPath* star_path = NULL;
+
+static GPathInfo base_star_path_info =
+{
+  // This is the amount of points
+  STAR_POINT_NUM,
+  // A path can be concave, but it should not twist on itself
+  // The points should be defined in clockwise order due to the rendering
+  // implementation. Counter-clockwise will work in older firmwares, but
+  // it is not officially supported
+  (GPoint [])
+  {
+    { 0, -STAR_HALF_SIZE },
+    { 1,              -1 },
+    { STAR_HALF_SIZE,  0 },
+    { 1,               1 },
+    { 0,  STAR_HALF_SIZE },
+    { -1,              1 },
+    { -STAR_HALF_SIZE, 0 },
+    { -1,             -1 }
+  }
+};
+
+static GPoint curr_star_points[STAR_POINT_NUM];
+static GPathInfo curr_star_path_info = { STAR_POINT_NUM, curr_star_points };
+
+static void ApplyPathBaseToCurrent(float scale)
+{
+  for (unsigned int i = 0; i < base_star_path_info.num_points; ++i)
+  {
+    curr_star_path_info.points[i].x = base_star_path_info.points[i].x * scale;
+    curr_star_path_info.points[i].y = base_star_path_info.points[i].y * scale;
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+#define START_POOL_SIZE 16
+
+typedef struct
+{
+  float scale;
+  GPoint pos;
+  bool in_use;
+} StarInfo;
+
+static StarInfo star_pool[START_POOL_SIZE];
+
+// age: seconds since the star should have appeared, when catching up on a late frame
+static bool spawn_star(float age)
+{
+  StarInfo* star = NULL;
+  for (int i = 0; i < START_POOL_SIZE; ++i)
+  {
+    if (!star_pool[i].in_use)
+    {
+      star = &star_pool[i];
+      break;
+    }
+  }
+
+  if (star)
+  {
+    star->scale = 1.f + age * SCALE_SPEED;
+
+    int border = MAX_SCALE * STAR_HALF_SIZE;
+    int min_x = border;
+    int max_x = window_width - border;
+    int y = window_height / 2;
+    bool is_span_found = false;
+    for (int retry = 0; retry < SPAWN_RETRY_NUM && !is_span_found; ++retry)
+    {
+      int try_y = range_random(border, window_height - border);
+      if (screen_geometry_get_spawn_span(try_y, border, &min_x, &max_x))
+      {
+        y = try_y;
+        is_span_found = true;
+      }
+    }
+    if (!is_span_found)
+    {
+      // fall back to the center row
+      screen_geometry_get_spawn_span(y, border, &min_x, &max_x);
+    }
+
+    star->pos.x = range_random(min_x, max_x);
+    star->pos.y = y;
+
+    star->in_use = true;
+    return true;
+  }
+
+  APP_LOG(APP_LOG_LEVEL_DEBUG, "No usable star in pool");
+  return false;
+}
+
+// size in pixels, frames that change no star's pixel size draw nothing new
+static int get_star_pixel_size(float scale)
+{
+  return (int)(scale * STAR_HALF_SIZE);
+}
+
+#ifdef PROFILE
+// pixels of the square a star is drawn in
+static int get_star_box_pixels(float scale)
+{
+  int side = 2 * get_star_pixel_size(scale) + 1;
+  return side * side;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+
+// minute ticks and config messages both ask for a transition. one asked for
+// while another plays joins it if its refresh point is still ahead, otherwise
+// a single transition follows for all of them
+enum TransitionState
+{
+  TRANSITION_IDLE = 0,
+  TRANSITION_RUNNING,
+  TRANSITION_PENDING,   // running, another one follows
+};
+
+enum TransitionChange
+{
+  TRANSITION_CHANGE_NONE = 0,
+  TRANSITION_CHANGE_TIME = 1 << 0,
+  TRANSITION_CHANGE_THEME = 1 << 1,
+};
+
+#define TRANSITION_REFRESH_RATIO 0.25f   // changes show this far into the transition
+
+static enum TransitionState transition_state = TRANSITION_IDLE;
+static int pending_changes = TRANSITION_CHANGE_NONE;
+static uint32_t time_boundary_ms;   // minute boundary of a pending time change
+static AppTimer* transition_timer = NULL;
+
+static AnimationImplementation anim_impl;
+static Animation* anim = NULL;
+
+static float prev_ratio, next_frame_time, max_spawn_ratio, spawn_timer;
+static bool changes_applied;
+
+static void refresh_color_theme();
+
+static void apply_transition_changes()
+{
+#ifdef PROFILE
+  if (pending_changes & TRANSITION_CHANGE_TIME)
+  {
+    int latency_ms = (int)(profile_time_ms() - time_boundary_ms);
+    PROFILE_ADD(PROFILE_TIME_CHANGES, 1);
+    PROFILE_ADD(PROFILE_TIME_LATENCY_MS, latency_ms);
+    PROFILE_MAX(PROFILE_TIME_LATENCY_MAX_MS, latency_ms);
+  }
+#endif
+
+  if (pending_changes & TRANSITION_CHANGE_THEME)
+    refresh_color_theme();    // the time is refreshed with it
+  else if (pending_changes & TRANSITION_CHANGE_TIME)
+    refresh_time();
+
+  pending_changes = TRANSITION_CHANGE_NONE;
+}
+
+static void anim_setup(struct Animation* animation)
+{
+  prev_ratio = 0.f;
+  next_frame_time = 0.f;
+  max_spawn_ratio = (STAR_TRANSITION_PERIOD - ((MAX_SCALE - 1.f) / SCALE_SPEED)) / STAR_TRANSITION_PERIOD;
+  spawn_timer = 0.f;
+  changes_applied = false;
+
+  PROFILE_ADD(PROFILE_TRANSITIONS, 1);
+  ++telemetry.transitions;
+}
+
+static void anim_update(struct Animation* animation, const AnimationProgress time_normalized)
+{
+  float ratio = (float)time_normalized / ANIMATION_NORMALIZED_MAX;
+  float delta_time = (ratio - prev_ratio) * STAR_TRANSITION_PERIOD;
+  float time = ratio * STAR_TRANSITION_PERIOD;
+
+  if (time < next_frame_time - ANIM_FRAME_SLACK && time_normalized < ANIMATION_NORMALIZED_MAX)
+  {
+    PROFILE_ADD(PROFILE_FRAMES_SKIPPED, 1);
+    return;
+  }
+  prev_ratio = ratio;
+
+  // a frame a whole frame late starts the schedule over, the next ones do not
+  // bunch up to catch up
+  next_frame_time += ANIM_FRAME_TIME;
+  if (next_frame_time < time) next_frame_time = time + ANIM_FRAME_TIME;
+
+  uint32_t start_ms = profile_time_ms();
+  PROFILE_TIME_BEGIN(anim_update);
+  PROFILE_ADD(PROFILE_ANIM_FRAMES, 1);
+
+  bool is_changed = false;
+
+  if (!changes_applied && ratio >= TRANSITION_REFRESH_RATIO)
+  {
+    apply_transition_changes();
+    changes_applied = true;
+  }
+
+#ifdef SCENE_SNAPSHOT
+  // the rows are restored from the snapshot from the next frame on
+  if (is_scene_snapshot_valid && !layer_get_hidden(rows_layer))
+  {
+    layer_set_hidden(rows_layer, true);
+  }
+#endif
+
+  // advance by the elapsed time, stars keep their speed however late the frame is
+  for (int i = 0; i < START_POOL_SIZE; ++i)
+  {
+    if (star_pool[i].in_use)
+    {
+      int prev_size = get_star_pixel_size(star_pool[i].scale);
+      star_pool[i].scale += delta_time * SCALE_SPEED;
+      if (star_pool[i].scale > MAX_SCALE)
+        star_pool[i].in_use = false;
+
+      if (!star_pool[i].in_use || get_star_pixel_size(star_pool[i].scale) != prev_size)
+        is_changed = true;
+    }
+  }
+
+  // catch up on every spawn since the last frame, skipping stars already gone
   if (ratio < max_spawn_ratio)
   {
     spawn_timer -= delta_time;
-    if (spawn_timer <= 0.f)
+    while (spawn_timer <= 0.f)
+    {
+      float age = -spawn_timer;
+      if (1.f + age * SCALE_SPEED <= MAX_SCALE && spawn_star(age))
+        is_changed = true;
+      spawn_timer += SPAWN_PERIOD;
+    }
+  }
+
+  if (is_changed)
+  {
+    layer_mark_dirty(star_layer);
+  }
+  else
+  {
+    PROFILE_ADD(PROFILE_FRAMES_UNCHANGED, 1);
+  }
+
+  PROFILE_TIME_END(anim_update, PROFILE_ANIM_MS);
+  PROFILE_TIME_END(anim_update, PROFILE_AWAKE_MS);
+  telemetry.anim_ms += profile_time_ms() - start_ms;
+}
+
+static void start_pending_transition(void* data);
+
+static void anim_teardown(struct Animation* animation)
+{
+  for (int i = 0; i < START_POOL_SIZE; ++i)
+    star_pool[i].in_use = false;
+
+  layer_mark_dirty(star_layer);
+#ifdef SCENE_SNAPSHOT
+  // the snapshot is kept for the next transition
+  layer_set_hidden(rows_layer, false);
+#endif
+
+  // the next transition starts once this animation is done with
+  if (transition_state == TRANSITION_PENDING)
+    transition_timer = app_timer_register(0, start_pending_transition, NULL);
+  else
+    transition_state = TRANSITION_IDLE;
+
+#ifndef SIM_DAY
+  PROFILE_REPORT("transition");
+#endif
+}
+
+// -----------------------------------------------------------------------------
+
+#ifdef SCENE_SNAPSHOT
+// drawn between rows_layer and the stars. the first transition frame after the
+// rows change is copied out here, later frames hide rows_layer (see
+// anim_update) and copy it back instead of compositing every glyph
+static void scene_layer_update_callback(Layer* me, GContext* ctx)
+{
+  bool is_restoring = layer_get_hidden(rows_layer);
+  if (!is_restoring && (is_scene_snapshot_valid || is_scene_snapshot_failed || transition_state == TRANSITION_IDLE)) return;
+
+  PROFILE_TIME_BEGIN(scene_snapshot);
+
+  // the frame buffer already captured, the snapshot is left as it is
+  GBitmap* frame_buffer = graphics_capture_frame_buffer(ctx);
+  if (frame_buffer)
+  {
+    uint8_t* data = gbitmap_get_data(frame_buffer);
+    size_t size = get_frame_buffer_size(frame_buffer);
+
+    if (is_restoring)
+    {
+      memcpy(data, scene_snapshot, size);
+      PROFILE_ADD(PROFILE_SNAPSHOT_RESTORES, 1);
+    }
+    else
+    {
+      if (scene_snapshot == NULL)
+      {
+        scene_snapshot = malloc(size);
+        if (scene_snapshot)
+        {
+          scene_snapshot_size = size;
+        }
+        else
+        {
+          APP_LOG(APP_LOG_LEVEL_WARNING, "no heap for the scene snapshot (%d), compositing the glyphs", (int)size);
+          is_scene_snapshot_failed = true;
+        }
+      }
+      if (scene_snapshot)
+      {
+        memcpy(scene_snapshot, data, size);
+        is_scene_snapshot_valid = true;
+        PROFILE_MAX(PROFILE_SNAPSHOT_HEAP_BYTES, scene_snapshot_size);
+      }
+    }
+
+    graphics_release_frame_buffer(ctx, frame_buffer);
+  }
+
+  PROFILE_TIME_END(scene_snapshot, PROFILE_SNAPSHOT_MS);
+  PROFILE_TIME_END(scene_snapshot, PROFILE_AWAKE_MS);
+}
+
+static void destroy_scene_snapshot()
+{
+  free(scene_snapshot);
+  scene_snapshot = NULL;
+  scene_snapshot_size = 0;
+  is_scene_snapshot_valid = false;
+  is_scene_snapshot_failed = false;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+
+static uint32_t launch_time_ms;
+static int first_frame_ms = -1;
+
+static void finish_startup(void* data);
+
+static void star_layer_update_callback(Layer *me, GContext *ctx)
+{
+  if (first_frame_ms < 0)
+  {
+    // the star layer is drawn with every frame, the first call is the first frame
+    first_frame_ms = (int)(profile_time_ms() - launch_time_ms);
+    app_timer_register(0, finish_startup, NULL);
+#ifdef PROFILE
+    bench_glyph_draw(ctx);
+#endif
+  }
+
+  uint32_t start_ms = profile_time_ms();
+  PROFILE_TIME_BEGIN(star_draw);
+
+  for (int i = 0; i < START_POOL_SIZE; ++i)
+  {
+    // spawn_star keeps every star inside the visible area, none needs culling
+    if (star_pool[i].in_use)
     {
-      spawn_star();
-      spawn_timer = SPAWN_PERIOD;
+      ApplyPathBaseToCurrent(star_pool[i].scale);
+
+      gpath_move_to(star_path, star_pool[i].pos);
+
+      graphics_context_set_fill_color(ctx, config_data.star_color);
+      gpath_draw_filled(ctx, star_path);
+      PROFILE_ADD(PROFILE_STAR_DRAWS, 1);
+      PROFILE_ADD(PROFILE_PIXELS_TOUCHED, get_star_box_pixels(star_pool[i].scale));
     }
   }
 
-  for (int i = 0; i < START_POOL_SIZE; ++i)
+  PROFILE_TIME_END(star_draw, PROFILE_STAR_DRAW_MS);
+  PROFILE_TIME_END(star_draw, PROFILE_AWAKE_MS);
+  PROFILE_ADD(PROFILE_DISPLAY_UPDATES, 1);
+  if (transition_state != TRANSITION_IDLE)
+    telemetry.anim_ms += profile_time_ms() - start_ms;
+}
+
+static void init_star_layer(Layer* window_layer, GRect* bounds)
+{
+  for (int i = 0; i < START_POOL_SIZE; ++i)
+    star_pool[i].in_use = false;
+
+  star_layer = layer_create(*bounds);
+  layer_set_update_proc(star_layer, star_layer_update_callback);
+  layer_add_child(window_layer, star_layer);
+}
+
+// the path and animation are only needed from the first transition on
+static void init_star_transition()
+{
+  if (star_path) return;
+
+  star_path = gpath_create(&curr_star_path_info);
+
+  anim_impl.setup = anim_setup;
+  anim_impl.update = anim_update;
+  anim_impl.teardown = anim_teardown;
+}
+
+static void start_star_transition()
+{
+#ifdef PBL_PLATFORM_APLITE
+  if (anim) animation_destroy(anim);
+#endif
+
+  anim = animation_create();
+  animation_set_delay(anim, 0);
+  animation_set_duration(anim, (int)(STAR_TRANSITION_PERIOD * 1000));
+  animation_set_implementation(anim, &anim_impl);
+
+  animation_schedule(anim);
+  transition_state = TRANSITION_RUNNING;
+}
+
+static void start_pending_transition(void* data)
+{
+  transition_timer = NULL;
+  start_star_transition();
+}
+
+static void request_star_transition(int changes)
+{
+  // a tick the preroll already showed, nothing to ask for
+  if (changes == TRANSITION_CHANGE_NONE) return;
+
+  PROFILE_ADD(PROFILE_TRANSITION_REQUESTS, 1);
+  pending_changes |= changes;
+
+  if (star_path == NULL)
+  {
+    // still starting up, show the changes without stars
+    apply_transition_changes();
+    return;
+  }
+
+  switch (transition_state)
+  {
+  case TRANSITION_IDLE:
+    start_star_transition();
+    break;
+
+  case TRANSITION_RUNNING:
+    // too late for this one, they show in the next
+    if (changes_applied && pending_changes != TRANSITION_CHANGE_NONE)
+      transition_state = TRANSITION_PENDING;
+    break;
+
+  default:
+    break;
+  }
+}
+
+static void deinit_star_transition()
+{
+#ifdef PBL_PLATFORM_APLITE
+  if (anim) animation_destroy(anim);
+#endif
+  if (transition_timer) app_timer_cancel(transition_timer);
+  transition_timer = NULL;
+  transition_state = TRANSITION_IDLE;
+
+  layer_destroy(star_layer);
+  star_layer = NULL;
+
+  if (star_path)
+  {
+    gpath_destroy(star_path);
+    star_path = NULL;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// trace
+// -----------------------------------------------------------------------------
+
+#ifdef TRACE
+
+// `pebble build -- --trace` logs the events that drive the face as it is worn,
+// tools/simtrace.py packs a capture into a trace that a --sim-trace build
+// replays:
+//   TRACE,start,<hhmm>
+//   TRACE,<minute>,tick
+//   TRACE,<minute>,<config key>,<value>
+
+static time_t trace_start;
+
+static void trace_start_recording()
+{
+  trace_start = time(NULL);
+  struct tm* start = localtime(&trace_start);
+  APP_LOG(APP_LOG_LEVEL_INFO, "TRACE,start,%02d%02d", start->tm_hour, start->tm_min);
+}
+
+static int get_trace_minute()
+{
+  return (int)((time(NULL) - trace_start) / SECONDS_PER_MINUTE);
+}
+
+static void trace_tick()
+{
+  APP_LOG(APP_LOG_LEVEL_INFO, "TRACE,%d,tick", get_trace_minute());
+}
+
+static void trace_config(const Tuple* t)
+{
+  if (t->type == TUPLE_CSTRING)
+    APP_LOG(APP_LOG_LEVEL_INFO, "TRACE,%d,%d,%s", get_trace_minute(), (int)t->key, t->value->cstring);
+  else
+    APP_LOG(APP_LOG_LEVEL_INFO, "TRACE,%d,%d,%d", get_trace_minute(), (int)t->key, t->value->uint8);
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// telemetry
+// -----------------------------------------------------------------------------
+
+// off unless is_enable_telemetry is set on the config page. the counters of
+// the current day are persisted as the day starts and then at most once per
+// TELEMETRY_PERSIST_INTERVAL_S, on a minute tick or as the face unloads, so up
+// to that much of a day is lost to an unload in between. once the date changes
+// the finished day goes to the companion in one message, which keeps the last
+// days in localStorage for the config page. a day that was not delivered is
+// sent again on the next launch, or replaced by the next one. turned off, the
+// persisted counters are deleted
+
+#define TELEMETRY_SEND_DELAY_MS 10000   // after launch, for the companion to start
+#define TELEMETRY_PERSIST_INTERVAL_S (60 * 60)
+
+static struct TelemetryData unsent_telemetry;
+static bool is_telemetry_unsent = false;
+
+static int32_t get_telemetry_date(const struct tm* time)
+{
+  return (time->tm_year + 1900) * 10000 + (time->tm_mon + 1) * 100 + time->tm_mday;
+}
+
+static void sample_battery(BatteryChargeState state)
+{
+  if (telemetry.battery_samples == 0)
+    telemetry.battery_first = telemetry.battery_min = state.charge_percent;
+  if (state.charge_percent < telemetry.battery_min)
+    telemetry.battery_min = state.charge_percent;
+  telemetry.battery_last = state.charge_percent;
+
+  ++telemetry.battery_samples;
+  if (state.is_charging)
+    ++telemetry.charging_samples;
+}
+
+static void send_telemetry()
+{
+  if (!is_telemetry_unsent) return;
+
+  DictionaryIterator* iterator;
+  if (app_message_outbox_begin(&iterator) != APP_MSG_OK)
   {
-    if (star_pool[i].in_use)
-    {
-      star_pool[i].scale += delta_time * SCALE_SPEED;
-      if (star_pool[i].scale > MAX_SCALE)
-        star_pool[i].in_use = false;
-    }
+    APP_LOG(APP_LOG_LEVEL_WARNING, "outbox busy, telemetry of %d is sent on the next launch", (int)unsent_telemetry.date);
+    return;
   }
 
-  layer_mark_dirty(star_layer);
+  dict_write_int32(iterator, MSG_TELEMETRY_DATE, unsent_telemetry.date);
+  dict_write_uint32(iterator, MSG_TELEMETRY_ANIM_MS, unsent_telemetry.anim_ms);
+  dict_write_uint16(iterator, MSG_TELEMETRY_TRANSITIONS, unsent_telemetry.transitions);
+  dict_write_uint16(iterator, MSG_TELEMETRY_CONFIG_APPLIES, unsent_telemetry.config_applies);
+  dict_write_uint16(iterator, MSG_TELEMETRY_PERSIST_WRITES, unsent_telemetry.persist_writes);
+  dict_write_uint16(iterator, MSG_TELEMETRY_BATTERY_SAMPLES, unsent_telemetry.battery_samples);
+  dict_write_uint16(iterator, MSG_TELEMETRY_CHARGING_SAMPLES, unsent_telemetry.charging_samples);
+  dict_write_uint8(iterator, MSG_TELEMETRY_BATTERY_FIRST, unsent_telemetry.battery_first);
+  dict_write_uint8(iterator, MSG_TELEMETRY_BATTERY_LAST, unsent_telemetry.battery_last);
+  dict_write_uint8(iterator, MSG_TELEMETRY_BATTERY_MIN, unsent_telemetry.battery_min);
+  app_message_outbox_send();
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "telemetry of %d sent", (int)unsent_telemetry.date);
 }
 
-static void anim_teardown(struct Animation* animation)
+static void send_telemetry_callback(void* data)
 {
-  for (int i = 0; i < START_POOL_SIZE; ++i)
-    star_pool[i].in_use = false;
-
-  layer_mark_dirty(star_layer);
+  send_telemetry();
 }
 
+// -----------------------------------------------------------------------------
+// config request
 // -----------------------------------------------------------------------------
 
-static void star_layer_update_callback(Layer *me, GContext *ctx)
+// a watch without a persisted config (new install, cleared, or discarded as
+// too old) asks for all of it. the companion then forgets what it thinks the
+// watch has and sends the whole config, see the appmessage listener of
+// pebble-js-app.js. unanswered, it asks again on the next launch
+
+#define CONFIG_REQUEST_DELAY_MS 10000   // after launch, for the companion to start
+#define CONFIG_REQUEST_RETRY_MS 1000    // the outbox is busy, e.g. with telemetry
+
+static void send_config_request(void* data)
 {
-  for (int i = 0; i < START_POOL_SIZE; ++i)
+  if (!is_config_missing) return;
+
+  DictionaryIterator* iterator;
+  if (app_message_outbox_begin(&iterator) != APP_MSG_OK)
   {
-    if (star_pool[i].in_use)
-    {
-      ApplyPathBaseToCurrent(star_pool[i].scale);
+    app_timer_register(CONFIG_REQUEST_RETRY_MS, send_config_request, NULL);
+    return;
+  }
 
-      gpath_move_to(star_path, star_pool[i].pos);
+  dict_write_uint8(iterator, MSG_CONFIG_REQUEST, 1);
+  app_message_outbox_send();
 
-      graphics_context_set_fill_color(ctx, config_data.star_color);
-      gpath_draw_filled(ctx, star_path);
-    }
+  APP_LOG(APP_LOG_LEVEL_INFO, "config requested");
+}
+
+// the write is counted ahead, the record written holds it
+static void persist_telemetry()
+{
+  count_persist_write();
+  telemetry.persist_time = (uint32_t)time(NULL);
+  persist_write_data(PERSIST_TELEMETRY, &telemetry, sizeof(telemetry));
+}
+
+static void delete_persisted(uint32_t key)
+{
+  if (!persist_exists(key)) return;
+
+  count_persist_write();
+  persist_delete(key);
+}
+
+// the day before is kept to send, its write counted in it. a day that never
+// started has nothing to send
+static void start_telemetry_day(int32_t date)
+{
+  if (telemetry.date != 0)
+  {
+    count_persist_write();
+    unsent_telemetry = telemetry;
+    is_telemetry_unsent = true;
+    persist_write_data(PERSIST_TELEMETRY_UNSENT, &unsent_telemetry, sizeof(unsent_telemetry));
   }
+
+  memset(&telemetry, 0, sizeof(telemetry));
+  telemetry.date = date;
+  persist_telemetry();
 }
 
-static void init_star_transition(Layer* window_layer, GRect* bounds)
+// on every minute shown
+static void update_telemetry_date(const struct tm* now)
 {
-  for (int i = 0; i < START_POOL_SIZE; ++i)
-    star_pool[i].in_use = false;
+  if (!config_data.is_enable_telemetry) return;
 
-  star_layer = layer_create(*bounds);
-  layer_set_update_proc(star_layer, star_layer_update_callback);
-  layer_add_child(window_layer, star_layer);
+  int32_t date = get_telemetry_date(now);
+  if (date == telemetry.date)
+  {
+    if ((uint32_t)time(NULL) - telemetry.persist_time >= TELEMETRY_PERSIST_INTERVAL_S)
+      persist_telemetry();
+    return;
+  }
 
-  curr_star_path_info.num_points = base_star_path_info.num_points;
-  curr_star_path_info.points = malloc(sizeof(GPoint) * curr_star_path_info.num_points);
+  start_telemetry_day(date);
+  sample_battery(battery_state_service_peek());
+  send_telemetry();
+}
 
-  star_path = gpath_create(&curr_star_path_info);
+static bool read_telemetry(uint32_t key, struct TelemetryData* data)
+{
+  if (!persist_exists(key)) return false;
+  if (persist_get_size(key) != (int)sizeof(*data))
+  {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "telemetry size not match! discard telemetry!");
+    return false;
+  }
 
-  anim_impl.setup = anim_setup;
-  anim_impl.update = anim_update;
-  anim_impl.teardown = anim_teardown;
+  persist_read_data(key, data, sizeof(*data));
+  return true;
 }
 
-static void start_star_transition()
+static void start_telemetry()
 {
-#ifdef PBL_PLATFORM_APLITE
-  if (anim) animation_destroy(anim);
-#endif
+  if (!read_telemetry(PERSIST_TELEMETRY, &telemetry))
+    memset(&telemetry, 0, sizeof(telemetry));
+  is_telemetry_unsent = read_telemetry(PERSIST_TELEMETRY_UNSENT, &unsent_telemetry);
 
-  anim = animation_create();
-  animation_set_delay(anim, 0);
-  animation_set_duration(anim, (int)(STAR_TRANSITION_PERIOD * 1000));
-  animation_set_implementation(anim, &anim_impl);
+  // a day may have ended while the face was not running, it is sent once the
+  // companion is up, see finish_startup
+  time_t timestamp = time(NULL);
+  int32_t date = get_telemetry_date(localtime(&timestamp));
+  if (date != telemetry.date)
+    start_telemetry_day(date);
 
-  animation_schedule(anim);
+  sample_battery(battery_state_service_peek());
+  battery_state_service_subscribe(sample_battery);
 }
 
-static void deinit_star_transition()
+// what was kept goes, the counters start over if it is turned on again
+static void stop_telemetry()
 {
-#ifdef PBL_PLATFORM_APLITE
-  if (anim) animation_destroy(anim);
-#endif
+  battery_state_service_unsubscribe();
 
-  layer_destroy(star_layer);
-  gpath_destroy(star_path);
-  free(curr_star_path_info.points);
+  delete_persisted(PERSIST_TELEMETRY);
+  delete_persisted(PERSIST_TELEMETRY_UNSENT);
+  memset(&telemetry, 0, sizeof(telemetry));
+  is_telemetry_unsent = false;
+}
+
+static void init_telemetry()
+{
+  if (config_data.is_enable_telemetry)
+    start_telemetry();
+  else
+    stop_telemetry();
+}
+
+static void deinit_telemetry()
+{
+  if (!config_data.is_enable_telemetry) return;
+
+  battery_state_service_unsubscribe();
+  if ((uint32_t)time(NULL) - telemetry.persist_time >= TELEMETRY_PERSIST_INTERVAL_S)
+    persist_telemetry();
 }
 
 // -----------------------------------------------------------------------------
 // tick proccess
 // -----------------------------------------------------------------------------
 
-static void handle_min_tick(struct tm* time, TimeUnits units_changed)
+// boundary_ms is when the minute of `time` starts, by profile_time_ms
+static void show_minute(struct tm* time, uint32_t boundary_ms)
 {
+  PROFILE_TIME_BEGIN(min_tick);
+
   int now_hr = time->tm_hour;
   int now_min = time->tm_min;
   int now_date = time->tm_mday;
   int now_month = time->tm_mon;
+  int now_year = time->tm_year + 1900;
+  int changes = TRANSITION_CHANGE_NONE;
+
+  update_telemetry_date(time);
 
 #ifdef DEBUG
   now_hr = debug_hour;
   now_min = debug_min;
   now_date = debug_date;
   now_month = debug_month;
+  now_year = debug_year;
   
   debug_min++;
   if (debug_min >= 60)
@@ -861,56 +2161,106 @@ static void handle_min_tick(struct tm* time, TimeUnits units_changed)
   if (debug_month >= 12)
   {
     debug_month = 0;
+    debug_year++;
   }
 #endif
 
-  if (current_hr != now_hr || current_min != now_min || current_date != now_date || current_month != now_month)
+  if (current_date != now_date || current_month != now_month || current_year != now_year)
+  {
+    current_lunar_month = calculate_lunar_month(now_year, now_month, now_date);
+  }
+
+  if (current_hr != now_hr || current_min != now_min || current_date != now_date || current_month != now_month || current_year != now_year)
   {
     current_hr = now_hr;
     current_min = now_min;
     current_date = now_date;
     current_month = now_month;
+    current_year = now_year;
 
-    need_refresh_time = true;
+    changes = TRANSITION_CHANGE_TIME;
+    time_boundary_ms = boundary_ms;
   }
 
-  start_star_transition();
+  request_star_transition(changes);
+
+  PROFILE_TIME_END(min_tick, PROFILE_AWAKE_MS);
 }
 
-// -----------------------------------------------------------------------------
+#ifdef PREROLL_TRANSITION
+// the new time shows TRANSITION_REFRESH_RATIO into the transition
+#define TRANSITION_PREROLL_MS ((int)(STAR_TRANSITION_PERIOD * TRANSITION_REFRESH_RATIO * 1000))
 
-static void set_color(GBitmap* image, GColor color, GColor back_color){
-  if(image == NULL) return;
+static AppTimer* preroll_timer = NULL;
+static time_t preroll_time;
 
-#ifdef PBL_COLOR
-  if (gcolor_equal(color, GColorBlack) && gcolor_equal(back_color, GColorWhite))
-  {
-    replace_gbitmap_color(GColorBlack, GColorRed, image, NULL);
-    replace_gbitmap_color(GColorWhite, color, image, NULL);
-    replace_gbitmap_color(GColorRed, back_color, image, NULL);
-  }
-  else if (gcolor_equal(color, GColorBlack))
-  {
-    replace_gbitmap_color(GColorBlack, back_color, image, NULL);
-    replace_gbitmap_color(GColorWhite, color, image, NULL);
-  }
-  else
-  {
-    replace_gbitmap_color(GColorWhite, color, image, NULL);
-    replace_gbitmap_color(GColorBlack, back_color, image, NULL);
-  }
+static void preroll_transition(void* data)
+{
+  preroll_timer = NULL;
+  show_minute(localtime(&preroll_time), profile_time_ms() + TRANSITION_PREROLL_MS);
+}
+
+static void cancel_preroll()
+{
+  if (preroll_timer) app_timer_cancel(preroll_timer);
+  preroll_timer = NULL;
+}
+
+// the minute tick at the boundary then finds its time shown and joins the transition
+static void schedule_preroll(time_t boundary_time, int ms_to_boundary)
+{
+  cancel_preroll();
+
+  // too close, this minute is left to its tick
+  if (ms_to_boundary <= TRANSITION_PREROLL_MS) return;
+
+  preroll_time = boundary_time;
+  preroll_timer = app_timer_register(ms_to_boundary - TRANSITION_PREROLL_MS, preroll_transition, NULL);
+}
+
+#ifndef SIM_DAY
+static void schedule_next_preroll()
+{
+  time_t sec;
+  uint16_t ms;
+  time_ms(&sec, &ms);
+
+  time_t boundary_time = sec - sec % SECONDS_PER_MINUTE + SECONDS_PER_MINUTE;
+  schedule_preroll(boundary_time, (int)(boundary_time - sec) * 1000 - ms);
+}
+#endif
+#endif
+
+#ifndef SIM_DAY
+static void handle_min_tick(struct tm* time, TimeUnits units_changed)
+{
+#ifdef TRACE
+  trace_tick();
+#endif
+
+  // ticks come on the boundary, give or take
+  time_t sec;
+  uint16_t ms;
+  time_ms(&sec, &ms);
+  show_minute(time, profile_time_ms() - ((int)(sec % SECONDS_PER_MINUTE) * 1000 + ms));
+
+#ifdef PREROLL_TRANSITION
+  schedule_next_preroll();
 #endif
 }
+#endif
+
+// -----------------------------------------------------------------------------
 
 static void set_time_bitmap_comp_mode(GCompOp mode)
 {
-  for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
+  time_comp_mode = mode;
+  for (int i = 0; i < ROW_NUM; ++i)
   {
-    bitmap_layer_set_compositing_mode(hour_layers[i], mode);
-    bitmap_layer_set_compositing_mode(min_layers[i], mode);
-    bitmap_layer_set_compositing_mode(month_layers[i], mode);
-    bitmap_layer_set_compositing_mode(date_layers[i], mode);
+    for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+      bitmap_layer_set_compositing_mode(row_layers[i][j], mode);
   }
+  mark_glyphs_dirty();
 }
 
 static void refresh_color_theme()
@@ -921,29 +2271,8 @@ static void refresh_color_theme()
 
   window_set_background_color(window, config_data.bg_color);
 
-  if (font_s_bitmap_date) gbitmap_destroy(font_s_bitmap_date);
-  if (font_s_bitmap_month) gbitmap_destroy(font_s_bitmap_month);
-  if (font_m_bitmap) gbitmap_destroy(font_m_bitmap);
-  if (font_l_bitmap) gbitmap_destroy(font_l_bitmap);
-
-#ifdef PBL_PLATFORM_APLITE
-  font_m_bitmap = gbitmap_create_with_resource(RESOURCE_ID_FONT_36);
-  font_l_bitmap = gbitmap_create_with_resource(RESOURCE_ID_FONT_48);
-  font_s_bitmap_date = gbitmap_create_with_resource(RESOURCE_ID_FONT_24);
-  font_s_bitmap_month = font_s_bitmap_date;
-#else
-  font_m_bitmap = gbitmap_create_with_resource(RESOURCE_ID_FONT_36);
-  font_l_bitmap = gbitmap_create_with_resource(RESOURCE_ID_FONT_48);
-  font_s_bitmap_date = gbitmap_create_with_resource(RESOURCE_ID_FONT_24);
-  font_s_bitmap_month = gbitmap_create_with_resource(RESOURCE_ID_FONT_24);
-#endif
-
-#ifdef PBL_COLOR
-  set_color(font_s_bitmap_date, config_data.date_color, config_data.bg_color);
-  set_color(font_s_bitmap_month, config_data.month_color, config_data.bg_color);
-  set_color(font_m_bitmap, config_data.time_color, config_data.bg_color);
-  set_color(font_l_bitmap, config_data.time_color, config_data.bg_color);
-#else
+  recolor_font_bitmaps();
+#ifndef PBL_COLOR
   set_time_bitmap_comp_mode( (gcolor_equal(GColorBlack, config_data.bg_color)) ? GCompOpAssign : GCompOpSet);
 #endif
 
@@ -961,34 +2290,34 @@ static void window_load(Window *window)
 
   window_width = bounds.size.w;
   window_height = bounds.size.h;
+  screen_geometry_init(bounds);
 
-  GRect rect = GRect(0, 0, NUM_M_SIZE, NUM_M_SIZE);
-
-  Layer* layer;
-  for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
-  {
-    hour_layers[i] = bitmap_layer_create(rect);
-    layer = bitmap_layer_get_layer(hour_layers[i]);
-    layer_add_child(window_layer, layer);
-    layer_set_hidden(layer, true);
-
-    min_layers[i] = bitmap_layer_create(rect);
-    layer = bitmap_layer_get_layer(min_layers[i]);
-    layer_add_child(window_layer, layer);
-    layer_set_hidden(layer, true);
-
-    date_layers[i] = bitmap_layer_create(rect);
-    layer = bitmap_layer_get_layer(date_layers[i]);
-    layer_add_child(window_layer, layer);
-    layer_set_hidden(layer, true);
-
-    month_layers[i] = bitmap_layer_create(rect);
-    layer = bitmap_layer_get_layer(month_layers[i]);
-    layer_add_child(window_layer, layer);
-    layer_set_hidden(layer, true);
-  }
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  // the face may load while a peek is already showing
+  GRect unobstructed_bounds = layer_get_unobstructed_bounds(window_layer);
+  window_height = unobstructed_bounds.size.h;
+  screen_geometry_init(PBL_IF_ROUND_ELSE(bounds, unobstructed_bounds));
+#endif
 
-  set_time_bitmap_comp_mode(GCompOpAssign);
+  // stars draw over the time rows, which are added to rows_layer as they show up
+  init_star_layer(window_layer, &bounds);
+  rows_layer = layer_create(bounds);
+  layer_insert_below_sibling(rows_layer, star_layer);
+#ifdef SCENE_SNAPSHOT
+  scene_layer = layer_create(bounds);
+  layer_set_update_proc(scene_layer, scene_layer_update_callback);
+  layer_insert_below_sibling(scene_layer, star_layer);
+#endif
+#ifdef GLYPH_BLIT
+  glyph_layer = layer_create(bounds);
+  layer_set_update_proc(glyph_layer, glyph_layer_update_callback);
+  layer_add_child(rows_layer, glyph_layer);
+#endif
+#ifdef GLYPH_ATLAS_CELLS
+  glyph_cache_init(GLYPH_CACHE_BUDGET);
+#endif
+  // the color atlases have transparent backgrounds
+  set_time_bitmap_comp_mode(PBL_IF_COLOR_ELSE(GCompOpSet, GCompOpAssign));
 
   time_t timestamp = time(NULL);
   struct tm* time = localtime(&timestamp);
@@ -997,28 +2326,58 @@ static void window_load(Window *window)
   current_min = time->tm_min;
   current_date = time->tm_mday;
   current_month = time->tm_mon;
+  current_year = time->tm_year + 1900;
+  current_lunar_month = calculate_lunar_month(current_year, current_month, current_date);
 
-  init_star_transition(window_layer, &bounds);
   refresh_color_theme();
+#ifndef SIM_DAY
   tick_timer_service_subscribe(MINUTE_UNIT, handle_min_tick);
+#endif
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  unobstructed_area_service_subscribe((UnobstructedAreaHandlers) {
+    .will_change = unobstructed_will_change,
+    .change = unobstructed_change,
+    .did_change = unobstructed_did_change,
+  }, NULL);
+#endif
 }
 
 static void window_unload(Window *window)
 {
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  unobstructed_area_service_unsubscribe();
+#endif
+
   deinit_star_transition();
+#ifdef PREROLL_TRANSITION
+  cancel_preroll();
+#endif
 
-  for (int i = 0; i < CHAR_MAX_LENGTH; ++i)
+  for (int i = 0; i < ROW_NUM; ++i)
   {
-    bitmap_layer_destroy(hour_layers[i]);
-    bitmap_layer_destroy(min_layers[i]);
-    bitmap_layer_destroy(date_layers[i]);
-    bitmap_layer_destroy(month_layers[i]);
+    for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+    {
+      bitmap_layer_destroy(row_layers[i][j]);
+      row_layers[i][j] = NULL;
+    }
   }
+#ifdef GLYPH_BLIT
+  layer_destroy(glyph_layer);
+  glyph_layer = NULL;
+#endif
+  layer_destroy(rows_layer);
+  rows_layer = NULL;
+#ifdef SCENE_SNAPSHOT
+  layer_destroy(scene_layer);
+  scene_layer = NULL;
+  destroy_scene_snapshot();
+#endif
 
-  if (font_s_bitmap_date) gbitmap_destroy(font_s_bitmap_date);
-  if (font_s_bitmap_month) gbitmap_destroy(font_s_bitmap_month);
-  if (font_m_bitmap) gbitmap_destroy(font_m_bitmap);
-  if (font_l_bitmap) gbitmap_destroy(font_l_bitmap);
+  destroy_font_bitmaps();
+#ifdef GLYPH_ATLAS_CELLS
+  glyph_cache_deinit();
+#endif
 }
 
 // -----------------------------------------------------------------------------
@@ -1103,11 +2462,18 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
 {
   APP_LOG(APP_LOG_LEVEL_INFO, "Inbox receive success!");
 
+  PROFILE_TIME_BEGIN(inbox);
+  PROFILE_ADD(PROFILE_CONFIG_MESSAGES, 1);
+
   bool need_refresh_color = false;
+  bool was_telemetry_enabled = config_data.is_enable_telemetry;
 
   Tuple *t = dict_read_first(iterator);
   while (t)
   {
+#ifdef TRACE
+    trace_config(t);
+#endif
     switch(t->key)
     {
     case MSG_CONFIG_BG_COLOR:
@@ -1190,6 +2556,17 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
       need_refresh_color = true;
       break;
 
+    case MSG_CONFIG_IS_ENABLE_YEAR:
+      APP_LOG(APP_LOG_LEVEL_INFO, "MSG_CONFIG_IS_ENABLE_YEAR: %d", t->value->uint8);
+      config_data.is_enable_year = (t->value->uint8 == 0) ? false : true;
+      need_refresh_color = true;
+      break;
+
+    case MSG_CONFIG_IS_ENABLE_TELEMETRY:
+      APP_LOG(APP_LOG_LEVEL_INFO, "MSG_CONFIG_IS_ENABLE_TELEMETRY: %d", t->value->uint8);
+      config_data.is_enable_telemetry = (t->value->uint8 == 0) ? false : true;
+      break;
+
     default:
       APP_LOG(APP_LOG_LEVEL_ERROR, "Key %d not recognized!", (int)t->key);
       break;
@@ -1198,12 +2575,25 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
     t = dict_read_next(iterator);
   }
 
+  // nothing to show for it, only kept
+  bool is_telemetry_changed = (config_data.is_enable_telemetry != was_telemetry_enabled);
+  if (is_telemetry_changed)
+  {
+    if (config_data.is_enable_telemetry)
+      start_telemetry();
+    else
+      stop_telemetry();
+  }
+
   if (need_refresh_color)
   {
-    refresh_color_theme();
-    start_star_transition();
-    save_config();
+    ++telemetry.config_applies;
+    request_star_transition(TRANSITION_CHANGE_THEME);
   }
+  if (need_refresh_color || is_telemetry_changed)
+    save_config();
+
+  PROFILE_TIME_END(inbox, PROFILE_AWAKE_MS);
 }
 
 static void inbox_dropped_callback(AppMessageResult reason, void *context)
@@ -1213,12 +2603,19 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context)
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context)
 {
+  // unsent telemetry stays for the next launch
   APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox send failed!");
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context)
 {
   APP_LOG(APP_LOG_LEVEL_INFO, "Outbox send success!");
+
+  if (dict_find(iterator, MSG_TELEMETRY_DATE))
+  {
+    is_telemetry_unsent = false;
+    delete_persisted(PERSIST_TELEMETRY_UNSENT);
+  }
 }
 
 static void init_app_message()
@@ -1232,15 +2629,220 @@ static void init_app_message()
   app_message_open(app_message_inbox_size_maximum(), app_message_outbox_size_maximum());
 }
 
+// -----------------------------------------------------------------------------
+// benchmark
+// -----------------------------------------------------------------------------
+
+#ifdef PROFILE
+
+#define BENCH_TRANSITION_FRAMES 48   // 1.6 s at 30 fps
+
+static void run_benchmarks()
+{
+  int digits[NUMERAL_MAX_LENGTH];
+  struct CharAtlas atlas;
+  volatile unsigned int hex = 0;
+
+  PROFILE_BENCH("calculate_digits", 100, for (int v = 0; v < 100; ++v) calculate_digits(v, digits));
+  PROFILE_BENCH("get_hour_atlas", 1000, get_hour_atlas(&atlas, bench_i % 24, bench_i % 60, false, true, bench_i & 1));
+  PROFILE_BENCH("get_min_atlas", 1000, get_min_atlas(&atlas, bench_i % 60, bench_i & 1));
+  PROFILE_BENCH("get_date_atlas", 1000, get_date_atlas(&atlas, 1 + bench_i % 31, true, bench_i & 1));
+  PROFILE_BENCH("get_month_atlas", 1000, get_month_atlas(&atlas, bench_i % 12, bench_i & 1, true, false));
+  // once a day, 2100 walks the whole table
+  PROFILE_BENCH("calculate_lunar_month", 100, calculate_lunar_month(1900 + bench_i * 2, 11, 31));
+  PROFILE_BENCH("refresh_time", 50, refresh_time());
+  PROFILE_BENCH("anim_transition", 10,
+    anim_setup(NULL);
+    for (int f = 0; f <= BENCH_TRANSITION_FRAMES; ++f)
+      anim_update(NULL, ANIMATION_NORMALIZED_MAX * f / BENCH_TRANSITION_FRAMES);
+    anim_teardown(NULL));
+  PROFILE_BENCH("hex_string_to_uint", 1000, hex += hex_string_to_uint("FFAA55"));
+#ifdef PBL_COLOR
+  // identity changes keep the fonts as they are
+  GColor lut[GCOLOR_LUT_SIZE];
+  gcolor_lut_init_identity(lut);
+  PROFILE_BENCH("replace_gbitmap_color", 20, replace_gbitmap_color(GColorWhite, GColorWhite, get_font_bitmap(FONT_L), NULL));
+  PROFILE_BENCH("remap_gbitmap_colors", 100, remap_gbitmap_colors(lut, get_font_bitmap(FONT_L), NULL));
+#ifndef GLYPH_ATLAS_CELLS
+  // the atlases are stored as pbi, a load copies the palette and pixels as they are
+  PROFILE_BENCH("load_font_atlas", 10, gbitmap_destroy(gbitmap_create_with_resource(RESOURCE_ID_FONT_48)));
+#endif
+#endif
+  // a background color change, as a config message applies it
+  GColor bg_color = config_data.bg_color;
+  PROFILE_BENCH("apply_bg_color", 20,
+    config_data.bg_color = (bench_i & 1) ? GColorWhite : GColorBlack;
+    refresh_color_theme());
+  config_data.bg_color = bg_color;
+  refresh_color_theme();
+
+  // star_layer_update_callback needs a graphics context, it is timed in place
+
+  PROFILE_RESET();
+  APP_LOG(APP_LOG_LEVEL_INFO, "BENCH,done");
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+// simulated day
+// -----------------------------------------------------------------------------
+
+#ifdef SIM_DAY
+
+// drive the face through a day of minute ticks, a tick each SIM_DAY_TICK_MS so
+// every transition finishes before the next one. counters are logged and reset
+// each simulated hour of the run (tag hourNN), tools/sim_day.py collects them.
+
+#define SIM_DAY_TICK_MS   2000
+
+struct SimConfigStep
+{
+  int minute;         // minutes into the run
+  uint32_t key;
+  const char* color;  // MSG_CONFIG_*_COLOR keys
+  uint8_t value;      // everything else
+};
+
+#ifdef SIM_TRACE
+// a recorded trace, with its own length and time of day, see tools/simtrace.py
+#include "generated/sim_trace.h"
+#else
+#define SIM_DAY_MINUTES   (24 * 60)
+
+// the kind of changes a user makes from the config page
+static const struct SimConfigStep s_sim_config_steps[] = {
+  { 6 * 60,       MSG_CONFIG_IS_ENABLE_MONTH,     NULL,       1 },
+  { 9 * 60,       MSG_CONFIG_TIME_COLOR,          "#FFAA55",  0 },
+  { 9 * 60 + 1,   MSG_CONFIG_STAR_COLOR,          "#55AAFF",  0 },
+  { 12 * 60,      MSG_CONFIG_IS_USE_FORMAL,       NULL,       1 },
+  { 15 * 60,      MSG_CONFIG_DATE_POSITION_TYPE,  NULL,       DATE_POSITION_BOTTOM },
+  { 18 * 60,      MSG_CONFIG_BG_COLOR,            "#FFFFFF",  0 },
+  { 21 * 60,      MSG_CONFIG_IS_ENABLE_DATE,      NULL,       0 },
+};
+#endif
+
+static struct ConfigData sim_saved_config;
+static time_t sim_timestamp;
+static int sim_minute;
+
+static void sim_send_config(const struct SimConfigStep* step)
+{
+  uint8_t buffer[32];
+  DictionaryIterator iterator;
+
+  // go through the same path as a message from the phone
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  if (step->color)
+    dict_write_cstring(&iterator, step->key, step->color);
+  else
+    dict_write_uint8(&iterator, step->key, step->value);
+  uint32_t size = dict_write_end(&iterator);
+
+  dict_read_begin_from_buffer(&iterator, buffer, size);
+  inbox_received_callback(&iterator, NULL);
+}
+
+static void sim_day_tick(void* data)
+{
+  for (unsigned int i = 0; i < ARRAY_LENGTH(s_sim_config_steps); ++i)
+  {
+    if (s_sim_config_steps[i].minute == sim_minute) sim_send_config(&s_sim_config_steps[i]);
+  }
+
+  // each tick is the boundary of its simulated minute
+  sim_timestamp += SECONDS_PER_MINUTE;
+  show_minute(localtime(&sim_timestamp), profile_time_ms());
+  ++sim_minute;
+
+  if (sim_minute % 60 == 0)
+  {
+    char tag[16];
+    snprintf(tag, sizeof(tag), "hour%02d", sim_minute / 60 - 1);
+    PROFILE_REPORT(tag);
+    PROFILE_RESET();
+  }
+
+  if (sim_minute < SIM_DAY_MINUTES)
+  {
+    app_timer_register(SIM_DAY_TICK_MS, sim_day_tick, NULL);
+#ifdef PREROLL_TRANSITION
+    schedule_preroll(sim_timestamp + SECONDS_PER_MINUTE, SIM_DAY_TICK_MS);
+#endif
+    return;
+  }
+
+  // leave the persisted config as it was
+  config_data = sim_saved_config;
+  refresh_color_theme();
+  save_config();
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "SIM,done,%d", SIM_DAY_MINUTES);
+}
+
+static void start_sim_day()
+{
+  sim_saved_config = config_data;
+  sim_timestamp = time(NULL);
+  sim_minute = 0;
+
+#ifdef SIM_DAY_START_MINUTE
+  struct tm* now = localtime(&sim_timestamp);
+  sim_timestamp += (SIM_DAY_START_MINUTE - (now->tm_hour * 60 + now->tm_min)) * SECONDS_PER_MINUTE;
+#endif
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "SIM,start,%d,%d", SIM_DAY_MINUTES, SIM_DAY_TICK_MS);
+  app_timer_register(SIM_DAY_TICK_MS, sim_day_tick, NULL);
+}
+
+#endif
+
 // -----------------------------------------------------------------------------
 // main
 // -----------------------------------------------------------------------------
 
+// runs once the first frame is drawn
+static void finish_startup(void* data)
+{
+  APP_LOG(APP_LOG_LEVEL_INFO, "first frame after %d ms", first_frame_ms);
+  PROFILE_ADD(PROFILE_FIRST_FRAME_MS, first_frame_ms);
+  PROFILE_REPORT("startup");
+
+  init_star_transition();
+
+  // hour and minute switch between the two sizes as the time changes
+  get_font_bitmap(FONT_L);
+  get_font_bitmap(FONT_M);
+
+  if (is_telemetry_unsent)
+    app_timer_register(TELEMETRY_SEND_DELAY_MS, send_telemetry_callback, NULL);
+  if (is_config_missing)
+    app_timer_register(CONFIG_REQUEST_DELAY_MS, send_config_request, NULL);
+
+#if defined(PREROLL_TRANSITION) && !defined(SIM_DAY)
+  // from the first minute boundary on
+  schedule_next_preroll();
+#endif
+
+#ifdef PROFILE
+  run_benchmarks();
+#endif
+#ifdef SIM_DAY
+  start_sim_day();
+#endif
+}
+
 static void init(void)
 {
+  launch_time_ms = profile_time_ms();
+#ifdef TRACE
+  trace_start_recording();
+#endif
+
+  // the stored config is only written when it changes, see inbox_received_callback
   init_config();
-  save_config();
   init_app_message();
+  init_telemetry();
 
   window = window_create();
   window_set_background_color(window, config_data.bg_color);
@@ -1255,6 +2857,7 @@ static void init(void)
 static void deinit(void)
 {
   window_destroy(window);
+  deinit_telemetry();
 }
 
 int main(void)
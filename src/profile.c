@@ -0,0 +1,79 @@
+#include "profile.h"
+
+uint32_t profile_time_ms()
+{
+  time_t sec;
+  uint16_t ms;
+  time_ms(&sec, &ms);
+
+  return (uint32_t)sec * 1000 + ms;
+}
+
+#ifdef PROFILE
+
+// same order as enum ProfileCounter
+static const char* s_counter_names[PROFILE_COUNTER_NUM] = {
+  "transitions",
+  "transition_requests",
+  "anim_frames",
+  "frames_skipped",
+  "frames_unchanged",
+  "star_draws",
+  "star_draw_ms",
+  "pixels_touched",
+  "glyph_draw_ms",
+  "snapshot_restores",
+  "snapshot_ms",
+  "snapshot_heap_bytes",
+  "refresh_time",
+  "refresh_time_ms",
+  "time_changes",
+  "time_latency_ms",
+  "time_latency_max_ms",
+  "layer_mutations",
+  "font_loads",
+  "font_load_ms",
+  "font_heap_bytes",
+  "font_resident_bytes",
+  "glyph_cache_hits",
+  "glyph_cache_misses",
+  "awake_ms",
+  "anim_ms",
+  "recolor_ms",
+  "display_updates",
+  "config_messages",
+  "persist_writes",
+  "first_frame_ms",
+};
+
+static int32_t s_counters[PROFILE_COUNTER_NUM];
+
+void profile_add(enum ProfileCounter counter, int32_t value)
+{
+  s_counters[counter] += value;
+}
+
+void profile_max(enum ProfileCounter counter, int32_t value)
+{
+  if (value > s_counters[counter]) s_counters[counter] = value;
+}
+
+void profile_report(const char* tag)
+{
+  for (int i = 0; i < PROFILE_COUNTER_NUM; ++i)
+  {
+    APP_LOG(APP_LOG_LEVEL_INFO, "PROFILE,%s,%s,%d", tag, s_counter_names[i], (int)s_counters[i]);
+  }
+}
+
+void profile_reset()
+{
+  memset(s_counters, 0, sizeof(s_counters));
+}
+
+int32_t profile_get(enum ProfileCounter counter)
+{
+  return s_counters[counter];
+}
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+#include <pebble.h>
+
+// lightweight counters for profiling builds (`pebble build -- --profile`, which
+// defines PROFILE). everything below compiles away otherwise.
+//
+// reports are logged as one line per value so tools/profile_report.py can turn
+// a `pebble logs` capture into json:
+//   PROFILE,<tag>,<counter>,<value>
+//   BENCH,<name>,<iterations>,<total ms>
+
+enum ProfileCounter
+{
+  PROFILE_TRANSITIONS = 0,    // star transitions played
+  PROFILE_TRANSITION_REQUESTS, // transitions asked for, merged ones included
+  PROFILE_ANIM_FRAMES,        // anim_update calls that stepped the stars
+  PROFILE_FRAMES_SKIPPED,     // anim_update calls over the frame rate cap
+  PROFILE_FRAMES_UNCHANGED,   // stepped frames that left the screen as it was
+  PROFILE_STAR_DRAWS,         // gpath_draw_filled calls
+  PROFILE_STAR_DRAW_MS,       // time in star_layer_update_callback
+  PROFILE_PIXELS_TOUCHED,     // bounding boxes of the stars drawn and glyphs laid out
+  PROFILE_GLYPH_DRAW_MS,      // time in glyph_layer_update_callback (--blit-glyphs)
+  PROFILE_SNAPSHOT_RESTORES,  // transition frames drawn from the scene snapshot, no glyphs composited
+  PROFILE_SNAPSHOT_MS,        // time taking and restoring it
+  PROFILE_SNAPSHOT_HEAP_BYTES, // heap it takes, max
+  PROFILE_REFRESH_TIME,       // refresh_time calls
+  PROFILE_REFRESH_TIME_MS,    // time in refresh_time
+  PROFILE_TIME_CHANGES,       // new minutes shown
+  PROFILE_TIME_LATENCY_MS,    // minute boundary to the new minute shown, summed, early is negative
+  PROFILE_TIME_LATENCY_MAX_MS, // the same, max
+  PROFILE_LAYER_MUTATIONS,    // glyph layers moved, shown or hidden
+  PROFILE_FONT_LOADS,         // fonts loaded by get_font_bitmap
+  PROFILE_FONT_LOAD_MS,       // time loading and recoloring them
+  PROFILE_FONT_HEAP_BYTES,    // heap taken by one font, max
+  PROFILE_FONT_RESIDENT_BYTES, // font pixel data held at once, max
+  PROFILE_GLYPH_CACHE_HITS,   // glyph_cache_acquire calls served from the cache
+  PROFILE_GLYPH_CACHE_MISSES, // glyph_cache_acquire calls reading the resource
+  PROFILE_AWAKE_MS,           // time in the app's event handlers
+  PROFILE_ANIM_MS,            // time in anim_update, refresh_time included
+  PROFILE_RECOLOR_MS,         // time recoloring the fonts
+  PROFILE_DISPLAY_UPDATES,    // window redraws, star layer included in each
+  PROFILE_CONFIG_MESSAGES,    // config messages received
+  PROFILE_PERSIST_WRITES,     // persist writes and deletes, config and telemetry
+  PROFILE_FIRST_FRAME_MS,     // launch to the first frame drawn
+  PROFILE_COUNTER_NUM
+};
+
+uint32_t profile_time_ms();
+
+#ifdef PROFILE
+
+void profile_add(enum ProfileCounter counter, int32_t value);
+void profile_max(enum ProfileCounter counter, int32_t value);
+void profile_report(const char* tag);
+void profile_reset();
+int32_t profile_get(enum ProfileCounter counter);   // for the host tests
+
+#define PROFILE_ADD(counter, value)     profile_add(counter, value)
+#define PROFILE_MAX(counter, value)     profile_max(counter, value)
+#define PROFILE_TIME_BEGIN(name)        uint32_t name##_profile_start = profile_time_ms()
+#define PROFILE_TIME_END(name, counter) profile_add(counter, profile_time_ms() - name##_profile_start)
+#define PROFILE_HEAP_BEGIN(name)        int name##_profile_heap = heap_bytes_used()
+#define PROFILE_HEAP_END(name, counter) profile_max(counter, (int)heap_bytes_used() - name##_profile_heap)
+#define PROFILE_REPORT(tag)             profile_report(tag)
+#define PROFILE_RESET()                 profile_reset()
+
+// run the statements `iterations` times and log the total time
+#define PROFILE_BENCH(name, iterations, ...)                                          \
+  do {                                                                                \
+    uint32_t bench_start = profile_time_ms();                                         \
+    for (int bench_i = 0; bench_i < (iterations); ++bench_i) { __VA_ARGS__; }         \
+    APP_LOG(APP_LOG_LEVEL_INFO, "BENCH,%s,%d,%d", name, (int)(iterations),            \
+      (int)(profile_time_ms() - bench_start));                                        \
+  } while (0)
+
+#else
+
+#define PROFILE_ADD(counter, value)
+#define PROFILE_MAX(counter, value)
+#define PROFILE_TIME_BEGIN(name)
+#define PROFILE_TIME_END(name, counter)
+#define PROFILE_HEAP_BEGIN(name)
+#define PROFILE_HEAP_END(name, counter)
+#define PROFILE_REPORT(tag)
+#define PROFILE_RESET()
+
+#endif
@@ -0,0 +1,82 @@
+#include "screen_geometry.h"
+
+static GRect s_bounds;
+
+#ifdef PBL_ROUND
+static GPoint s_center;
+static int s_radius;
+
+static int isqrt(int value)
+{
+  if (value <= 0) return 0;
+
+  int result = 0;
+  int bit = 1 << 30;
+  while (bit > value) bit >>= 2;
+
+  while (bit != 0)
+  {
+    if (value >= result + bit)
+    {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    }
+    else
+    {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return result;
+}
+
+// half width of the circle at vertical distance dy from center, -1 if outside
+static int get_half_chord(int dy, int radius)
+{
+  if (dy < 0) dy = -dy;
+  if (dy >= radius) return -1;
+
+  return isqrt(radius * radius - dy * dy);
+}
+#endif
+
+void screen_geometry_init(GRect bounds)
+{
+  s_bounds = bounds;
+
+#ifdef PBL_ROUND
+  s_center = GPoint(bounds.origin.x + bounds.size.w / 2, bounds.origin.y + bounds.size.h / 2);
+  s_radius = ((bounds.size.w < bounds.size.h) ? bounds.size.w : bounds.size.h) / 2;
+#endif
+}
+
+int screen_geometry_get_row_inset(int top, int height)
+{
+#ifdef PBL_ROUND
+  // the narrowest part of the band is the edge farthest from center
+  int dy_top = top - s_center.y;
+  int dy_bottom = top + height - s_center.y;
+  if (dy_top < 0) dy_top = -dy_top;
+  if (dy_bottom < 0) dy_bottom = -dy_bottom;
+
+  int half = get_half_chord((dy_top > dy_bottom) ? dy_top : dy_bottom, s_radius);
+  if (half < 0) return s_bounds.size.w / 2;
+
+  return s_center.x - s_bounds.origin.x - half;
+#else
+  return 0;
+#endif
+}
+
+bool screen_geometry_get_spawn_span(int y, int border, int* out_min_x, int* out_max_x)
+{
+  int inset = screen_geometry_get_row_inset(y - border, border * 2);
+  int min_x = s_bounds.origin.x + inset + border;
+  int max_x = s_bounds.origin.x + s_bounds.size.w - inset - border;
+  if (min_x > max_x) return false;
+
+  if (out_min_x) *out_min_x = min_x;
+  if (out_max_x) *out_max_x = max_x;
+  return true;
+}
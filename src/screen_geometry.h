@@ -0,0 +1,14 @@
+#pragma once
+#include <pebble.h>
+
+// visible area of the display. on round screens this is the inscribed circle,
+// otherwise the whole bounds rect.
+
+void screen_geometry_init(GRect bounds);
+
+// horizontal inset needed so a full-width row band [top, top + height) stays visible
+int screen_geometry_get_row_inset(int top, int height);
+
+// horizontal span (in bounds coordinates) where a square of half size `border`
+// centered on row y stays visible. return false if no such span exists.
+bool screen_geometry_get_spawn_span(int y, int border, int* out_min_x, int* out_max_x);
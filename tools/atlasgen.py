@@ -0,0 +1,478 @@
+#
+# Packs per-glyph images into the font atlases and writes the glyph table header.
+#
+# Glyph sources live in resources/glyphs/<size>/<glyph name>.png as 1-bit palette
+# PNGs (white glyph on black). The manifest lists every glyph and, for each atlas,
+# which glyphs it holds per platform. Only the listed glyphs are packed, into the
+# grid with the fewest resident bytes on the target.
+#
+# Color platforms get the background palette entry transparent, the time rows
+# composite with GCompOpSet over the window background, so a background change
+# recolors nothing.
+#
+# Cell platforms get a raw resource of one GBitmapFormat1Bit cell per glyph
+# instead of an image, read a glyph at a time by src/glyph_cache.c.
+#
+# The manifest's layouts give each platform its glyph sizes and layout
+# constants (default merged with the platform's entry), written as defines in
+# the platform's block of the header. Sizes without glyph sources are
+# resampled from the nearest larger source.
+#
+
+import fnmatch
+import json
+import os
+import struct
+import zlib
+
+PNG_SIGNATURE = b'\x89PNG\r\n\x1a\n'
+GLYPH_NONE = 0xFF
+MONO_PLATFORMS = ('aplite', 'diorite')
+RESAMPLE_GRID = 4   # samples per output pixel and axis
+
+
+# -----------------------------------------------------------------------------
+# 1-bit palette png
+# -----------------------------------------------------------------------------
+
+def _paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    """Return (width, height, palette bytes, rows of palette indices)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != PNG_SIGNATURE:
+        raise ValueError('{}: not a png'.format(path))
+
+    pos = 8
+    idat = b''
+    palette = None
+    while pos < len(data):
+        length, = struct.unpack('>I', data[pos:pos + 4])
+        kind = data[pos + 4:pos + 8]
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b'IHDR':
+            width, height, depth, color_type, _, _, interlace = struct.unpack('>IIBBBBB', body)
+            if depth != 1 or color_type != 3 or interlace != 0:
+                raise ValueError('{}: expected a non-interlaced 1-bit palette png'.format(path))
+        elif kind == b'PLTE':
+            palette = body
+        elif kind == b'IDAT':
+            idat += body
+
+    raw = zlib.decompress(idat)
+    stride = (width + 7) // 8
+    prev = bytearray(stride)
+    rows = []
+    offset = 0
+    for _ in range(height):
+        filter_type = raw[offset]
+        line = bytearray(raw[offset + 1:offset + 1 + stride])
+        offset += 1 + stride
+        for x in range(stride):
+            a = line[x - 1] if x > 0 else 0
+            b = prev[x]
+            c = prev[x - 1] if x > 0 else 0
+            if filter_type == 1:
+                line[x] = (line[x] + a) & 0xFF
+            elif filter_type == 2:
+                line[x] = (line[x] + b) & 0xFF
+            elif filter_type == 3:
+                line[x] = (line[x] + (a + b) // 2) & 0xFF
+            elif filter_type == 4:
+                line[x] = (line[x] + _paeth(a, b, c)) & 0xFF
+        rows.append([(line[x >> 3] >> (7 - (x & 7))) & 1 for x in range(width)])
+        prev = line
+
+    return width, height, palette, rows
+
+
+def _chunk(kind, body):
+    return struct.pack('>I', len(body)) + kind + body + struct.pack('>I', zlib.crc32(kind + body) & 0xFFFFFFFF)
+
+
+def encode_png(width, height, palette, rows, transparent=None):
+    """transparent: palette index written fully transparent, if any."""
+    raw = bytearray()
+    for row in rows:
+        raw.append(0)
+        line = bytearray((width + 7) // 8)
+        for x, value in enumerate(row):
+            if value:
+                line[x >> 3] |= 0x80 >> (x & 7)
+        raw += line
+
+    return (PNG_SIGNATURE +
+            _chunk(b'IHDR', struct.pack('>IIBBBBB', width, height, 1, 3, 0, 0, 0)) +
+            _chunk(b'PLTE', palette) +
+            (_chunk(b'tRNS', bytes(bytearray(0 if i == transparent else 255 for i in range(len(palette) // 3))))
+             if transparent is not None else b'') +
+            _chunk(b'IDAT', zlib.compress(bytes(raw), 9)) +
+            _chunk(b'IEND', b''))
+
+
+# -----------------------------------------------------------------------------
+# packing
+# -----------------------------------------------------------------------------
+
+def row_bytes(width, platform):
+    # black and white platforms load 1-bit images as GBitmapFormat1Bit with word
+    # aligned rows, color platforms as GBitmapFormat1BitPalette with byte aligned rows
+    if platform in MONO_PLATFORMS:
+        return (width + 31) // 32 * 4
+    return (width + 7) // 8
+
+
+def choose_grid(count, size, platform):
+    """Grid (num_x, num_y) holding count cells with the fewest resident bytes."""
+    best = None
+    for num_x in range(1, count + 1):
+        num_y = (count + num_x - 1) // num_x
+        resident = row_bytes(num_x * size, platform) * num_y * size
+        key = (resident, num_x * num_y - count, abs(num_x - num_y), -num_x)
+        if best is None or key < best[0]:
+            best = (key, num_x, num_y)
+
+    return best[1], best[2]
+
+
+def expand_glyphs(patterns, glyph_names):
+    result = []
+    for pattern in patterns:
+        matched = [name for name in glyph_names if fnmatch.fnmatchcase(name, pattern)]
+        if not matched:
+            raise ValueError('glyph pattern {} matches nothing'.format(pattern))
+        for name in matched:
+            if name not in result:
+                result.append(name)
+
+    return result
+
+
+def source_sizes(glyph_dir, name):
+    return sorted(int(entry) for entry in os.listdir(glyph_dir)
+                  if entry.isdigit() and os.path.exists(os.path.join(glyph_dir, entry, name.lower() + '.png')))
+
+
+def resample(rows, size):
+    """Scale square rows of palette indices to size, each output pixel taking
+    the index most of its samples fall on."""
+    source = len(rows)
+    result = []
+    for y in range(size):
+        row = []
+        for x in range(size):
+            counts = {}
+            for sy in range(RESAMPLE_GRID):
+                for sx in range(RESAMPLE_GRID):
+                    px = ((x * RESAMPLE_GRID + sx) * 2 + 1) * source // (size * RESAMPLE_GRID * 2)
+                    py = ((y * RESAMPLE_GRID + sy) * 2 + 1) * source // (size * RESAMPLE_GRID * 2)
+                    value = rows[py][px]
+                    counts[value] = counts.get(value, 0) + 1
+            # ties go to the background, index 1
+            row.append(max(sorted(counts), key=lambda value: (counts[value], value == 1)))
+        result.append(row)
+    return result
+
+
+def load_glyph(glyph_dir, size, name):
+    """(palette, rows) of a glyph at size, resampled if there is no source of that size."""
+    sizes = source_sizes(glyph_dir, name)
+    if not sizes:
+        raise ValueError('no source image for glyph {}'.format(name))
+    larger = [s for s in sizes if s >= size]
+    source = larger[0] if larger else sizes[-1]
+
+    path = os.path.join(glyph_dir, str(source), name.lower() + '.png')
+    width, height, palette, rows = read_png(path)
+    if (width, height) != (source, source):
+        raise ValueError('{}: expected {}x{}'.format(path, source, source))
+    if source != size:
+        rows = resample(rows, size)
+
+    return palette, rows
+
+
+def atlas_grid(size, glyphs, platform):
+    """The grid an atlas of glyphs is packed in, without the pixels."""
+    num_x, num_y = choose_grid(len(glyphs), size, platform)
+    return {
+        'num_x': num_x,
+        'num_y': num_y,
+        'cells': dict((name, index) for index, name in enumerate(glyphs)),
+        'resident': row_bytes(num_x * size, platform) * num_y * size,
+    }
+
+
+def pack_atlas(glyph_dir, size, glyphs, platform):
+    num_x, num_y = choose_grid(len(glyphs), size, platform)
+    width, height = num_x * size, num_y * size
+
+    palette = None
+    rows = [[1] * width for _ in range(height)]   # index 1 is the black background
+    cells = {}
+    for index, name in enumerate(glyphs):
+        glyph_palette, glyph_rows = load_glyph(glyph_dir, size, name)
+        if palette is None:
+            palette = glyph_palette
+        elif glyph_palette != palette:
+            raise ValueError('{}: palette differs from other glyphs'.format(name))
+
+        left, top = (index % num_x) * size, (index // num_x) * size
+        for y in range(size):
+            rows[top + y][left:left + size] = glyph_rows[y]
+        cells[name] = index
+
+    transparent = None if platform in MONO_PLATFORMS else get_background_index(palette)
+    return {
+        'num_x': num_x,
+        'num_y': num_y,
+        'cells': cells,
+        'palette': palette,
+        'transparent': transparent,
+        'png': encode_png(width, height, palette, rows, transparent),
+        'resident': row_bytes(width, platform) * height,
+    }
+
+
+def is_white(palette, index):
+    r, g, b = bytearray(palette[index * 3:index * 3 + 3])
+    return r + g + b > 3 * 127
+
+
+def get_background_index(palette):
+    return 0 if not is_white(palette, 0) else 1
+
+
+def pack_cells(glyph_dir, size, glyphs, platform):
+    """Glyphs as consecutive cells laid out like a GBitmapFormat1Bit bitmap of
+    one cell: word aligned rows, least significant bit leftmost, 1 is white."""
+    stride = row_bytes(size, MONO_PLATFORMS[0])
+    data = bytearray()
+    cells = {}
+    for index, name in enumerate(glyphs):
+        palette, glyph_rows = load_glyph(glyph_dir, size, name)
+
+        for row in glyph_rows:
+            line = bytearray(stride)
+            for x, value in enumerate(row):
+                if is_white(palette, value):
+                    line[x >> 3] |= 1 << (x & 7)
+            data += line
+        cells[name] = index
+
+    num_x, num_y = choose_grid(len(glyphs), size, platform)
+    return {
+        'num_x': len(glyphs),
+        'num_y': 1,
+        'cells': cells,
+        'cell_bytes': stride * size,
+        'raw': bytes(data),
+        'resident': row_bytes(num_x * size, platform) * num_y * size,
+    }
+
+
+# -----------------------------------------------------------------------------
+# output
+# -----------------------------------------------------------------------------
+
+def write_if_changed(path, data):
+    if isinstance(data, str):
+        data = data.encode('utf-8')
+    if os.path.exists(path):
+        with open(path, 'rb') as f:
+            if f.read() == data:
+                return
+    folder = os.path.dirname(path)
+    if not os.path.isdir(folder):
+        os.makedirs(folder)
+    with open(path, 'wb') as f:
+        f.write(data)
+
+
+def atlas_table_source(atlas, size, packed, glyph_names, suffix=''):
+    cells = ', '.join(str(packed['cells'].get(name, GLYPH_NONE)) for name in glyph_names)
+    return ('  static const struct GlyphAtlasInfo s_glyph_atlas_{role}{suffix} = {{ {size}, {num_x}, {num_y}, {{ {cells} }} }};\n'
+            .format(role=atlas['role'], suffix=suffix, size=size, num_x=packed['num_x'], num_y=packed['num_y'], cells=cells))
+
+
+def get_layout(manifest, platform):
+    """Default layout merged with the platform's, sizes keyed by atlas file."""
+    layouts = manifest.get('layouts', {})
+    sizes = dict((atlas['file'], atlas['size']) for atlas in manifest['atlases'])
+    defines = {}
+    for name in ('default', platform):
+        layout = layouts.get(name, {})
+        sizes.update(layout.get('sizes', {}))
+        defines.update(layout.get('defines', {}))
+    return {'sizes': sizes, 'defines': defines}
+
+
+def layout_source(manifest, layout):
+    lines = []
+    for atlas in manifest['atlases']:
+        lines.append('  #define NUM_{}_SIZE  {}\n'.format(atlas['role'].upper(), layout['sizes'][atlas['file']]))
+    for name in sorted(layout['defines']):
+        lines.append('  #define {}  {}\n'.format(name, layout['defines'][name]))
+    return lines
+
+
+def cell_defines_source(packed_atlases):
+    resident = sum(packed['resident'] for packed in packed_atlases)
+    lines = [
+        '  // fonts are read a glyph at a time, see glyph_cache.h\n',
+        '  #define GLYPH_ATLAS_CELLS\n',
+        '  #define GLYPH_ATLAS_RESIDENT_BYTES  {}   // the atlases kept whole, for comparison\n'.format(resident),
+    ]
+    return lines
+
+
+def header_source(manifest, glyph_names, tables, derive):
+    lines = [
+        '// generated by tools/atlasgen.py from resources/glyphs/manifest.json, do not edit\n',
+        '#pragma once\n',
+        '#include <pebble.h>\n',
+        '\n',
+        '#define GLYPH_NONE  {}\n'.format(GLYPH_NONE),
+    ]
+    if derive:
+        lines += [
+            '\n',
+            '// smaller atlases are downscaled from the largest at load time. their images\n',
+            '// hold only the glyphs it lacks, at its size, see s_glyph_atlas_<role>_source\n',
+            '#define GLYPH_ATLAS_DERIVED\n',
+        ]
+    lines += [
+        '\n',
+        'enum Glyph\n',
+        '{\n',
+    ]
+    for index, name in enumerate(glyph_names):
+        lines.append('  GLYPH_{} = {},\n'.format(name, index))
+    lines += [
+        '  GLYPH_NUM\n',
+        '};\n',
+        '\n',
+        'struct GlyphAtlasInfo\n',
+        '{\n',
+        '  uint8_t size;                 // cell size in pixels\n',
+        '  uint8_t num_x;                // cells per atlas row\n',
+        '  uint8_t num_y;                // cell rows\n',
+        '  uint8_t cells[GLYPH_NUM];     // cell index of each glyph, GLYPH_NONE if not packed\n',
+        '};\n',
+        '\n',
+    ]
+
+    overrides = [p for p in tables if p != 'default']
+    for i, platform in enumerate(overrides):
+        lines.append('{} defined(PBL_PLATFORM_{})\n'.format('#if' if i == 0 else '#elif', platform.upper()))
+        lines += tables[platform]
+    if overrides:
+        lines.append('#else\n')
+    lines += tables['default']
+    if overrides:
+        lines.append('#endif\n')
+
+    return ''.join(lines)
+
+
+def generate(manifest_path, image_dir, header_path, platforms, derive=False, cell_platforms=(), log=None):
+    """Write the atlas images and glyph table header.
+
+    With derive set, the smaller atlases are downscaled on the watch: the
+    largest keeps its own glyphs, and a smaller one's image holds only the
+    glyphs it lacks, at its size, with a s_glyph_atlas_<role>_source table of
+    their cells (a 1x1 placeholder if there are none).
+    Platforms in cell_platforms get <file>~<platform>.cells raw resources
+    instead, derive does not apply to them.
+    """
+    with open(manifest_path) as f:
+        manifest = json.load(f)
+    glyph_dir = os.path.dirname(manifest_path)
+    glyph_names = manifest['glyphs']
+    atlases = manifest['atlases']
+
+    variants = set(['default'])
+    for atlas in atlases:
+        variants.update(p for p in platforms if p in atlas['glyphs'])
+    variants.update(p for p in platforms if p in cell_platforms)
+    variants.update(p for p in platforms if p in manifest.get('layouts', {}))
+
+    tables = {}
+    default_images = {}
+    for platform in sorted(variants, key=lambda p: (p != 'default', p)):
+        suffix = '' if platform == 'default' else '~' + platform
+        target = platform if platform in MONO_PLATFORMS else 'default'
+        layout = get_layout(manifest, platform)
+        sizes = layout['sizes']
+        master = max(atlases, key=lambda atlas: sizes[atlas['file']])
+        tables[platform] = layout_source(manifest, layout)
+
+        def atlas_glyphs(atlas):
+            return expand_glyphs(atlas['glyphs'].get(platform, atlas['glyphs']['default']), glyph_names)
+
+        if platform in cell_platforms:
+            packed_atlases = []
+            table_lines = []
+            for atlas in atlases:
+                glyphs = atlas_glyphs(atlas)
+                packed = pack_cells(glyph_dir, sizes[atlas['file']], glyphs, target)
+                packed_atlases.append(packed)
+
+                write_if_changed(os.path.join(image_dir, atlas['file'] + suffix + '.cells'), packed['raw'])
+                table_lines.append(atlas_table_source(atlas, sizes[atlas['file']], packed, glyph_names))
+
+                if log:
+                    log('atlas {}{}: {} glyphs in {}-byte cells, {} resource bytes, {} resident bytes as an atlas'.format(
+                        atlas['file'], suffix, len(glyphs), packed['cell_bytes'], len(packed['raw']), packed['resident']))
+
+            tables[platform] += cell_defines_source(packed_atlases) + table_lines
+            continue
+
+        if derive:
+            master_glyphs = atlas_glyphs(master)
+            master_packed = pack_atlas(glyph_dir, sizes[master['file']], master_glyphs, target)
+
+        for atlas in atlases:
+            size = sizes[atlas['file']]
+            glyphs = atlas_glyphs(atlas)
+            if not derive or atlas is master:
+                packed = master_packed if derive else pack_atlas(glyph_dir, size, glyphs, target)
+                image = packed['png']
+                resident = packed['resident']
+            else:
+                # the glyphs the master lacks, at its size, for the watch to scale down
+                extra = [name for name in glyphs if name not in master_glyphs]
+                if extra:
+                    source = pack_atlas(glyph_dir, sizes[master['file']], extra, target)
+                else:
+                    source = {'num_x': 1, 'num_y': 1, 'cells': {},
+                              'png': encode_png(1, 1, master_packed['palette'], [[1]], master_packed['transparent'])}
+                packed = atlas_grid(size, glyphs, target)
+                image = source['png']
+                resident = packed['resident']
+                tables[platform].append(atlas_table_source(atlas, sizes[master['file']], source, glyph_names, '_source'))
+
+            # variants that only differ in layout constants share the default image
+            image_path = os.path.join(image_dir, atlas['file'] + suffix + '.png')
+            if platform == 'default':
+                default_images[atlas['file']] = image
+            if platform != 'default' and image == default_images[atlas['file']]:
+                if os.path.exists(image_path):
+                    os.remove(image_path)
+            else:
+                write_if_changed(image_path, image)
+            tables[platform].append(atlas_table_source(atlas, size, packed, glyph_names))
+
+            if log:
+                log('atlas {}{}: {} glyphs in {}x{} cells, {} image bytes, {} resident bytes'.format(
+                    atlas['file'], suffix, len(glyphs), packed['num_x'], packed['num_y'], len(image), resident))
+
+    write_if_changed(header_path, header_source(manifest, glyph_names, tables, derive))
@@ -0,0 +1,66 @@
+#!/usr/bin/env python
+"""Run a --profile build in every platform's emulator and collect its startup
+counters, benchmarks and a screenshot of the first frames.
+
+  pebble build -- --profile
+  tools/bench_platforms.py --out bench
+  tools/profile_report.py --diff bench/basalt.json bench/emery.json
+
+Platforms default to the targetPlatforms of appinfo.json. Screenshots show the
+emulator's current time, they are for checking each platform's layout by eye.
+Builds compare the same way, e.g. the font loads of two revisions:
+
+  tools/bench_platforms.py --out bench/new basalt chalk emery
+  tools/profile_report.py --diff bench/old/basalt.json bench/new/basalt.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import profile_report
+import sim_day
+
+APPINFO = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'appinfo.json')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('platforms', nargs='*', help='emulator platforms, default all targets')
+    parser.add_argument('--out', default='bench', help='folder for the logs, json reports and screenshots')
+    parser.add_argument('--timeout', type=int, default=300, help='seconds to wait per platform, default 300')
+    args = parser.parse_args()
+
+    platforms = args.platforms
+    if not platforms:
+        with open(APPINFO) as f:
+            platforms = json.load(f)['targetPlatforms']
+    if not os.path.isdir(args.out):
+        os.makedirs(args.out)
+
+    rows = []
+    for platform in platforms:
+        path = os.path.join(args.out, platform)
+        lines = sim_day.capture(platform, path + '.log', args.timeout, done_marker='BENCH,done')
+        report = profile_report.parse(lines)
+        with open(path + '.json', 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write('\n')
+        subprocess.call(['pebble', 'screenshot', '--emulator', platform, path + '.png'])
+
+        startup = report['counters'].get('startup', {})
+        rows.append((platform, startup.get('first_frame_ms'), startup.get('font_load_ms'),
+                     startup.get('font_heap_bytes'), startup.get('font_resident_bytes')))
+
+    print('{:<10} {:>15} {:>13} {:>16} {:>20}'.format(
+        'platform', 'first frame ms', 'font load ms', 'font heap bytes', 'font resident bytes'))
+    for row in rows:
+        print('{:<10} {:>15} {:>13} {:>16} {:>20}'.format(*row))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,137 @@
+#
+# Inlines config-web/ into one page and writes it as a base64 data uri for the
+# companion js, so the settings open without fetching anything.
+#
+# Stylesheets and scripts are replaced by their minified copies, web fonts by
+# an ascii subset made with fontTools, or as they are with subset_fonts off.
+# Subsetting without fontTools fails rather than bundle a larger page. The
+# companion passes the stored config in the uri fragment (data uris have no
+# query string), see getQueryParam in config-klk.html.
+#
+
+import base64
+import io
+import json
+import os
+import re
+
+from atlasgen import write_if_changed
+
+STYLESHEET = re.compile(r'<link rel="stylesheet" href="([^"]+)">')
+SCRIPT = re.compile(r'<script type="text/javascript" src="([^"]+)"></script>')
+FONT_FACE = re.compile(r'@font-face\s*\{[^}]*\}')
+FONT_URL = re.compile(r'url\("([^"]+)"\)')
+COMMENT = re.compile(r'<!--.*?-->', re.S)
+
+
+def read_text(path):
+    with io.open(path, encoding='utf-8') as f:
+        return f.read()
+
+
+def minified_path(path):
+    root, ext = os.path.splitext(path)
+    return root + '.min' + ext if os.path.exists(root + '.min' + ext) else path
+
+
+def find_case_insensitive(path):
+    # the stylesheet and the font files disagree on case
+    folder, name = os.path.split(path)
+    for entry in os.listdir(folder):
+        if entry.lower() == name.lower():
+            return os.path.join(folder, entry)
+    return None
+
+
+def subset_font(path):
+    try:
+        from fontTools import subset
+    except ImportError:
+        raise RuntimeError('config page: subsetting {} needs fontTools (pip install fonttools), '
+                           'or configure with --whole-fonts to inline them whole'.format(os.path.basename(path)))
+
+    # the page is english, hinting and most layout tables only add weight
+    options = subset.Options()
+    options.flavor = 'woff'
+    options.hinting = False
+    options.desubroutinize = True
+    options.layout_features = ['kern']
+    try:
+        font = subset.load_font(path, options)
+    except ImportError:
+        raise RuntimeError('config page: subsetting {} needs brotli for woff2 (pip install brotli), '
+                           'or configure with --whole-fonts to inline them whole'.format(os.path.basename(path)))
+
+    subsetter = subset.Subsetter(options)
+    subsetter.populate(unicodes=range(0x20, 0x7F))
+    subsetter.subset(font)
+    if not font.getBestCmap():
+        return b''      # none of the page's characters, browsers reject an empty cmap
+    out = io.BytesIO()
+    subset.save_font(font, out, options)
+    return out.getvalue()
+
+
+def read_font(path, subset_fonts, log):
+    if subset_fonts:
+        return subset_font(path)
+
+    # the page looks the same, only larger
+    with open(path, 'rb') as f:
+        data = f.read()
+    if log:
+        log('config page: {} inlined whole, {} bytes'.format(os.path.basename(path), len(data)))
+    return data
+
+
+def inline_fonts(css, css_dir, subset_fonts, log):
+    def replace(match):
+        rule = match.group(0)
+        url = FONT_URL.search(rule)
+        path = url and find_case_insensitive(os.path.normpath(os.path.join(css_dir, url.group(1))))
+        if not path:
+            raise IOError('config page: no font file for {}'.format(url.group(1) if url else rule))
+        data = read_font(path, subset_fonts, log)
+        if not data:
+            if log:
+                log('config page: {} has no ascii glyphs, left out'.format(os.path.basename(path)))
+            return ''
+        uri = 'data:font/woff;base64,' + base64.b64encode(data).decode('ascii')
+        return rule.replace(url.group(0), 'url("{}")'.format(uri))
+
+    return FONT_FACE.sub(replace, css)
+
+
+def minify_html(html):
+    # line based so inline scripts keep their line comments intact
+    html = COMMENT.sub('', html)
+    return '\n'.join(line.strip() for line in html.splitlines() if line.strip())
+
+
+def bundle_page(config_dir, page, subset_fonts=True, log=None):
+    html = read_text(os.path.join(config_dir, page))
+
+    def inline_stylesheet(match):
+        path = minified_path(os.path.join(config_dir, match.group(1)))
+        return '<style>' + inline_fonts(read_text(path), os.path.dirname(path), subset_fonts, log) + '</style>'
+
+    def inline_script(match):
+        path = minified_path(os.path.join(config_dir, match.group(1)))
+        return '<script>' + read_text(path).replace('</script', '<\\/script') + '</script>'
+
+    html = STYLESHEET.sub(inline_stylesheet, html)
+    html = SCRIPT.sub(inline_script, html)
+    return minify_html(html)
+
+
+def generate(config_dir, page, js_path, subset_fonts=True, log=None):
+    html = bundle_page(config_dir, page, subset_fonts, log).encode('utf-8')
+    uri = 'data:text/html;charset=utf-8;base64,' + base64.b64encode(html).decode('ascii')
+
+    if log:
+        log('config page: {} bytes of html, {} bytes as data uri'.format(len(html), len(uri)))
+
+    source = ('// generated by tools/configbundle.py from config-web/{}, do not edit\n'
+              'var CONFIG_PAGE_URI = {};\n').format(page, json.dumps(uri))
+    write_if_changed(js_path, source)
+
@@ -0,0 +1,350 @@
+// host benchmarks of the face's hot paths, the ones its --profile build times
+// on the watch (run_benchmarks in src/pebble-klk.c), the star drawing that
+// needs a graphics context there, and a launch up to its first frame with the
+// heap it leaves taken. the face is included whole to reach its static
+// functions, see tools/host_bench.py for running these.
+//
+//   bench                          all benchmarks, json on stdout
+//   bench --list
+//   bench --run NAME --iterations N   one benchmark, no output, for perf stat
+
+#include <time.h>
+#include "face.h"
+
+#define BENCH_REPEAT  5
+#ifndef PROFILE
+#define BENCH_TRANSITION_FRAMES 48   // 1.6 s at 30 fps
+#endif
+#define BENCH_TIME    1792804140   // 2026-10-24 01:09, local
+
+struct Bench
+{
+  const char* name;
+  int iterations;
+  void (*run)(int iterations);
+};
+
+static volatile unsigned int s_sink;
+
+static void bench_calculate_digits(int iterations)
+{
+  int digits[NUMERAL_MAX_LENGTH];
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (int v = 0; v < 100; ++v) s_sink += calculate_digits(v, digits);
+  }
+}
+
+static void bench_get_hour_atlas(int iterations)
+{
+  struct CharAtlas atlas;
+  for (int i = 0; i < iterations; ++i)
+  {
+    get_hour_atlas(&atlas, i % 24, i % 60, false, true, i & 1);
+    s_sink += atlas.num;
+  }
+}
+
+static void bench_get_min_atlas(int iterations)
+{
+  struct CharAtlas atlas;
+  for (int i = 0; i < iterations; ++i)
+  {
+    get_min_atlas(&atlas, i % 60, i & 1);
+    s_sink += atlas.num;
+  }
+}
+
+static void bench_get_date_atlas(int iterations)
+{
+  struct CharAtlas atlas;
+  for (int i = 0; i < iterations; ++i)
+  {
+    get_date_atlas(&atlas, 1 + i % 31, true, i & 1);
+    s_sink += atlas.num;
+  }
+}
+
+static void bench_get_month_atlas(int iterations)
+{
+  struct CharAtlas atlas;
+  for (int i = 0; i < iterations; ++i)
+  {
+    get_month_atlas(&atlas, i % 12, i & 1, true, false);
+    s_sink += atlas.num;
+  }
+}
+
+static void bench_refresh_time(int iterations)
+{
+  for (int i = 0; i < iterations; ++i) refresh_time();
+}
+
+// a whole transition, a frame each 1/30 s as the watch delivers them
+static void bench_anim_transition(int iterations)
+{
+  for (int i = 0; i < iterations; ++i)
+  {
+    anim_setup(NULL);
+    for (int f = 0; f <= BENCH_TRANSITION_FRAMES; ++f)
+      anim_update(NULL, ANIMATION_NORMALIZED_MAX * f / BENCH_TRANSITION_FRAMES);
+    anim_teardown(NULL);
+  }
+}
+
+// the stars of a frame halfway through a transition
+static void bench_star_layer_update(int iterations)
+{
+  anim_setup(NULL);
+  for (int f = 0; f <= BENCH_TRANSITION_FRAMES / 2; ++f)
+    anim_update(NULL, ANIMATION_NORMALIZED_MAX * f / BENCH_TRANSITION_FRAMES);
+
+  GContext* ctx = host_get_layer_context(star_layer);
+  for (int i = 0; i < iterations; ++i) star_layer_update_callback(star_layer, ctx);
+
+  anim_teardown(NULL);
+}
+
+// a launch up to its first frame: the window, the fonts it preloads and the
+// first frame drawn, after the face before it is taken down
+static void bench_startup(int iterations)
+{
+  for (int i = 0; i < iterations; ++i)
+  {
+    deinit();
+    init();
+    host_render();
+  }
+}
+
+// the glyphs of the first frame drawn straight into the frame buffer, as the
+// --blit-glyphs build's glyph layer draws them
+static void bench_glyph_blit(int iterations)
+{
+  const GBitmap* bitmaps[ROW_NUM * CHAR_MAX_LENGTH];
+  GPoint origins[ROW_NUM * CHAR_MAX_LENGTH];
+  GRect frames[ROW_NUM * CHAR_MAX_LENGTH];
+  int num = 0;
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+    {
+      Layer* layer = bitmap_layer_get_layer(row_layers[i][j]);
+      if (layer_get_hidden(layer) || bitmap_layer_get_bitmap(row_layers[i][j]) == NULL) continue;
+
+      GRect bounds = layer_get_bounds(layer);
+      bitmaps[num] = bitmap_layer_get_bitmap(row_layers[i][j]);
+      origins[num] = GPoint(-bounds.origin.x, -bounds.origin.y);
+      frames[num] = layer_get_frame(layer);
+      ++num;
+    }
+  }
+
+  GBitmap* frame_buffer = host_get_frame_buffer();
+  for (int i = 0; i < iterations; ++i)
+  {
+    for (int j = 0; j < num; ++j) glyph_blit(frame_buffer, bitmaps[j], origins[j], frames[j], time_comp_mode);
+  }
+}
+
+// the scene snapshot's restore of a frame, the frame buffer copied whole
+static void bench_snapshot_restore(int iterations)
+{
+  static uint8_t s_snapshot[64 * 1024];
+  GBitmap* frame_buffer = host_get_frame_buffer();
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+  GBitmapDataRowInfo last_row = gbitmap_get_data_row_info(frame_buffer, bounds.size.h - 1);
+  size_t size = PBL_IF_ROUND_ELSE(last_row.data + last_row.max_x + 1 - gbitmap_get_data(frame_buffer),
+                                  (size_t)gbitmap_get_bytes_per_row(frame_buffer) * bounds.size.h);
+  memcpy(s_snapshot, gbitmap_get_data(frame_buffer), size);
+  for (int i = 0; i < iterations; ++i)
+  {
+    memcpy(gbitmap_get_data(frame_buffer), s_snapshot, size);
+    s_sink += gbitmap_get_data(frame_buffer)[i % size];
+  }
+}
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+// a frame of the 51 px timeline peek moving in, the glyph layers moved along
+static void bench_unobstructed_change(int iterations)
+{
+  GRect bounds = layer_get_bounds(window_get_root_layer(window));
+  unobstructed_will_change(GRect(0, 0, bounds.size.w, bounds.size.h - 51), NULL);
+  for (int i = 0; i < iterations; ++i) unobstructed_change(i % (ANIMATION_NORMALIZED_MAX + 1), NULL);
+  unobstructed_did_change(NULL);
+}
+#endif
+
+#ifdef PBL_COLOR
+// identity changes keep the font as it is
+static void bench_replace_gbitmap_color(int iterations)
+{
+  GBitmap* bitmap = get_font_bitmap(FONT_L);
+  for (int i = 0; i < iterations; ++i) replace_gbitmap_color(GColorWhite, GColorWhite, bitmap, NULL);
+}
+#endif
+
+#ifdef PBL_COLOR
+#define REMAP_MAX_SIZE (832 * 128)   // emery's largest atlas, 8-bit
+
+static uint8_t s_remap_data[REMAP_MAX_SIZE];
+static GColor s_remap_palette[16];
+
+// set_color's remap of a font's atlas as if it were stored in another format.
+// the pixels are the host's, an 8-bit atlas is more than the app heap holds
+static void bench_remap(GBitmapFormat format, enum FontType font, int iterations)
+{
+  GSize size = gbitmap_get_bounds(get_font_bitmap(font)).size;
+  uint16_t row_size = (format == GBitmapFormat8Bit) ? size.w
+                    : (format == GBitmapFormat4BitPalette) ? (size.w + 1) / 2
+                    : (format == GBitmapFormat2BitPalette) ? (size.w + 3) / 4
+                    : (size.w + 7) / 8;
+  if (row_size * size.h > REMAP_MAX_SIZE) return;
+
+  GBitmap* bitmap = gbitmap_create_blank_with_palette(GSize(1, 1), format, s_remap_palette, false);
+  gbitmap_set_data(bitmap, s_remap_data, format, row_size, false);
+  gbitmap_set_bounds(bitmap, GRect(0, 0, size.w, size.h));
+
+  GColor lut[GCOLOR_LUT_SIZE];
+  gcolor_lut_init_identity(lut);
+  gcolor_lut_set(lut, GColorWhite, GColorBlack);
+  gcolor_lut_set(lut, GColorBlack, GColorWhite);
+  for (int i = 0; i < iterations; ++i) remap_gbitmap_colors(lut, bitmap, NULL);
+
+  gbitmap_destroy(bitmap);
+}
+
+#define REMAP_BENCH(format, font) \
+  static void bench_remap_##format##_##font(int iterations) { bench_remap(GBitmapFormat##format, font, iterations); }
+
+REMAP_BENCH(1BitPalette, FONT_S_DATE)
+REMAP_BENCH(1BitPalette, FONT_M)
+REMAP_BENCH(1BitPalette, FONT_L)
+REMAP_BENCH(2BitPalette, FONT_L)
+REMAP_BENCH(4BitPalette, FONT_L)
+REMAP_BENCH(8Bit, FONT_S_DATE)
+REMAP_BENCH(8Bit, FONT_M)
+REMAP_BENCH(8Bit, FONT_L)
+#endif
+
+static void bench_hex_string_to_uint(int iterations)
+{
+  for (int i = 0; i < iterations; ++i) s_sink += hex_string_to_uint("FFAA55");
+}
+
+static const struct Bench s_benches[] = {
+  { "calculate_digits",           20000,    bench_calculate_digits },
+  { "get_hour_atlas",             2000000,  bench_get_hour_atlas },
+  { "get_min_atlas",              2000000,  bench_get_min_atlas },
+  { "get_date_atlas",             2000000,  bench_get_date_atlas },
+  { "get_month_atlas",            2000000,  bench_get_month_atlas },
+  { "refresh_time",               20000,    bench_refresh_time },
+  { "anim_transition",            5000,     bench_anim_transition },
+  { "star_layer_update_callback", 20000,    bench_star_layer_update },
+  { "startup",                    2000,     bench_startup },
+  { "glyph_blit",                 20000,    bench_glyph_blit },
+  { "snapshot_restore",           200000,   bench_snapshot_restore },
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+  { "unobstructed_change",        200000,   bench_unobstructed_change },
+#endif
+#ifdef PBL_COLOR
+  { "replace_gbitmap_color",      20000,    bench_replace_gbitmap_color },
+  { "remap_1bitpalette_font_s",   2000000,  bench_remap_1BitPalette_FONT_S_DATE },
+  { "remap_1bitpalette_font_m",   2000000,  bench_remap_1BitPalette_FONT_M },
+  { "remap_1bitpalette_font_l",   2000000,  bench_remap_1BitPalette_FONT_L },
+  { "remap_2bitpalette_font_l",   2000000,  bench_remap_2BitPalette_FONT_L },
+  { "remap_4bitpalette_font_l",   2000000,  bench_remap_4BitPalette_FONT_L },
+  { "remap_8bit_font_s",          2000,     bench_remap_8Bit_FONT_S_DATE },
+  { "remap_8bit_font_m",          2000,     bench_remap_8Bit_FONT_M },
+  { "remap_8bit_font_l",          2000,     bench_remap_8Bit_FONT_L },
+#endif
+  { "hex_string_to_uint",         5000000,  bench_hex_string_to_uint },
+};
+
+static double get_seconds(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static const struct Bench* find_bench(const char* name)
+{
+  for (unsigned int i = 0; i < ARRAY_LENGTH(s_benches); ++i)
+  {
+    if (strcmp(s_benches[i].name, name) == 0) return &s_benches[i];
+  }
+  return NULL;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+int main(int argc, char** argv)
+{
+  const char* run_name = NULL;
+  int run_iterations = -1;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--list") == 0)
+    {
+      for (unsigned int j = 0; j < ARRAY_LENGTH(s_benches); ++j) printf("%s %d\n", s_benches[j].name, s_benches[j].iterations);
+      return 0;
+    }
+    if (strcmp(argv[i], "--run") == 0 && i + 1 < argc) run_name = argv[++i];
+    else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) run_iterations = atoi(argv[++i]);
+    else
+    {
+      fprintf(stderr, "usage: %s [--list | --run NAME [--iterations N]]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  start_face(BENCH_TIME);
+  size_t startup_heap_bytes = heap_bytes_used();
+  size_t startup_largest_free = host_heap_largest_free();
+  uint32_t startup_allocations = host_heap_allocations();
+
+  if (run_name)
+  {
+    const struct Bench* bench = find_bench(run_name);
+    if (bench == NULL)
+    {
+      fprintf(stderr, "no benchmark %s\n", run_name);
+      return 2;
+    }
+    bench->run(run_iterations >= 0 ? run_iterations : bench->iterations);
+    deinit();
+    return 0;
+  }
+
+  printf("{\n  \"platform\": \"%s\",\n  \"bench\": {", get_platform_name());
+  for (unsigned int i = 0; i < ARRAY_LENGTH(s_benches); ++i)
+  {
+    const struct Bench* bench = &s_benches[i];
+    double seconds[BENCH_REPEAT];
+    for (int r = 0; r < BENCH_REPEAT; ++r)
+    {
+      double start = get_seconds();
+      bench->run(bench->iterations);
+      seconds[r] = get_seconds() - start;
+    }
+    qsort(seconds, BENCH_REPEAT, sizeof(double), compare_doubles);
+
+    // the median run
+    double total_ms = seconds[BENCH_REPEAT / 2] * 1000;
+    printf("%s\n    \"%s\": { \"iterations\": %d, \"total_ms\": %.3f, \"us_per_iteration\": %.4f }",
+           i ? "," : "", bench->name, bench->iterations, total_ms, total_ms * 1000 / bench->iterations);
+  }
+  // the heap a launch leaves taken, as the --profile build reports it at startup
+  printf("\n  },\n  \"counters\": {\n");
+  printf("    \"startup_heap_bytes\": %u,\n    \"startup_largest_free_bytes\": %u,\n    \"startup_allocations\": %u\n",
+         (unsigned int)startup_heap_bytes, (unsigned int)startup_largest_free, (unsigned int)startup_allocations);
+  printf("  }\n}\n");
+
+  deinit();
+  return 0;
+}
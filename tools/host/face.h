@@ -0,0 +1,39 @@
+#pragma once
+
+// the face whole, for host programs that call its static functions. include
+// it once, in place of building src/pebble-klk.c.
+
+// its main is not the program's, and returns by falling off the end as main may
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type"
+#define main klk_main
+#include "../../src/pebble-klk.c"
+#undef main
+#pragma GCC diagnostic pop
+
+#include "host.h"
+
+static const char* get_platform_name(void)
+{
+#if defined(PBL_PLATFORM_APLITE)
+  return "aplite";
+#elif defined(PBL_PLATFORM_BASALT)
+  return "basalt";
+#elif defined(PBL_PLATFORM_CHALK)
+  return "chalk";
+#elif defined(PBL_PLATFORM_DIORITE)
+  return "diorite";
+#else
+  return "emery";
+#endif
+}
+
+// launched as on the watch at a local time, up to the first frame and the
+// fonts it preloads
+static void start_face(time_t local_time)
+{
+  host_set_time(local_time);
+  host_set_log_level(APP_LOG_LEVEL_WARNING);
+  init();
+  host_run_for(1000);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <pebble.h>
+
+// drives the host build of the face (see pebble.h). time is simulated: it only
+// moves while app_event_loop or host_run_for process events, so runs are
+// deterministic and as fast as the host allows.
+
+// resources of the platform, written by tools/host/hostres.py
+struct HostResource
+{
+  uint32_t id;
+  const uint8_t* data;
+  uint32_t size;
+  bool is_bitmap;
+  GBitmapFormat format;
+  uint16_t width;
+  uint16_t height;
+  uint16_t row_size;
+  const uint8_t* palette;   // argb, after the pixels in the loaded bitmap
+  uint8_t palette_size;
+};
+
+extern const struct HostResource host_resources[];
+extern const int host_resource_num;
+
+// setup, before the face's init
+void host_set_time(time_t local_time);
+void host_set_24h_style(bool is_24h);
+void host_set_battery(BatteryChargeState state);
+void host_set_log_level(uint8_t level);           // messages above it are dropped, default APP_LOG_LEVEL_INFO
+void host_stop_on_log(const char* marker);        // app_event_loop returns after a message containing it
+void host_set_run_limit(uint32_t ms);             // app_event_loop returns after this much simulated time
+void host_set_outbox_result(AppMessageResult result);   // what sent messages report, default APP_MSG_OK
+
+// events
+void host_run_for(uint32_t ms);
+bool host_is_stopped(void);
+void host_render(void);                            // redraw the window now, dirty or not
+void host_deliver_message(const uint8_t* buffer, uint16_t size);
+void host_start_unobstructed_change(int obstruction_height, uint32_t duration_ms);
+
+// state
+GBitmap* host_get_frame_buffer(void);
+GContext* host_get_layer_context(Layer* layer);    // for calling a layer's update proc directly
+void host_get_frame_rgb(uint8_t* rgb);             // frame buffer as 8 bit rgb, outside the round display black
+uint32_t host_get_render_count(void);
+const uint8_t* host_get_last_outbox(uint16_t* size);
+uint32_t host_get_outbox_count(void);
+uint32_t host_get_scheduled_animations(void);     // animations running now
+
+// the app heap, sized as the platform's
+size_t host_heap_largest_free(void);
+uint32_t host_heap_allocations(void);              // host_malloc calls so far
+
+// persist
+uint32_t host_get_persist_writes(void);            // writes and deletes so far
+void host_persist_clear(void);
@@ -0,0 +1,169 @@
+#!/usr/bin/env python
+"""Write a platform's resources as C for the host build (see Makefile).
+
+  hostres.py --atlas
+  hostres.py basalt build/basalt
+  hostres.py --atlas --derive --atlas-dir build/derived/atlas basalt build/derived/basalt
+
+--atlas packs the font atlases and glyph table header for every target of
+appinfo.json, as wscript does, --derive as --derive-small-fonts does. They go
+to the source tree, or with --atlas-dir to images/generated and generated/ in
+that folder, where a platform's run reads them from. A platform's run writes resource_ids.h and
+resources.c to its build folder: raw resources as bytes, 1-bit pngs as the
+pixels the watch loads them as, GBitmapFormat1BitPalette on the color
+platforms, GBitmapFormat1Bit on black and white ones. A file~<platform>
+variant takes the place of the file where it exists.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+sys.path.insert(0, os.path.join(ROOT, 'tools'))
+import atlasgen
+
+RESOURCE_DIR = os.path.join(ROOT, 'resources')
+
+
+def load_appinfo():
+    with open(os.path.join(ROOT, 'appinfo.json')) as f:
+        return json.load(f)
+
+
+def generate_atlases(derive, atlas_dir):
+    atlasgen.generate(os.path.join(RESOURCE_DIR, 'glyphs', 'manifest.json'),
+                      os.path.join(atlas_dir or RESOURCE_DIR, 'images', 'generated'),
+                      os.path.join(atlas_dir or os.path.join(ROOT, 'src'), 'generated', 'glyph_atlas.h'),
+                      load_appinfo()['targetPlatforms'],
+                      derive=derive,
+                      cell_platforms=['aplite', 'diorite'])
+
+
+def variant_path(path, platform):
+    base, ext = os.path.splitext(path)
+    variant = '{}~{}{}'.format(base, platform, ext)
+    return variant if os.path.exists(variant) else path
+
+
+def read_alpha(path, entries):
+    """Alpha of each palette entry, from the tRNS chunk if there is one."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    alpha = [255] * entries
+    pos = 8
+    while pos < len(data):
+        length, = struct.unpack('>I', data[pos:pos + 4])
+        if data[pos + 4:pos + 8] == b'tRNS':
+            for i, value in enumerate(bytearray(data[pos + 8:pos + 8 + length])):
+                alpha[i] = value
+        pos += 12 + length
+    return alpha
+
+
+def argb8(r, g, b, a):
+    return ((a >> 6) << 6) | ((r >> 6) << 4) | ((g >> 6) << 2) | (b >> 6)
+
+
+def load_bitmap(path, platform):
+    width, height, palette, rows = atlasgen.read_png(path)
+    palette = bytearray(palette)
+    entries = len(palette) // 3
+
+    if platform in atlasgen.MONO_PLATFORMS:
+        stride = atlasgen.row_bytes(width, platform)
+        data = bytearray()
+        for row in rows:
+            line = bytearray(stride)
+            for x, value in enumerate(row):
+                if atlasgen.is_white(palette, value):
+                    line[x >> 3] |= 1 << (x & 7)
+            data += line
+        return {'format': 'GBitmapFormat1Bit', 'width': width, 'height': height, 'row_size': stride,
+                'data': data, 'palette': bytearray()}
+
+    stride = (width + 7) // 8
+    data = bytearray()
+    for row in rows:
+        line = bytearray(stride)
+        for x, value in enumerate(row):
+            if value:
+                line[x >> 3] |= 0x80 >> (x & 7)
+        data += line
+    alpha = read_alpha(path, entries)
+    colors = bytearray(argb8(palette[i * 3], palette[i * 3 + 1], palette[i * 3 + 2], alpha[i]) for i in range(2))
+    return {'format': 'GBitmapFormat1BitPalette', 'width': width, 'height': height, 'row_size': stride,
+            'data': data, 'palette': colors}
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append('  ' + ' '.join('0x{:02x},'.format(b) for b in bytearray(data[i:i + 16])))
+    return '\n'.join(lines) if lines else '  0'
+
+
+def generate_platform(platform, out_dir, atlas_dir):
+    media = load_appinfo()['resources']['media']
+    ids = []
+    arrays = []
+    entries = []
+    for resource_id, entry in enumerate(media, 1):
+        ids.append('#define RESOURCE_ID_{} {}\n'.format(entry['name'], resource_id))
+        targets = entry.get('targetPlatforms')
+        if targets is not None and platform not in targets:
+            continue
+
+        root = atlas_dir if atlas_dir and entry['file'].startswith('images/generated/') else RESOURCE_DIR
+        path = variant_path(os.path.join(root, entry['file']), platform)
+        symbol = 's_resource_{}'.format(entry['name'].lower())
+        if entry['type'] == 'raw':
+            with open(path, 'rb') as f:
+                data = f.read()
+            arrays.append('static const uint8_t {}[] = {{\n{}\n}};\n'.format(symbol, c_bytes(data)))
+            entries.append('  {{ RESOURCE_ID_{}, {}, {}, false, 0, 0, 0, 0, NULL, 0 }},\n'.format(
+                entry['name'], symbol, len(data)))
+        elif entry['type'] == 'bitmap' and path.endswith('.png'):
+            bitmap = load_bitmap(path, platform)
+            arrays.append('static const uint8_t {}[] = {{\n{}\n}};\n'.format(symbol, c_bytes(bitmap['data'])))
+            palette = 'NULL'
+            if bitmap['palette']:
+                palette = symbol + '_palette'
+                arrays.append('static const uint8_t {}[] = {{ {} }};\n'.format(
+                    palette, ', '.join('0x{:02x}'.format(b) for b in bitmap['palette'])))
+            entries.append('  {{ RESOURCE_ID_{}, {}, {}, true, {}, {}, {}, {}, {}, {} }},\n'.format(
+                entry['name'], symbol, len(bitmap['data']), bitmap['format'], bitmap['width'], bitmap['height'],
+                bitmap['row_size'], palette, len(bitmap['palette'])))
+
+    header = '// generated by tools/host/hostres.py from appinfo.json, do not edit\n#pragma once\n\n' + ''.join(ids)
+    source = ('// generated by tools/host/hostres.py for {platform}, do not edit\n'
+              '#include "host.h"\n\n'
+              '{arrays}\n'
+              'const struct HostResource host_resources[] = {{\n{entries}}};\n\n'
+              'const int host_resource_num = {count};\n').format(
+                  platform=platform, arrays='\n'.join(arrays), entries=''.join(entries), count=len(entries))
+
+    atlasgen.write_if_changed(os.path.join(out_dir, 'resource_ids.h'), header)
+    atlasgen.write_if_changed(os.path.join(out_dir, 'resources.c'), source)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--atlas', action='store_true', help='pack the atlases and glyph tables first')
+    parser.add_argument('--derive', action='store_true', help='downscale the smaller fonts from the largest')
+    parser.add_argument('--atlas-dir', help='where the atlases go, instead of the source tree')
+    parser.add_argument('platform', nargs='?')
+    parser.add_argument('out_dir', nargs='?')
+    args = parser.parse_args()
+
+    if args.atlas:
+        generate_atlases(args.derive, args.atlas_dir)
+    if args.platform:
+        generate_platform(args.platform, args.out_dir, args.atlas_dir)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,478 @@
+#pragma once
+
+// host stand-in for the parts of the pebble sdk the face uses, so src/*.c
+// build and run on linux for benchmarks and tests, see tools/host/Makefile.
+//
+// the platform comes from the command line as the sdk's build sets it:
+// PBL_PLATFORM_<NAME>, PBL_COLOR or PBL_BW, PBL_RECT or PBL_ROUND. drawing,
+// layers, animations, timers, persist, app messages and the app heap are
+// modeled in pebble_host.c closely enough for the face to run unchanged on a
+// simulated clock. tools/host/host.h drives it.
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "resource_ids.h"
+
+// -----------------------------------------------------------------------------
+// platform
+// -----------------------------------------------------------------------------
+
+#if defined(PBL_PLATFORM_CHALK)
+  #define PBL_DISPLAY_WIDTH   180
+  #define PBL_DISPLAY_HEIGHT  180
+#elif defined(PBL_PLATFORM_EMERY)
+  #define PBL_DISPLAY_WIDTH   200
+  #define PBL_DISPLAY_HEIGHT  228
+#else
+  #define PBL_DISPLAY_WIDTH   144
+  #define PBL_DISPLAY_HEIGHT  168
+#endif
+
+#ifdef PBL_ROUND
+  #define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+  #define PBL_IF_RECT_ELSE(if_true, if_false) (if_false)
+#else
+  #define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+  #define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#endif
+
+#ifdef PBL_COLOR
+  #define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+  #define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#else
+  #define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+  #define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#endif
+
+// only the apis whose presence the face tests for
+#define PBL_API_EXISTS(api) HOST_API_EXISTS_##api
+#ifndef PBL_PLATFORM_APLITE
+  #define HOST_API_EXISTS_unobstructed_area_service_subscribe 1
+#endif
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+#define SECONDS_PER_MINUTE 60
+
+// -----------------------------------------------------------------------------
+// logging
+// -----------------------------------------------------------------------------
+
+enum
+{
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200,
+  APP_LOG_LEVEL_DEBUG_VERBOSE = 255,
+};
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...)
+  __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, ...) app_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// -----------------------------------------------------------------------------
+// app heap, time and random
+// -----------------------------------------------------------------------------
+
+// the face's allocations come from a model of the watch's app heap, see host.h
+void* host_malloc(size_t size);
+void* host_calloc(size_t count, size_t size);
+void host_free(void* ptr);
+#define malloc(size) host_malloc(size)
+#define calloc(count, size) host_calloc(count, size)
+#define free(ptr) host_free(ptr)
+
+size_t heap_bytes_free(void);
+size_t heap_bytes_used(void);
+
+// the simulated clock, in local time
+time_t host_time(time_t* tloc);
+struct tm* host_localtime(const time_t* timep);
+#define time(tloc) host_time(tloc)
+#define localtime(timep) host_localtime(timep)
+
+uint16_t time_ms(time_t* t_utc, uint16_t* out_ms);
+bool clock_is_24h_style(void);
+
+// -----------------------------------------------------------------------------
+// graphics types
+// -----------------------------------------------------------------------------
+
+typedef struct GPoint
+{
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+typedef struct GSize
+{
+  int16_t w;
+  int16_t h;
+} GSize;
+
+typedef struct GRect
+{
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){ (x), (y) })
+#define GPointZero GPoint(0, 0)
+#define GSize(w, h) ((GSize){ (w), (h) })
+#define GRect(x, y, w, h) ((GRect){ { (x), (y) }, { (w), (h) } })
+#define GRectZero GRect(0, 0, 0, 0)
+
+bool grect_equal(const GRect* const rect_a, const GRect* const rect_b);
+
+typedef union GColor8
+{
+  uint8_t argb;
+  struct
+  {
+    uint8_t b:2;
+    uint8_t g:2;
+    uint8_t r:2;
+    uint8_t a:2;
+  };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorARGB8(a, r, g, b) ((GColor8){ .argb = (uint8_t)((((a) >> 6) << 6) | (((r) >> 6) << 4) | (((g) >> 6) << 2) | ((b) >> 6)) })
+#define GColorFromRGB(r, g, b) GColorARGB8(255, r, g, b)
+#define GColorFromHEX(v) GColorFromRGB(((v) >> 16) & 0xFF, ((v) >> 8) & 0xFF, (v) & 0xFF)
+
+#define GColorClear ((GColor8){ .argb = 0x00 })
+#define GColorBlack ((GColor8){ .argb = 0xC0 })
+#define GColorWhite ((GColor8){ .argb = 0xFF })
+#define GColorRed ((GColor8){ .argb = 0xF0 })
+#define GColorGreen ((GColor8){ .argb = 0xCC })
+#define GColorBlue ((GColor8){ .argb = 0xC3 })
+#define GColorDarkGray ((GColor8){ .argb = 0xD5 })
+#define GColorLightGray ((GColor8){ .argb = 0xEA })
+
+bool gcolor_equal(GColor8 x, GColor8 y);
+
+typedef enum GBitmapFormat
+{
+  GBitmapFormat1Bit = 0,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular,
+} GBitmapFormat;
+
+typedef enum GCompOp
+{
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet,
+} GCompOp;
+
+typedef struct GBitmapDataRowInfo
+{
+  uint8_t* data;
+  int16_t min_x;
+  int16_t max_x;
+} GBitmapDataRowInfo;
+
+typedef struct GBitmap GBitmap;
+typedef struct GContext GContext;
+typedef struct GPath GPath;
+
+typedef struct GPathInfo
+{
+  uint32_t num_points;
+  GPoint* points;
+} GPathInfo;
+
+// -----------------------------------------------------------------------------
+// bitmaps
+// -----------------------------------------------------------------------------
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id);
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format);
+GBitmap* gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor* palette, bool free_on_destroy);
+GBitmap* gbitmap_create_as_sub_bitmap(const GBitmap* base_bitmap, GRect sub_rect);
+void gbitmap_destroy(GBitmap* bitmap);
+
+GBitmapFormat gbitmap_get_format(const GBitmap* bitmap);
+uint8_t* gbitmap_get_data(const GBitmap* bitmap);
+void gbitmap_set_data(GBitmap* bitmap, uint8_t* data, GBitmapFormat format, uint16_t row_size_bytes, bool free_on_destroy);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap* bitmap);
+GRect gbitmap_get_bounds(const GBitmap* bitmap);
+void gbitmap_set_bounds(GBitmap* bitmap, GRect bounds);
+GColor* gbitmap_get_palette(const GBitmap* bitmap);
+void gbitmap_set_palette(GBitmap* bitmap, GColor* palette, bool free_on_destroy);
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap* bitmap, uint16_t y);
+
+// -----------------------------------------------------------------------------
+// layers and windows
+// -----------------------------------------------------------------------------
+
+typedef struct Layer Layer;
+typedef struct BitmapLayer BitmapLayer;
+typedef struct Window Window;
+
+typedef void (*LayerUpdateProc)(Layer* layer, GContext* ctx);
+
+Layer* layer_create(GRect frame);
+void layer_destroy(Layer* layer);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer* layer);
+void layer_set_frame(Layer* layer, GRect frame);
+GRect layer_get_frame(const Layer* layer);
+void layer_set_bounds(Layer* layer, GRect bounds);
+GRect layer_get_bounds(const Layer* layer);
+GRect layer_get_unobstructed_bounds(const Layer* layer);
+void layer_set_hidden(Layer* layer, bool hidden);
+bool layer_get_hidden(const Layer* layer);
+void layer_add_child(Layer* parent, Layer* child);
+void layer_insert_below_sibling(Layer* layer_to_insert, Layer* below_sibling_layer);
+void layer_remove_from_parent(Layer* child);
+
+BitmapLayer* bitmap_layer_create(GRect frame);
+void bitmap_layer_destroy(BitmapLayer* bitmap_layer);
+Layer* bitmap_layer_get_layer(const BitmapLayer* bitmap_layer);
+const GBitmap* bitmap_layer_get_bitmap(BitmapLayer* bitmap_layer);
+void bitmap_layer_set_bitmap(BitmapLayer* bitmap_layer, const GBitmap* bitmap);
+void bitmap_layer_set_compositing_mode(BitmapLayer* bitmap_layer, GCompOp mode);
+
+typedef void (*WindowHandler)(Window* window);
+
+typedef struct WindowHandlers
+{
+  WindowHandler load;
+  WindowHandler appear;
+  WindowHandler disappear;
+  WindowHandler unload;
+} WindowHandlers;
+
+Window* window_create(void);
+void window_destroy(Window* window);
+void window_set_window_handlers(Window* window, WindowHandlers handlers);
+void window_set_background_color(Window* window, GColor background_color);
+Layer* window_get_root_layer(const Window* window);
+void window_stack_push(Window* window, bool animated);
+
+// -----------------------------------------------------------------------------
+// drawing
+// -----------------------------------------------------------------------------
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext* ctx, GCompOp mode);
+void graphics_draw_bitmap_in_rect(GContext* ctx, const GBitmap* bitmap, GRect rect);
+GBitmap* graphics_capture_frame_buffer(GContext* ctx);
+bool graphics_release_frame_buffer(GContext* ctx, GBitmap* buffer);
+
+GPath* gpath_create(const GPathInfo* init);
+void gpath_destroy(GPath* path);
+void gpath_move_to(GPath* path, GPoint point);
+void gpath_draw_filled(GContext* ctx, GPath* path);
+
+// -----------------------------------------------------------------------------
+// animations and timers
+// -----------------------------------------------------------------------------
+
+typedef struct Animation Animation;
+typedef int32_t AnimationProgress;
+
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef void (*AnimationSetupImplementation)(Animation* animation);
+typedef void (*AnimationUpdateImplementation)(Animation* animation, const AnimationProgress progress);
+typedef void (*AnimationTeardownImplementation)(Animation* animation);
+
+typedef struct AnimationImplementation
+{
+  AnimationSetupImplementation setup;
+  AnimationUpdateImplementation update;
+  AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+Animation* animation_create(void);
+bool animation_destroy(Animation* animation);
+bool animation_set_delay(Animation* animation, uint32_t delay_ms);
+bool animation_set_duration(Animation* animation, uint32_t duration_ms);
+bool animation_set_implementation(Animation* animation, const AnimationImplementation* implementation);
+bool animation_schedule(Animation* animation);
+bool animation_unschedule(Animation* animation);
+bool animation_is_scheduled(Animation* animation);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void* data);
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data);
+void app_timer_cancel(AppTimer* timer_handle);
+
+void app_event_loop(void);
+
+// -----------------------------------------------------------------------------
+// services
+// -----------------------------------------------------------------------------
+
+typedef enum TimeUnits
+{
+  SECOND_UNIT = 1 << 0,
+  MINUTE_UNIT = 1 << 1,
+  HOUR_UNIT = 1 << 2,
+  DAY_UNIT = 1 << 3,
+  MONTH_UNIT = 1 << 4,
+  YEAR_UNIT = 1 << 5,
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm* tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+typedef struct BatteryChargeState
+{
+  uint8_t charge_percent;
+  bool is_charging;
+  bool is_plugged;
+} BatteryChargeState;
+
+typedef void (*BatteryStateHandler)(BatteryChargeState charge);
+
+BatteryChargeState battery_state_service_peek(void);
+void battery_state_service_subscribe(BatteryStateHandler handler);
+void battery_state_service_unsubscribe(void);
+
+typedef void (*UnobstructedAreaWillChangeHandler)(GRect final_unobstructed_screen_area, void* context);
+typedef void (*UnobstructedAreaChangeHandler)(AnimationProgress progress, void* context);
+typedef void (*UnobstructedAreaDidChangeHandler)(void* context);
+
+typedef struct UnobstructedAreaHandlers
+{
+  UnobstructedAreaWillChangeHandler will_change;
+  UnobstructedAreaChangeHandler change;
+  UnobstructedAreaDidChangeHandler did_change;
+} UnobstructedAreaHandlers;
+
+void unobstructed_area_service_subscribe(UnobstructedAreaHandlers handlers, void* context);
+void unobstructed_area_service_unsubscribe(void);
+
+// -----------------------------------------------------------------------------
+// storage and resources
+// -----------------------------------------------------------------------------
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+enum
+{
+  S_SUCCESS = 0,
+  E_DOES_NOT_EXIST = -9,
+  E_RANGE = -4,
+};
+
+bool persist_exists(uint32_t key);
+int persist_get_size(uint32_t key);
+int persist_read_data(uint32_t key, void* buffer, size_t buffer_size);
+int persist_write_data(uint32_t key, const void* data, size_t size);
+int32_t persist_read_int(uint32_t key);
+int persist_write_int(uint32_t key, int32_t value);
+int persist_delete(uint32_t key);
+
+typedef const struct HostResource* ResHandle;
+
+ResHandle resource_get_handle(uint32_t resource_id);
+size_t resource_size(ResHandle h);
+size_t resource_load(ResHandle h, uint8_t* buffer, size_t max_length);
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t* buffer, size_t num_bytes);
+
+// -----------------------------------------------------------------------------
+// dictionaries and app messages
+// -----------------------------------------------------------------------------
+
+typedef enum TupleType
+{
+  TUPLE_BYTE_ARRAY = 0,
+  TUPLE_CSTRING = 1,
+  TUPLE_UINT = 2,
+  TUPLE_INT = 3,
+} TupleType;
+
+typedef struct __attribute__((__packed__)) Tuple
+{
+  uint32_t key;
+  TupleType type:8;
+  uint16_t length;
+  union
+  {
+    uint8_t data[0];
+    char cstring[0];
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+  } value[];
+} Tuple;
+
+typedef struct Dictionary Dictionary;
+
+typedef struct DictionaryIterator
+{
+  Dictionary* dictionary;
+  const void* end;
+  Tuple* cursor;
+} DictionaryIterator;
+
+typedef enum DictionaryResult
+{
+  DICT_OK = 0,
+  DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+  DICT_INVALID_ARGS = 1 << 2,
+} DictionaryResult;
+
+DictionaryResult dict_write_begin(DictionaryIterator* iter, uint8_t* const buffer, const uint16_t size);
+DictionaryResult dict_write_data(DictionaryIterator* iter, const uint32_t key, const uint8_t* const data, const uint16_t size);
+DictionaryResult dict_write_cstring(DictionaryIterator* iter, const uint32_t key, const char* const cstring);
+DictionaryResult dict_write_uint8(DictionaryIterator* iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_uint16(DictionaryIterator* iter, const uint32_t key, const uint16_t value);
+DictionaryResult dict_write_uint32(DictionaryIterator* iter, const uint32_t key, const uint32_t value);
+DictionaryResult dict_write_int32(DictionaryIterator* iter, const uint32_t key, const int32_t value);
+uint32_t dict_write_end(DictionaryIterator* iter);
+Tuple* dict_read_begin_from_buffer(DictionaryIterator* iter, const uint8_t* const buffer, const uint16_t size);
+Tuple* dict_read_first(DictionaryIterator* iter);
+Tuple* dict_read_next(DictionaryIterator* iter);
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key);
+
+typedef enum AppMessageResult
+{
+  APP_MSG_OK = 0,
+  APP_MSG_SEND_TIMEOUT = 1 << 1,
+  APP_MSG_SEND_REJECTED = 1 << 2,
+  APP_MSG_NOT_CONNECTED = 1 << 3,
+  APP_MSG_BUSY = 1 << 6,
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator* iterator, void* context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void* context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator* iterator, void* context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator* iterator, AppMessageResult reason, void* context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+uint32_t app_message_inbox_size_maximum(void);
+uint32_t app_message_outbox_size_maximum(void);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+AppMessageResult app_message_outbox_begin(DictionaryIterator** iterator);
+AppMessageResult app_message_outbox_send(void);
@@ -0,0 +1,1871 @@
+#include <math.h>
+#include <stdarg.h>
+
+#include "host.h"
+
+#define HOST_FRAME_MS   33    // the firmware paces animations at 30 fps
+
+// -----------------------------------------------------------------------------
+// app heap
+// -----------------------------------------------------------------------------
+
+// app ram of each platform, code and statics included on the watch
+#if defined(PBL_PLATFORM_APLITE)
+  #define HOST_HEAP_BYTES (24 * 1024)
+#elif defined(PBL_PLATFORM_EMERY)
+  #define HOST_HEAP_BYTES (128 * 1024)
+#else
+  #define HOST_HEAP_BYTES (64 * 1024)
+#endif
+
+// first fit over blocks in address order, each behind a header
+struct HeapBlock
+{
+  uint32_t size;      // payload bytes, a multiple of 8
+  uint32_t is_used;
+};
+
+#define HEAP_HEADER_SIZE ((uint32_t)sizeof(struct HeapBlock))
+
+static uint64_t s_heap[HOST_HEAP_BYTES / 8];
+static bool s_is_heap_ready = false;
+static size_t s_heap_used = 0;
+static uint32_t s_heap_allocations = 0;
+
+static struct HeapBlock* heap_first(void)
+{
+  struct HeapBlock* block = (struct HeapBlock*)s_heap;
+  if (!s_is_heap_ready)
+  {
+    block->size = sizeof(s_heap) - HEAP_HEADER_SIZE;
+    block->is_used = 0;
+    s_is_heap_ready = true;
+  }
+  return block;
+}
+
+static struct HeapBlock* heap_next(struct HeapBlock* block)
+{
+  uint8_t* next = (uint8_t*)block + HEAP_HEADER_SIZE + block->size;
+  return (next < (uint8_t*)s_heap + sizeof(s_heap)) ? (struct HeapBlock*)next : NULL;
+}
+
+void* host_malloc(size_t size)
+{
+  uint32_t need = (uint32_t)((size + 7) & ~(size_t)7);
+  if (need == 0) need = 8;
+
+  for (struct HeapBlock* block = heap_first(); block; block = heap_next(block))
+  {
+    if (block->is_used || block->size < need) continue;
+
+    if (block->size >= need + HEAP_HEADER_SIZE + 8)
+    {
+      struct HeapBlock* rest = (struct HeapBlock*)((uint8_t*)block + HEAP_HEADER_SIZE + need);
+      rest->size = block->size - need - HEAP_HEADER_SIZE;
+      rest->is_used = 0;
+      block->size = need;
+    }
+    block->is_used = 1;
+    s_heap_used += HEAP_HEADER_SIZE + block->size;
+    ++s_heap_allocations;
+    return (uint8_t*)block + HEAP_HEADER_SIZE;
+  }
+
+  return NULL;
+}
+
+void* host_calloc(size_t count, size_t size)
+{
+  void* ptr = host_malloc(count * size);
+  if (ptr) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void host_free(void* ptr)
+{
+  if (ptr == NULL) return;
+
+  struct HeapBlock* freed = (struct HeapBlock*)((uint8_t*)ptr - HEAP_HEADER_SIZE);
+  if (!freed->is_used)
+  {
+    fprintf(stderr, "host: free of a free block %p\n", ptr);
+    abort();
+  }
+  freed->is_used = 0;
+  s_heap_used -= HEAP_HEADER_SIZE + freed->size;
+
+  // merge runs of free blocks
+  for (struct HeapBlock* block = heap_first(); block; block = heap_next(block))
+  {
+    if (block->is_used) continue;
+    struct HeapBlock* next;
+    while ((next = heap_next(block)) && !next->is_used)
+      block->size += HEAP_HEADER_SIZE + next->size;
+  }
+}
+
+size_t heap_bytes_used(void)
+{
+  return s_heap_used;
+}
+
+size_t heap_bytes_free(void)
+{
+  return sizeof(s_heap) - s_heap_used;
+}
+
+size_t host_heap_largest_free(void)
+{
+  size_t largest = 0;
+  for (struct HeapBlock* block = heap_first(); block; block = heap_next(block))
+  {
+    if (!block->is_used && block->size > largest) largest = block->size;
+  }
+  return largest;
+}
+
+uint32_t host_heap_allocations(void)
+{
+  return s_heap_allocations;
+}
+
+// -----------------------------------------------------------------------------
+// logging, time and settings
+// -----------------------------------------------------------------------------
+
+static int64_t s_now_ms = 0;
+static bool s_is_24h_style = true;
+static uint8_t s_log_level = APP_LOG_LEVEL_INFO;
+static const char* s_stop_marker = NULL;
+static bool s_is_stopped = false;
+static uint32_t s_run_limit_ms = 0;
+
+static const char* get_level_name(uint8_t level)
+{
+  if (level <= APP_LOG_LEVEL_ERROR) return "ERROR";
+  if (level <= APP_LOG_LEVEL_WARNING) return "WARNING";
+  if (level <= APP_LOG_LEVEL_INFO) return "INFO";
+  return "DEBUG";
+}
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...)
+{
+  if (log_level > s_log_level && s_stop_marker == NULL) return;
+
+  char message[256];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(message, sizeof(message), fmt, args);
+  va_end(args);
+
+  if (s_stop_marker && strstr(message, s_stop_marker)) s_is_stopped = true;
+  if (log_level > s_log_level) return;
+
+  const char* name = strrchr(src_filename, '/');
+  printf("[%s] %s:%d> %s\n", get_level_name(log_level), name ? name + 1 : src_filename, src_line_number, message);
+}
+
+void host_set_log_level(uint8_t level)
+{
+  s_log_level = level;
+}
+
+void host_stop_on_log(const char* marker)
+{
+  s_stop_marker = marker;
+  s_is_stopped = false;
+}
+
+bool host_is_stopped(void)
+{
+  return s_is_stopped;
+}
+
+void host_set_run_limit(uint32_t ms)
+{
+  s_run_limit_ms = ms;
+}
+
+void host_set_time(time_t local_time)
+{
+  s_now_ms = (int64_t)local_time * 1000;
+}
+
+void host_set_24h_style(bool is_24h)
+{
+  s_is_24h_style = is_24h;
+}
+
+bool clock_is_24h_style(void)
+{
+  return s_is_24h_style;
+}
+
+time_t host_time(time_t* tloc)
+{
+  time_t now = (time_t)(s_now_ms / 1000);
+  if (tloc) *tloc = now;
+  return now;
+}
+
+// the simulated clock keeps local time, there is no time zone to apply
+struct tm* host_localtime(const time_t* timep)
+{
+  static struct tm result;
+  return gmtime_r(timep, &result);
+}
+
+uint16_t time_ms(time_t* t_utc, uint16_t* out_ms)
+{
+  uint16_t ms = (uint16_t)(s_now_ms % 1000);
+  if (t_utc) *t_utc = (time_t)(s_now_ms / 1000);
+  if (out_ms) *out_ms = ms;
+  return ms;
+}
+
+bool gcolor_equal(GColor8 x, GColor8 y)
+{
+  return x.argb == y.argb;
+}
+
+// -----------------------------------------------------------------------------
+// bitmaps
+// -----------------------------------------------------------------------------
+
+struct GBitmap
+{
+  uint8_t* addr;
+  uint16_t row_size_bytes;
+  GBitmapFormat format;
+  GRect bounds;
+  GColor* palette;
+  bool is_data_owned;
+  bool is_palette_owned;
+  const GBitmapDataRowInfo* row_infos;   // GBitmapFormat8BitCircular only
+};
+
+static int get_palette_size(GBitmapFormat format)
+{
+  switch (format)
+  {
+  case GBitmapFormat1BitPalette: return 2;
+  case GBitmapFormat2BitPalette: return 4;
+  case GBitmapFormat4BitPalette: return 16;
+  default:                       return 0;
+  }
+}
+
+static uint16_t get_row_size(GBitmapFormat format, int width)
+{
+  switch (format)
+  {
+  case GBitmapFormat1Bit:         return (width + 31) / 32 * 4;
+  case GBitmapFormat1BitPalette:  return (width + 7) / 8;
+  case GBitmapFormat2BitPalette:  return (width + 3) / 4;
+  case GBitmapFormat4BitPalette:  return (width + 1) / 2;
+  default:                        return width;
+  }
+}
+
+static GBitmap* create_bitmap(GSize size, GBitmapFormat format)
+{
+  GBitmap* bitmap = calloc(1, sizeof(GBitmap));
+  if (bitmap == NULL) return NULL;
+
+  bitmap->format = format;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->row_size_bytes = get_row_size(format, size.w);
+  return bitmap;
+}
+
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format)
+{
+  GBitmap* bitmap = create_bitmap(size, format);
+  if (bitmap == NULL) return NULL;
+
+  // the palette follows the pixels in the same allocation
+  size_t data_size = (size_t)bitmap->row_size_bytes * size.h;
+  int palette_size = get_palette_size(format);
+  bitmap->addr = calloc(1, data_size + palette_size * sizeof(GColor));
+  if (bitmap->addr == NULL)
+  {
+    free(bitmap);
+    return NULL;
+  }
+  bitmap->is_data_owned = true;
+  if (palette_size > 0) bitmap->palette = (GColor*)(bitmap->addr + data_size);
+  return bitmap;
+}
+
+GBitmap* gbitmap_create_blank_with_palette(GSize size, GBitmapFormat format, GColor* palette, bool free_on_destroy)
+{
+  GBitmap* bitmap = create_bitmap(size, format);
+  if (bitmap == NULL) return NULL;
+
+  bitmap->addr = calloc(1, (size_t)bitmap->row_size_bytes * size.h);
+  if (bitmap->addr == NULL)
+  {
+    free(bitmap);
+    return NULL;
+  }
+  bitmap->is_data_owned = true;
+  bitmap->palette = palette;
+  bitmap->is_palette_owned = free_on_destroy;
+  return bitmap;
+}
+
+GBitmap* gbitmap_create_as_sub_bitmap(const GBitmap* base_bitmap, GRect sub_rect)
+{
+  GBitmap* bitmap = malloc(sizeof(GBitmap));
+  if (bitmap == NULL) return NULL;
+
+  *bitmap = *base_bitmap;
+  bitmap->is_data_owned = false;
+  bitmap->is_palette_owned = false;
+
+  // clipped to the base bitmap
+  GRect base = base_bitmap->bounds;
+  int left = (sub_rect.origin.x > base.origin.x) ? sub_rect.origin.x : base.origin.x;
+  int top = (sub_rect.origin.y > base.origin.y) ? sub_rect.origin.y : base.origin.y;
+  int right = sub_rect.origin.x + sub_rect.size.w;
+  int bottom = sub_rect.origin.y + sub_rect.size.h;
+  if (right > base.origin.x + base.size.w) right = base.origin.x + base.size.w;
+  if (bottom > base.origin.y + base.size.h) bottom = base.origin.y + base.size.h;
+  bitmap->bounds = GRect(left, top, (right > left) ? right - left : 0, (bottom > top) ? bottom - top : 0);
+  return bitmap;
+}
+
+static const struct HostResource* find_resource(uint32_t resource_id)
+{
+  for (int i = 0; i < host_resource_num; ++i)
+  {
+    if (host_resources[i].id == resource_id) return &host_resources[i];
+  }
+  return NULL;
+}
+
+GBitmap* gbitmap_create_with_resource(uint32_t resource_id)
+{
+  const struct HostResource* resource = find_resource(resource_id);
+  if (resource == NULL || !resource->is_bitmap) return NULL;
+
+  GBitmap* bitmap = gbitmap_create_blank(GSize(resource->width, resource->height), resource->format);
+  if (bitmap == NULL) return NULL;
+
+  memcpy(bitmap->addr, resource->data, (size_t)resource->row_size * resource->height);
+  if (bitmap->palette) memcpy(bitmap->palette, resource->palette, resource->palette_size);
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap* bitmap)
+{
+  if (bitmap == NULL) return;
+
+  if (bitmap->is_palette_owned) free(bitmap->palette);
+  if (bitmap->is_data_owned) free(bitmap->addr);
+  free(bitmap);
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap* bitmap)
+{
+  return bitmap->format;
+}
+
+uint8_t* gbitmap_get_data(const GBitmap* bitmap)
+{
+  return bitmap->addr;
+}
+
+void gbitmap_set_data(GBitmap* bitmap, uint8_t* data, GBitmapFormat format, uint16_t row_size_bytes, bool free_on_destroy)
+{
+  if (bitmap->is_data_owned) free(bitmap->addr);
+  bitmap->addr = data;
+  bitmap->format = format;
+  bitmap->row_size_bytes = row_size_bytes;
+  bitmap->is_data_owned = free_on_destroy;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap* bitmap)
+{
+  return (bitmap->format == GBitmapFormat8BitCircular) ? 0 : bitmap->row_size_bytes;
+}
+
+GRect gbitmap_get_bounds(const GBitmap* bitmap)
+{
+  return bitmap->bounds;
+}
+
+void gbitmap_set_bounds(GBitmap* bitmap, GRect bounds)
+{
+  bitmap->bounds = bounds;
+}
+
+GColor* gbitmap_get_palette(const GBitmap* bitmap)
+{
+  return bitmap->palette;
+}
+
+void gbitmap_set_palette(GBitmap* bitmap, GColor* palette, bool free_on_destroy)
+{
+  if (bitmap->is_palette_owned) free(bitmap->palette);
+  bitmap->palette = palette;
+  bitmap->is_palette_owned = free_on_destroy;
+}
+
+GBitmapDataRowInfo gbitmap_get_data_row_info(const GBitmap* bitmap, uint16_t y)
+{
+  if (bitmap->row_infos) return bitmap->row_infos[y];
+
+  return (GBitmapDataRowInfo) {
+    .data = bitmap->addr + (size_t)y * bitmap->row_size_bytes,
+    .min_x = 0,
+    .max_x = bitmap->bounds.origin.x + bitmap->bounds.size.w - 1,
+  };
+}
+
+// palette index or raw value of a pixel, GBitmapFormat1Bit gives 1 for white
+static int get_pixel_value(const GBitmap* bitmap, int x, int y)
+{
+  GBitmapDataRowInfo row = gbitmap_get_data_row_info(bitmap, y);
+  switch (bitmap->format)
+  {
+  case GBitmapFormat1Bit:         return (row.data[x >> 3] >> (x & 7)) & 1;
+  case GBitmapFormat1BitPalette:  return (row.data[x >> 3] >> (7 - (x & 7))) & 1;
+  case GBitmapFormat2BitPalette:  return (row.data[x >> 2] >> (6 - 2 * (x & 3))) & 3;
+  case GBitmapFormat4BitPalette:  return (row.data[x >> 1] >> ((x & 1) ? 0 : 4)) & 15;
+  default:                        return row.data[x];
+  }
+}
+
+// -----------------------------------------------------------------------------
+// frame buffer
+// -----------------------------------------------------------------------------
+
+#define SCREEN_WIDTH  PBL_DISPLAY_WIDTH
+#define SCREEN_HEIGHT PBL_DISPLAY_HEIGHT
+
+#ifdef PBL_COLOR
+static uint8_t s_frame_data[SCREEN_WIDTH * SCREEN_HEIGHT];
+#else
+static uint8_t s_frame_data[(SCREEN_WIDTH + 31) / 32 * 4 * SCREEN_HEIGHT];
+#endif
+
+#ifdef PBL_ROUND
+// rows of the round display are packed, each as long as the circle is wide there
+static GBitmapDataRowInfo s_frame_rows[SCREEN_HEIGHT];
+#endif
+
+static GBitmap s_frame_buffer;
+static bool s_is_frame_buffer_ready = false;
+
+static GBitmap* get_frame_buffer(void)
+{
+  if (s_is_frame_buffer_ready) return &s_frame_buffer;
+
+#if defined(PBL_ROUND)
+  s_frame_buffer.format = GBitmapFormat8BitCircular;
+  size_t offset = 0;
+  for (int y = 0; y < SCREEN_HEIGHT; ++y)
+  {
+    float dy = y + 0.5f - SCREEN_HEIGHT / 2.f;
+    int half = (int)(sqrtf(SCREEN_WIDTH * SCREEN_WIDTH / 4.f - dy * dy) + 0.5f);
+    int min_x = SCREEN_WIDTH / 2 - half;
+    int max_x = SCREEN_WIDTH / 2 + half - 1;
+    s_frame_rows[y] = (GBitmapDataRowInfo) { s_frame_data + offset - min_x, min_x, max_x };
+    offset += max_x - min_x + 1;
+  }
+  s_frame_buffer.row_infos = s_frame_rows;
+  s_frame_buffer.row_size_bytes = SCREEN_WIDTH;
+#elif defined(PBL_COLOR)
+  s_frame_buffer.format = GBitmapFormat8Bit;
+  s_frame_buffer.row_size_bytes = SCREEN_WIDTH;
+#else
+  s_frame_buffer.format = GBitmapFormat1Bit;
+  s_frame_buffer.row_size_bytes = (SCREEN_WIDTH + 31) / 32 * 4;
+#endif
+  s_frame_buffer.addr = s_frame_data;
+  s_frame_buffer.bounds = GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+  s_is_frame_buffer_ready = true;
+  return &s_frame_buffer;
+}
+
+GBitmap* host_get_frame_buffer(void)
+{
+  return get_frame_buffer();
+}
+
+static bool is_white(GColor color)
+{
+  return color.r + color.g + color.b >= 5;
+}
+
+// an opaque pixel, off the round display's rows it is dropped
+static void put_pixel(int x, int y, GColor color)
+{
+  GBitmap* frame_buffer = get_frame_buffer();
+  GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, y);
+  if (x < row.min_x || x > row.max_x) return;
+
+#ifdef PBL_COLOR
+  row.data[x] = color.argb | 0xC0;
+#else
+  if (is_white(color)) row.data[x >> 3] |= 1 << (x & 7);
+  else row.data[x >> 3] &= ~(1 << (x & 7));
+#endif
+}
+
+// pixels left to right of a row, opaque
+static void fill_span(int y, int left, int right, GColor color)
+{
+  GBitmapDataRowInfo row = gbitmap_get_data_row_info(get_frame_buffer(), y);
+  if (left < row.min_x) left = row.min_x;
+  if (right > row.max_x) right = row.max_x;
+
+#ifdef PBL_COLOR
+  if (left <= right) memset(row.data + left, color.argb | 0xC0, right - left + 1);
+#else
+  for (int x = left; x <= right; ++x)
+  {
+    if (is_white(color)) row.data[x >> 3] |= 1 << (x & 7);
+    else row.data[x >> 3] &= ~(1 << (x & 7));
+  }
+#endif
+}
+
+static GColor get_pixel(int x, int y)
+{
+  GBitmap* frame_buffer = get_frame_buffer();
+  GBitmapDataRowInfo row = gbitmap_get_data_row_info(frame_buffer, y);
+  if (x < row.min_x || x > row.max_x) return GColorBlack;
+
+#ifdef PBL_COLOR
+  return (GColor) { .argb = row.data[x] };
+#else
+  return ((row.data[x >> 3] >> (x & 7)) & 1) ? GColorWhite : GColorBlack;
+#endif
+}
+
+static uint8_t blend_channel(int src, int dest, int alpha)
+{
+  return (uint8_t)((src * alpha + dest * (3 - alpha)) / 3);
+}
+
+// one source pixel onto the frame buffer as the firmware composites it.
+// 1-bit sources follow the black and white ops, anything else is a color that
+// GCompOpSet blends by its alpha and the other ops copy
+static void composite_pixel(int x, int y, const GBitmap* src, int src_x, int src_y, GCompOp op)
+{
+  int value = get_pixel_value(src, src_x, src_y);
+
+  if (src->format == GBitmapFormat1Bit)
+  {
+    // 1 white, 0 black, -1 as it was
+    static const int8_t s_results[][2] = {
+      [GCompOpAssign] =         { 0, 1 },
+      [GCompOpAssignInverted] = { 1, 0 },
+      [GCompOpOr] =             { -1, 1 },
+      [GCompOpAnd] =            { 0, -1 },
+      [GCompOpClear] =          { -1, 0 },
+      [GCompOpSet] =            { 1, -1 },
+    };
+    int result = s_results[op][value];
+    if (result >= 0) put_pixel(x, y, result ? GColorWhite : GColorBlack);
+    return;
+  }
+
+  GColor color = src->palette ? src->palette[value] : (GColor) { .argb = (uint8_t)value };
+  if (op != GCompOpSet || color.a == 3)
+  {
+    put_pixel(x, y, color);
+    return;
+  }
+  if (color.a == 0) return;
+
+  GColor dest = get_pixel(x, y);
+  put_pixel(x, y, (GColor) { .a = 3,
+    .r = blend_channel(color.r, dest.r, color.a),
+    .g = blend_channel(color.g, dest.g, color.a),
+    .b = blend_channel(color.b, dest.b, color.a) });
+}
+
+void host_get_frame_rgb(uint8_t* rgb)
+{
+  for (int y = 0; y < SCREEN_HEIGHT; ++y)
+  {
+    for (int x = 0; x < SCREEN_WIDTH; ++x)
+    {
+      GColor color = get_pixel(x, y);
+      uint8_t* pixel = rgb + (y * SCREEN_WIDTH + x) * 3;
+      pixel[0] = color.r * 85;
+      pixel[1] = color.g * 85;
+      pixel[2] = color.b * 85;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// graphics context
+// -----------------------------------------------------------------------------
+
+struct GContext
+{
+  GPoint origin;    // of the drawing layer's bounds on screen
+  GRect clip;       // on screen
+  GColor fill_color;
+  GCompOp comp_op;
+  bool is_frame_buffer_captured;
+};
+
+static GContext s_context;
+
+static GRect intersect_rects(GRect a, GRect b)
+{
+  int left = (a.origin.x > b.origin.x) ? a.origin.x : b.origin.x;
+  int top = (a.origin.y > b.origin.y) ? a.origin.y : b.origin.y;
+  int right = (a.origin.x + a.size.w < b.origin.x + b.size.w) ? a.origin.x + a.size.w : b.origin.x + b.size.w;
+  int bottom = (a.origin.y + a.size.h < b.origin.y + b.size.h) ? a.origin.y + a.size.h : b.origin.y + b.size.h;
+  return GRect(left, top, (right > left) ? right - left : 0, (bottom > top) ? bottom - top : 0);
+}
+
+bool grect_equal(const GRect* const rect_a, const GRect* const rect_b)
+{
+  return rect_a->origin.x == rect_b->origin.x && rect_a->origin.y == rect_b->origin.y &&
+         rect_a->size.w == rect_b->size.w && rect_a->size.h == rect_b->size.h;
+}
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color)
+{
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext* ctx, GCompOp mode)
+{
+  ctx->comp_op = mode;
+}
+
+// the bitmap is tiled over a larger rect
+void graphics_draw_bitmap_in_rect(GContext* ctx, const GBitmap* bitmap, GRect rect)
+{
+  if (bitmap == NULL || bitmap->bounds.size.w <= 0 || bitmap->bounds.size.h <= 0) return;
+
+  GRect screen = GRect(ctx->origin.x + rect.origin.x, ctx->origin.y + rect.origin.y, rect.size.w, rect.size.h);
+  GRect area = intersect_rects(screen, ctx->clip);
+  for (int y = area.origin.y; y < area.origin.y + area.size.h; ++y)
+  {
+    int src_y = bitmap->bounds.origin.y + (y - screen.origin.y) % bitmap->bounds.size.h;
+    for (int x = area.origin.x; x < area.origin.x + area.size.w; ++x)
+    {
+      int src_x = bitmap->bounds.origin.x + (x - screen.origin.x) % bitmap->bounds.size.w;
+      composite_pixel(x, y, bitmap, src_x, src_y, ctx->comp_op);
+    }
+  }
+}
+
+GBitmap* graphics_capture_frame_buffer(GContext* ctx)
+{
+  if (ctx->is_frame_buffer_captured) return NULL;
+  ctx->is_frame_buffer_captured = true;
+  return get_frame_buffer();
+}
+
+bool graphics_release_frame_buffer(GContext* ctx, GBitmap* buffer)
+{
+  if (!ctx->is_frame_buffer_captured || buffer != get_frame_buffer()) return false;
+  ctx->is_frame_buffer_captured = false;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// paths
+// -----------------------------------------------------------------------------
+
+// the points are not copied, the caller keeps them
+struct GPath
+{
+  uint32_t num_points;
+  GPoint* points;
+  GPoint offset;
+};
+
+GPath* gpath_create(const GPathInfo* init)
+{
+  GPath* path = malloc(sizeof(GPath));
+  if (path == NULL) return NULL;
+
+  path->num_points = init->num_points;
+  path->points = init->points;
+  path->offset = GPointZero;
+  return path;
+}
+
+void gpath_destroy(GPath* path)
+{
+  free(path);
+}
+
+void gpath_move_to(GPath* path, GPoint point)
+{
+  path->offset = point;
+}
+
+#define GPATH_MAX_POINTS 32
+
+// even-odd scanlines through the pixel rows, the bottom row closing the shape
+void gpath_draw_filled(GContext* ctx, GPath* path)
+{
+  if (path->num_points < 3 || path->num_points > GPATH_MAX_POINTS) return;
+  if (ctx->fill_color.a == 0) return;
+
+  float xs[GPATH_MAX_POINTS], ys[GPATH_MAX_POINTS];
+  int min_y = INT32_MAX, max_y = INT32_MIN;
+  for (uint32_t i = 0; i < path->num_points; ++i)
+  {
+    xs[i] = ctx->origin.x + path->offset.x + path->points[i].x;
+    ys[i] = ctx->origin.y + path->offset.y + path->points[i].y;
+    if (ys[i] < min_y) min_y = (int)ys[i];
+    if (ys[i] > max_y) max_y = (int)ys[i];
+  }
+
+  for (int y = min_y; y <= max_y; ++y)
+  {
+    float crossings[GPATH_MAX_POINTS];
+    int num = 0;
+    for (uint32_t i = 0; i < path->num_points; ++i)
+    {
+      uint32_t j = (i + 1) % path->num_points;
+      float y0 = ys[i], y1 = ys[j];
+      if (y0 == y1) continue;
+
+      float low = (y0 < y1) ? y0 : y1;
+      float high = (y0 < y1) ? y1 : y0;
+      bool is_crossing = (y == max_y) ? (y > low && y <= high) : (y >= low && y < high);
+      if (is_crossing) crossings[num++] = xs[i] + (y - y0) * (xs[j] - xs[i]) / (y1 - y0);
+    }
+
+    for (int i = 1; i < num; ++i)
+    {
+      for (int j = i; j > 0 && crossings[j - 1] > crossings[j]; --j)
+      {
+        float swap = crossings[j];
+        crossings[j] = crossings[j - 1];
+        crossings[j - 1] = swap;
+      }
+    }
+
+    if (y < ctx->clip.origin.y || y >= ctx->clip.origin.y + ctx->clip.size.h) continue;
+    for (int i = 0; i + 1 < num; i += 2)
+    {
+      int left = (int)floorf(crossings[i] + 0.5f);
+      int right = (int)floorf(crossings[i + 1] + 0.5f);
+      if (left < ctx->clip.origin.x) left = ctx->clip.origin.x;
+      if (right >= ctx->clip.origin.x + ctx->clip.size.w) right = ctx->clip.origin.x + ctx->clip.size.w - 1;
+      fill_span(y, left, right, ctx->fill_color);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// layers and windows
+// -----------------------------------------------------------------------------
+
+struct Layer
+{
+  GRect frame;
+  GRect bounds;
+  bool is_hidden;
+  Layer* parent;
+  Layer* first_child;
+  Layer* next_sibling;
+  LayerUpdateProc update_proc;
+  BitmapLayer* bitmap_layer;   // set if this is one
+  Window* window;              // set on the root layer
+};
+
+struct BitmapLayer
+{
+  Layer layer;
+  const GBitmap* bitmap;
+  GCompOp comp_op;
+};
+
+struct Window
+{
+  Layer root;
+  GColor background_color;
+  WindowHandlers handlers;
+  bool is_loaded;
+};
+
+static Window* s_window = NULL;
+static bool s_is_dirty = false;
+static uint32_t s_render_count = 0;
+
+// unobstructed screen height, below it the timeline peek
+static int s_unobstructed_height = SCREEN_HEIGHT;
+
+static void init_layer(Layer* layer, GRect frame)
+{
+  memset(layer, 0, sizeof(Layer));
+  layer->frame = frame;
+  layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+}
+
+Layer* layer_create(GRect frame)
+{
+  Layer* layer = malloc(sizeof(Layer));
+  if (layer) init_layer(layer, frame);
+  return layer;
+}
+
+void layer_remove_from_parent(Layer* child)
+{
+  Layer* parent = child->parent;
+  if (parent == NULL) return;
+
+  for (Layer** link = &parent->first_child; *link; link = &(*link)->next_sibling)
+  {
+    if (*link == child)
+    {
+      *link = child->next_sibling;
+      break;
+    }
+  }
+  child->parent = NULL;
+  child->next_sibling = NULL;
+  s_is_dirty = true;
+}
+
+static void detach_layer(Layer* layer)
+{
+  layer_remove_from_parent(layer);
+  for (Layer* child = layer->first_child; child; )
+  {
+    Layer* next = child->next_sibling;
+    child->parent = NULL;
+    child->next_sibling = NULL;
+    child = next;
+  }
+  layer->first_child = NULL;
+}
+
+void layer_destroy(Layer* layer)
+{
+  if (layer == NULL) return;
+  detach_layer(layer);
+  free(layer);
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc)
+{
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer* layer)
+{
+  s_is_dirty = true;
+}
+
+// bounds that matched the frame follow it
+void layer_set_frame(Layer* layer, GRect frame)
+{
+  bool is_bounds_in_sync = layer->bounds.origin.x == 0 && layer->bounds.origin.y == 0 &&
+                           layer->bounds.size.w == layer->frame.size.w && layer->bounds.size.h == layer->frame.size.h;
+  layer->frame = frame;
+  if (is_bounds_in_sync) layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+  s_is_dirty = true;
+}
+
+GRect layer_get_frame(const Layer* layer)
+{
+  return layer->frame;
+}
+
+void layer_set_bounds(Layer* layer, GRect bounds)
+{
+  layer->bounds = bounds;
+  s_is_dirty = true;
+}
+
+GRect layer_get_bounds(const Layer* layer)
+{
+  return layer->bounds;
+}
+
+// top left of the layer's frame on screen
+static GPoint get_screen_origin(const Layer* layer)
+{
+  GPoint origin = layer->frame.origin;
+  for (const Layer* parent = layer->parent; parent; parent = parent->parent)
+  {
+    origin.x += parent->frame.origin.x + parent->bounds.origin.x;
+    origin.y += parent->frame.origin.y + parent->bounds.origin.y;
+  }
+  return origin;
+}
+
+GRect layer_get_unobstructed_bounds(const Layer* layer)
+{
+  GPoint origin = get_screen_origin(layer);
+  GRect frame = { origin, layer->frame.size };
+  GRect visible = intersect_rects(frame, GRect(0, 0, SCREEN_WIDTH, s_unobstructed_height));
+
+  GRect bounds = layer->bounds;
+  bounds.origin.x += visible.origin.x - origin.x;
+  bounds.origin.y += visible.origin.y - origin.y;
+  bounds.size = visible.size;
+  return bounds;
+}
+
+void layer_set_hidden(Layer* layer, bool hidden)
+{
+  if (layer->is_hidden != hidden) s_is_dirty = true;
+  layer->is_hidden = hidden;
+}
+
+bool layer_get_hidden(const Layer* layer)
+{
+  return layer->is_hidden;
+}
+
+void layer_add_child(Layer* parent, Layer* child)
+{
+  layer_remove_from_parent(child);
+
+  Layer** link = &parent->first_child;
+  while (*link) link = &(*link)->next_sibling;
+  *link = child;
+  child->parent = parent;
+  s_is_dirty = true;
+}
+
+void layer_insert_below_sibling(Layer* layer_to_insert, Layer* below_sibling_layer)
+{
+  Layer* parent = below_sibling_layer->parent;
+  if (parent == NULL) return;
+  layer_remove_from_parent(layer_to_insert);
+
+  Layer** link = &parent->first_child;
+  while (*link != below_sibling_layer) link = &(*link)->next_sibling;
+  layer_to_insert->next_sibling = below_sibling_layer;
+  *link = layer_to_insert;
+  layer_to_insert->parent = parent;
+  s_is_dirty = true;
+}
+
+// centered in the layer's bounds, as the firmware aligns it by default
+static void bitmap_layer_update_proc(Layer* layer, GContext* ctx)
+{
+  BitmapLayer* bitmap_layer = layer->bitmap_layer;
+  if (bitmap_layer->bitmap == NULL) return;
+
+  GSize size = bitmap_layer->bitmap->bounds.size;
+  GRect rect = GRect((layer->bounds.size.w - size.w) / 2, (layer->bounds.size.h - size.h) / 2, size.w, size.h);
+  graphics_context_set_compositing_mode(ctx, bitmap_layer->comp_op);
+  graphics_draw_bitmap_in_rect(ctx, bitmap_layer->bitmap, rect);
+}
+
+BitmapLayer* bitmap_layer_create(GRect frame)
+{
+  BitmapLayer* bitmap_layer = malloc(sizeof(BitmapLayer));
+  if (bitmap_layer == NULL) return NULL;
+
+  init_layer(&bitmap_layer->layer, frame);
+  bitmap_layer->layer.bitmap_layer = bitmap_layer;
+  bitmap_layer->layer.update_proc = bitmap_layer_update_proc;
+  bitmap_layer->bitmap = NULL;
+  bitmap_layer->comp_op = GCompOpAssign;
+  return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer* bitmap_layer)
+{
+  if (bitmap_layer == NULL) return;
+  detach_layer(&bitmap_layer->layer);
+  free(bitmap_layer);
+}
+
+Layer* bitmap_layer_get_layer(const BitmapLayer* bitmap_layer)
+{
+  return (Layer*)&bitmap_layer->layer;
+}
+
+const GBitmap* bitmap_layer_get_bitmap(BitmapLayer* bitmap_layer)
+{
+  return bitmap_layer->bitmap;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer* bitmap_layer, const GBitmap* bitmap)
+{
+  bitmap_layer->bitmap = bitmap;
+  s_is_dirty = true;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer* bitmap_layer, GCompOp mode)
+{
+  bitmap_layer->comp_op = mode;
+  s_is_dirty = true;
+}
+
+Window* window_create(void)
+{
+  Window* window = calloc(1, sizeof(Window));
+  if (window == NULL) return NULL;
+
+  init_layer(&window->root, GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+  window->root.window = window;
+  window->background_color = GColorWhite;
+  return window;
+}
+
+void window_destroy(Window* window)
+{
+  if (window == NULL) return;
+
+  if (window->is_loaded && window->handlers.unload) window->handlers.unload(window);
+  window->is_loaded = false;
+  if (s_window == window) s_window = NULL;
+  detach_layer(&window->root);
+  free(window);
+}
+
+void window_set_window_handlers(Window* window, WindowHandlers handlers)
+{
+  window->handlers = handlers;
+}
+
+void window_set_background_color(Window* window, GColor background_color)
+{
+  window->background_color = background_color;
+  s_is_dirty = true;
+}
+
+Layer* window_get_root_layer(const Window* window)
+{
+  return (Layer*)&window->root;
+}
+
+void window_stack_push(Window* window, bool animated)
+{
+  s_window = window;
+  if (!window->is_loaded && window->handlers.load) window->handlers.load(window);
+  window->is_loaded = true;
+  if (window->handlers.appear) window->handlers.appear(window);
+  s_is_dirty = true;
+}
+
+// -----------------------------------------------------------------------------
+// rendering
+// -----------------------------------------------------------------------------
+
+static void render_layer(Layer* layer, GPoint parent_origin, GRect clip)
+{
+  if (layer->is_hidden) return;
+
+  GRect frame = GRect(parent_origin.x + layer->frame.origin.x, parent_origin.y + layer->frame.origin.y,
+                      layer->frame.size.w, layer->frame.size.h);
+  GPoint origin = GPoint(frame.origin.x + layer->bounds.origin.x, frame.origin.y + layer->bounds.origin.y);
+  clip = intersect_rects(clip, frame);
+
+  if (layer->update_proc)
+  {
+    s_context.origin = origin;
+    s_context.clip = clip;
+    s_context.comp_op = GCompOpAssign;
+    s_context.fill_color = GColorBlack;
+    layer->update_proc(layer, &s_context);
+  }
+
+  for (Layer* child = layer->first_child; child; child = child->next_sibling)
+    render_layer(child, origin, clip);
+}
+
+void host_render(void)
+{
+  s_is_dirty = false;
+  if (s_window == NULL || !s_window->is_loaded) return;
+
+  for (int y = 0; y < SCREEN_HEIGHT; ++y)
+    fill_span(y, 0, SCREEN_WIDTH - 1, s_window->background_color);
+
+  render_layer(&s_window->root, GPointZero, GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+  ++s_render_count;
+}
+
+uint32_t host_get_render_count(void)
+{
+  return s_render_count;
+}
+
+GContext* host_get_layer_context(Layer* layer)
+{
+  GPoint origin = get_screen_origin(layer);
+  s_context.origin = GPoint(origin.x + layer->bounds.origin.x, origin.y + layer->bounds.origin.y);
+  s_context.clip = intersect_rects(GRect(origin.x, origin.y, layer->frame.size.w, layer->frame.size.h),
+                                   GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT));
+  s_context.comp_op = GCompOpAssign;
+  s_context.fill_color = GColorBlack;
+  s_context.is_frame_buffer_captured = false;
+  return &s_context;
+}
+
+// -----------------------------------------------------------------------------
+// timers
+// -----------------------------------------------------------------------------
+
+// handles are ids, so a fired or cancelled timer can be cancelled again
+struct HostTimer
+{
+  uint32_t id;
+  int64_t fire_ms;
+  AppTimerCallback callback;
+  void* data;
+  struct HostTimer* next;
+};
+
+static struct HostTimer* s_timers = NULL;
+static uint32_t s_next_timer_id = 1;
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void* callback_data)
+{
+  // timers live in the system's memory, not the app heap
+  struct HostTimer* timer = (malloc)(sizeof(struct HostTimer));
+  timer->id = s_next_timer_id++;
+  timer->fire_ms = s_now_ms + timeout_ms;
+  timer->callback = callback;
+  timer->data = callback_data;
+
+  // after the timers due at the same time
+  struct HostTimer** link = &s_timers;
+  while (*link && (*link)->fire_ms <= timer->fire_ms) link = &(*link)->next;
+  timer->next = *link;
+  *link = timer;
+
+  return (AppTimer*)(uintptr_t)timer->id;
+}
+
+void app_timer_cancel(AppTimer* timer_handle)
+{
+  for (struct HostTimer** link = &s_timers; *link; link = &(*link)->next)
+  {
+    if ((*link)->id == (uint32_t)(uintptr_t)timer_handle)
+    {
+      struct HostTimer* timer = *link;
+      *link = timer->next;
+      (free)(timer);
+      return;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// animations
+// -----------------------------------------------------------------------------
+
+struct Animation
+{
+  uint32_t delay_ms;
+  uint32_t duration_ms;
+  AnimationImplementation implementation;
+  bool is_scheduled;
+  int64_t start_ms;
+  int64_t next_frame_ms;
+  Animation* next;    // all animations alive
+};
+
+static Animation* s_animations = NULL;
+
+static bool is_animation(Animation* animation)
+{
+  for (Animation* alive = s_animations; alive; alive = alive->next)
+  {
+    if (alive == animation) return true;
+  }
+  return false;
+}
+
+Animation* animation_create(void)
+{
+  Animation* animation = calloc(1, sizeof(Animation));
+  if (animation == NULL) return NULL;
+
+  animation->duration_ms = 250;
+  animation->next = s_animations;
+  s_animations = animation;
+  return animation;
+}
+
+bool animation_unschedule(Animation* animation)
+{
+  if (!is_animation(animation) || !animation->is_scheduled) return false;
+
+  animation->is_scheduled = false;
+  if (animation->implementation.teardown) animation->implementation.teardown(animation);
+  return true;
+}
+
+bool animation_destroy(Animation* animation)
+{
+  if (!is_animation(animation)) return false;
+  animation_unschedule(animation);
+
+  for (Animation** link = &s_animations; *link; link = &(*link)->next)
+  {
+    if (*link == animation)
+    {
+      *link = animation->next;
+      break;
+    }
+  }
+  free(animation);
+  return true;
+}
+
+bool animation_set_delay(Animation* animation, uint32_t delay_ms)
+{
+  animation->delay_ms = delay_ms;
+  return true;
+}
+
+bool animation_set_duration(Animation* animation, uint32_t duration_ms)
+{
+  animation->duration_ms = duration_ms;
+  return true;
+}
+
+bool animation_set_implementation(Animation* animation, const AnimationImplementation* implementation)
+{
+  animation->implementation = *implementation;
+  return true;
+}
+
+bool animation_schedule(Animation* animation)
+{
+  if (!is_animation(animation) || animation->is_scheduled) return false;
+
+  animation->is_scheduled = true;
+  animation->start_ms = s_now_ms + animation->delay_ms;
+  animation->next_frame_ms = animation->start_ms + HOST_FRAME_MS;
+  if (animation->next_frame_ms > animation->start_ms + animation->duration_ms)
+    animation->next_frame_ms = animation->start_ms + animation->duration_ms;
+  if (animation->implementation.setup) animation->implementation.setup(animation);
+  return true;
+}
+
+bool animation_is_scheduled(Animation* animation)
+{
+  return is_animation(animation) && animation->is_scheduled;
+}
+
+uint32_t host_get_scheduled_animations(void)
+{
+  uint32_t num = 0;
+  for (Animation* animation = s_animations; animation; animation = animation->next)
+  {
+    if (animation->is_scheduled) ++num;
+  }
+  return num;
+}
+
+static void step_animation(Animation* animation)
+{
+  int64_t end_ms = animation->start_ms + animation->duration_ms;
+  AnimationProgress progress = (animation->duration_ms == 0 || s_now_ms >= end_ms) ? ANIMATION_NORMALIZED_MAX :
+    (AnimationProgress)((s_now_ms - animation->start_ms) * ANIMATION_NORMALIZED_MAX / animation->duration_ms);
+
+  if (animation->implementation.update) animation->implementation.update(animation, progress);
+  if (!animation->is_scheduled) return;
+
+  if (progress < ANIMATION_NORMALIZED_MAX)
+  {
+    animation->next_frame_ms = s_now_ms + HOST_FRAME_MS;
+    if (animation->next_frame_ms > end_ms) animation->next_frame_ms = end_ms;
+    return;
+  }
+
+  animation_unschedule(animation);
+#ifndef PBL_PLATFORM_APLITE
+  // sdk 3 frees finished animations, aplite keeps them for the app to destroy
+  animation_destroy(animation);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// services
+// -----------------------------------------------------------------------------
+
+static TickHandler s_tick_handler = NULL;
+static TimeUnits s_tick_units;
+static int64_t s_next_tick_ms;
+
+static int64_t get_next_tick_ms(void)
+{
+  return (s_now_ms / 60000 + 1) * 60000;
+}
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler)
+{
+  s_tick_handler = handler;
+  s_tick_units = tick_units;
+  s_next_tick_ms = get_next_tick_ms();
+}
+
+void tick_timer_service_unsubscribe(void)
+{
+  s_tick_handler = NULL;
+}
+
+static void dispatch_tick(void)
+{
+  time_t now = (time_t)(s_now_ms / 1000);
+  struct tm* tick_time = host_localtime(&now);
+
+  TimeUnits units = MINUTE_UNIT;
+  if (tick_time->tm_min == 0) units |= HOUR_UNIT;
+  if (tick_time->tm_min == 0 && tick_time->tm_hour == 0) units |= DAY_UNIT;
+
+  s_next_tick_ms = get_next_tick_ms();
+  s_tick_handler(tick_time, units & (s_tick_units | MINUTE_UNIT));
+}
+
+static BatteryChargeState s_battery = { 80, false, false };
+static BatteryStateHandler s_battery_handler = NULL;
+
+BatteryChargeState battery_state_service_peek(void)
+{
+  return s_battery;
+}
+
+void battery_state_service_subscribe(BatteryStateHandler handler)
+{
+  s_battery_handler = handler;
+}
+
+void battery_state_service_unsubscribe(void)
+{
+  s_battery_handler = NULL;
+}
+
+void host_set_battery(BatteryChargeState state)
+{
+  s_battery = state;
+  if (s_battery_handler) s_battery_handler(state);
+}
+
+static UnobstructedAreaHandlers s_unobstructed_handlers;
+static void* s_unobstructed_context;
+static bool s_is_unobstructed_subscribed = false;
+static int s_obstruction_from, s_obstruction_to;
+static int64_t s_obstruction_start_ms, s_obstruction_frame_ms = -1;
+static uint32_t s_obstruction_duration_ms;
+
+void unobstructed_area_service_subscribe(UnobstructedAreaHandlers handlers, void* context)
+{
+  s_unobstructed_handlers = handlers;
+  s_unobstructed_context = context;
+  s_is_unobstructed_subscribed = true;
+}
+
+void unobstructed_area_service_unsubscribe(void)
+{
+  s_is_unobstructed_subscribed = false;
+}
+
+// the timeline peek sliding in over obstruction_height pixels, or out with 0
+void host_start_unobstructed_change(int obstruction_height, uint32_t duration_ms)
+{
+  s_obstruction_from = SCREEN_HEIGHT - s_unobstructed_height;
+  s_obstruction_to = obstruction_height;
+  s_obstruction_start_ms = s_now_ms;
+  s_obstruction_duration_ms = duration_ms ? duration_ms : 1;
+  s_obstruction_frame_ms = s_now_ms + HOST_FRAME_MS;
+
+  if (s_is_unobstructed_subscribed && s_unobstructed_handlers.will_change)
+    s_unobstructed_handlers.will_change(GRect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT - obstruction_height), s_unobstructed_context);
+}
+
+static void step_unobstructed_change(void)
+{
+  int64_t elapsed = s_now_ms - s_obstruction_start_ms;
+  if (elapsed > s_obstruction_duration_ms) elapsed = s_obstruction_duration_ms;
+  AnimationProgress progress = (AnimationProgress)(elapsed * ANIMATION_NORMALIZED_MAX / s_obstruction_duration_ms);
+
+  s_unobstructed_height = SCREEN_HEIGHT - (s_obstruction_from + (s_obstruction_to - s_obstruction_from) * progress / ANIMATION_NORMALIZED_MAX);
+  s_is_dirty = true;
+  if (s_is_unobstructed_subscribed && s_unobstructed_handlers.change)
+    s_unobstructed_handlers.change(progress, s_unobstructed_context);
+
+  if (progress < ANIMATION_NORMALIZED_MAX)
+  {
+    s_obstruction_frame_ms = s_now_ms + HOST_FRAME_MS;
+    if (s_obstruction_frame_ms > s_obstruction_start_ms + s_obstruction_duration_ms)
+      s_obstruction_frame_ms = s_obstruction_start_ms + s_obstruction_duration_ms;
+    return;
+  }
+
+  s_obstruction_frame_ms = -1;
+  if (s_is_unobstructed_subscribed && s_unobstructed_handlers.did_change)
+    s_unobstructed_handlers.did_change(s_unobstructed_context);
+}
+
+// -----------------------------------------------------------------------------
+// event loop
+// -----------------------------------------------------------------------------
+
+enum HostEvent
+{
+  HOST_EVENT_NONE = 0,
+  HOST_EVENT_TIMER,
+  HOST_EVENT_ANIMATION,
+  HOST_EVENT_UNOBSTRUCTED,
+  HOST_EVENT_TICK,
+};
+
+// the next event due, timers first among those due at the same time
+static enum HostEvent get_next_event(int64_t* due_ms, Animation** due_animation)
+{
+  enum HostEvent event = HOST_EVENT_NONE;
+  if (s_timers)
+  {
+    event = HOST_EVENT_TIMER;
+    *due_ms = s_timers->fire_ms;
+  }
+  for (Animation* animation = s_animations; animation; animation = animation->next)
+  {
+    if (animation->is_scheduled && (event == HOST_EVENT_NONE || animation->next_frame_ms < *due_ms))
+    {
+      event = HOST_EVENT_ANIMATION;
+      *due_ms = animation->next_frame_ms;
+      *due_animation = animation;
+    }
+  }
+  if (s_obstruction_frame_ms >= 0 && (event == HOST_EVENT_NONE || s_obstruction_frame_ms < *due_ms))
+  {
+    event = HOST_EVENT_UNOBSTRUCTED;
+    *due_ms = s_obstruction_frame_ms;
+  }
+  if (s_tick_handler && (event == HOST_EVENT_NONE || s_next_tick_ms < *due_ms))
+  {
+    event = HOST_EVENT_TICK;
+    *due_ms = s_next_tick_ms;
+  }
+  return event;
+}
+
+static void run_until(int64_t limit_ms)
+{
+  if (s_is_dirty) host_render();
+
+  while (!s_is_stopped)
+  {
+    int64_t due_ms = 0;
+    Animation* due_animation = NULL;
+    enum HostEvent event = get_next_event(&due_ms, &due_animation);
+    if (event == HOST_EVENT_NONE || due_ms > limit_ms) break;
+
+    if (due_ms > s_now_ms) s_now_ms = due_ms;
+    switch (event)
+    {
+    case HOST_EVENT_TIMER:
+    {
+      struct HostTimer* timer = s_timers;
+      s_timers = timer->next;
+      AppTimerCallback callback = timer->callback;
+      void* data = timer->data;
+      (free)(timer);
+      callback(data);
+      break;
+    }
+    case HOST_EVENT_ANIMATION:
+      step_animation(due_animation);
+      break;
+    case HOST_EVENT_UNOBSTRUCTED:
+      step_unobstructed_change();
+      break;
+    default:
+      dispatch_tick();
+      break;
+    }
+
+    if (s_is_dirty) host_render();
+  }
+
+  if (!s_is_stopped && limit_ms != INT64_MAX && limit_ms > s_now_ms) s_now_ms = limit_ms;
+}
+
+void host_run_for(uint32_t ms)
+{
+  run_until(s_now_ms + ms);
+}
+
+void app_event_loop(void)
+{
+  run_until(s_run_limit_ms ? s_now_ms + s_run_limit_ms : INT64_MAX);
+}
+
+// -----------------------------------------------------------------------------
+// persist
+// -----------------------------------------------------------------------------
+
+#define PERSIST_KEY_NUM 32
+
+struct PersistEntry
+{
+  bool is_used;
+  uint32_t key;
+  int size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+};
+
+static struct PersistEntry s_persist[PERSIST_KEY_NUM];
+static uint32_t s_persist_writes = 0;
+
+static struct PersistEntry* find_persist(uint32_t key)
+{
+  for (int i = 0; i < PERSIST_KEY_NUM; ++i)
+  {
+    if (s_persist[i].is_used && s_persist[i].key == key) return &s_persist[i];
+  }
+  return NULL;
+}
+
+bool persist_exists(uint32_t key)
+{
+  return find_persist(key) != NULL;
+}
+
+int persist_get_size(uint32_t key)
+{
+  struct PersistEntry* entry = find_persist(key);
+  return entry ? entry->size : E_DOES_NOT_EXIST;
+}
+
+int persist_read_data(uint32_t key, void* buffer, size_t buffer_size)
+{
+  struct PersistEntry* entry = find_persist(key);
+  if (entry == NULL) return E_DOES_NOT_EXIST;
+
+  int size = (entry->size < (int)buffer_size) ? entry->size : (int)buffer_size;
+  memcpy(buffer, entry->data, size);
+  return size;
+}
+
+int persist_write_data(uint32_t key, const void* data, size_t size)
+{
+  if (size > PERSIST_DATA_MAX_LENGTH) size = PERSIST_DATA_MAX_LENGTH;
+
+  struct PersistEntry* entry = find_persist(key);
+  for (int i = 0; i < PERSIST_KEY_NUM && entry == NULL; ++i)
+  {
+    if (!s_persist[i].is_used) entry = &s_persist[i];
+  }
+  if (entry == NULL) return E_RANGE;
+
+  entry->is_used = true;
+  entry->key = key;
+  entry->size = (int)size;
+  memcpy(entry->data, data, size);
+  ++s_persist_writes;
+  return (int)size;
+}
+
+int32_t persist_read_int(uint32_t key)
+{
+  int32_t value = 0;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+int persist_write_int(uint32_t key, int32_t value)
+{
+  return persist_write_data(key, &value, sizeof(value));
+}
+
+int persist_delete(uint32_t key)
+{
+  struct PersistEntry* entry = find_persist(key);
+  if (entry == NULL) return E_DOES_NOT_EXIST;
+  entry->is_used = false;
+  ++s_persist_writes;
+  return S_SUCCESS;
+}
+
+uint32_t host_get_persist_writes(void)
+{
+  return s_persist_writes;
+}
+
+void host_persist_clear(void)
+{
+  memset(s_persist, 0, sizeof(s_persist));
+}
+
+// -----------------------------------------------------------------------------
+// resources
+// -----------------------------------------------------------------------------
+
+ResHandle resource_get_handle(uint32_t resource_id)
+{
+  return find_resource(resource_id);
+}
+
+size_t resource_size(ResHandle h)
+{
+  return h ? h->size : 0;
+}
+
+size_t resource_load(ResHandle h, uint8_t* buffer, size_t max_length)
+{
+  return resource_load_byte_range(h, 0, buffer, max_length);
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t* buffer, size_t num_bytes)
+{
+  if (h == NULL || start_offset >= h->size) return 0;
+  if (num_bytes > h->size - start_offset) num_bytes = h->size - start_offset;
+  memcpy(buffer, h->data + start_offset, num_bytes);
+  return num_bytes;
+}
+
+// -----------------------------------------------------------------------------
+// dictionaries
+// -----------------------------------------------------------------------------
+
+struct __attribute__((__packed__)) Dictionary
+{
+  uint8_t count;
+  Tuple head[];
+};
+
+#define TUPLE_HEADER_SIZE ((uint16_t)sizeof(Tuple))
+
+static Tuple* get_next_tuple(Tuple* tuple)
+{
+  return (Tuple*)((uint8_t*)tuple + TUPLE_HEADER_SIZE + tuple->length);
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator* iter, uint8_t* const buffer, const uint16_t size)
+{
+  if (iter == NULL || buffer == NULL || size < sizeof(Dictionary)) return DICT_INVALID_ARGS;
+
+  iter->dictionary = (Dictionary*)buffer;
+  iter->dictionary->count = 0;
+  iter->cursor = iter->dictionary->head;
+  iter->end = buffer + size;
+  return DICT_OK;
+}
+
+static DictionaryResult write_tuple(DictionaryIterator* iter, uint32_t key, TupleType type, const void* data, uint16_t length)
+{
+  if ((uint8_t*)iter->cursor + TUPLE_HEADER_SIZE + length > (const uint8_t*)iter->end) return DICT_NOT_ENOUGH_STORAGE;
+
+  Tuple* tuple = iter->cursor;
+  tuple->key = key;
+  tuple->type = type;
+  tuple->length = length;
+  if (length) memcpy(tuple->value->data, data, length);
+
+  iter->cursor = get_next_tuple(tuple);
+  ++iter->dictionary->count;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator* iter, const uint32_t key, const uint8_t* const data, const uint16_t size)
+{
+  return write_tuple(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator* iter, const uint32_t key, const char* const cstring)
+{
+  return write_tuple(iter, key, TUPLE_CSTRING, cstring, cstring ? (uint16_t)(strlen(cstring) + 1) : 0);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator* iter, const uint32_t key, const uint8_t value)
+{
+  return write_tuple(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint16(DictionaryIterator* iter, const uint32_t key, const uint16_t value)
+{
+  return write_tuple(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_uint32(DictionaryIterator* iter, const uint32_t key, const uint32_t value)
+{
+  return write_tuple(iter, key, TUPLE_UINT, &value, sizeof(value));
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator* iter, const uint32_t key, const int32_t value)
+{
+  return write_tuple(iter, key, TUPLE_INT, &value, sizeof(value));
+}
+
+uint32_t dict_write_end(DictionaryIterator* iter)
+{
+  iter->end = iter->cursor;
+  return (uint32_t)((uint8_t*)iter->cursor - (uint8_t*)iter->dictionary);
+}
+
+Tuple* dict_read_begin_from_buffer(DictionaryIterator* iter, const uint8_t* const buffer, const uint16_t size)
+{
+  iter->dictionary = (Dictionary*)buffer;
+  iter->end = buffer + size;
+  return dict_read_first(iter);
+}
+
+Tuple* dict_read_first(DictionaryIterator* iter)
+{
+  iter->cursor = iter->dictionary->head;
+  if (iter->dictionary->count == 0 || (const uint8_t*)iter->cursor >= (const uint8_t*)iter->end) return NULL;
+  return iter->cursor;
+}
+
+Tuple* dict_read_next(DictionaryIterator* iter)
+{
+  if ((const uint8_t*)iter->cursor >= (const uint8_t*)iter->end) return NULL;
+
+  iter->cursor = get_next_tuple(iter->cursor);
+  if ((const uint8_t*)iter->cursor >= (const uint8_t*)iter->end) return NULL;
+  return iter->cursor;
+}
+
+Tuple* dict_find(const DictionaryIterator* iter, const uint32_t key)
+{
+  Tuple* tuple = iter->dictionary->head;
+  for (int i = 0; i < iter->dictionary->count && (const uint8_t*)tuple < (const uint8_t*)iter->end; ++i)
+  {
+    if (tuple->key == key) return tuple;
+    tuple = get_next_tuple(tuple);
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// app messages
+// -----------------------------------------------------------------------------
+
+#define APP_MESSAGE_INBOX_MAX   2044
+#define APP_MESSAGE_OUTBOX_MAX  656
+
+static AppMessageInboxReceived s_inbox_received = NULL;
+static AppMessageInboxDropped s_inbox_dropped = NULL;
+static AppMessageOutboxSent s_outbox_sent = NULL;
+static AppMessageOutboxFailed s_outbox_failed = NULL;
+static AppMessageResult s_outbox_result = APP_MSG_OK;
+
+static uint8_t s_outbox[APP_MESSAGE_OUTBOX_MAX];
+static uint8_t s_last_outbox[APP_MESSAGE_OUTBOX_MAX];
+static uint16_t s_last_outbox_size = 0;
+static uint32_t s_outbox_count = 0;
+static DictionaryIterator s_outbox_iterator;
+static bool s_is_outbox_open = false;    // between begin and send
+static bool s_is_outbox_busy = false;    // sent, the phone has not answered yet
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound)
+{
+  return APP_MSG_OK;
+}
+
+uint32_t app_message_inbox_size_maximum(void)
+{
+  return APP_MESSAGE_INBOX_MAX;
+}
+
+uint32_t app_message_outbox_size_maximum(void)
+{
+  return APP_MESSAGE_OUTBOX_MAX;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback)
+{
+  AppMessageInboxReceived previous = s_inbox_received;
+  s_inbox_received = received_callback;
+  return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback)
+{
+  AppMessageInboxDropped previous = s_inbox_dropped;
+  s_inbox_dropped = dropped_callback;
+  return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback)
+{
+  AppMessageOutboxSent previous = s_outbox_sent;
+  s_outbox_sent = sent_callback;
+  return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback)
+{
+  AppMessageOutboxFailed previous = s_outbox_failed;
+  s_outbox_failed = failed_callback;
+  return previous;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator** iterator)
+{
+  if (s_is_outbox_open || s_is_outbox_busy) return APP_MSG_BUSY;
+
+  dict_write_begin(&s_outbox_iterator, s_outbox, sizeof(s_outbox));
+  s_is_outbox_open = true;
+  *iterator = &s_outbox_iterator;
+  return APP_MSG_OK;
+}
+
+// the phone answers on the next turn of the event loop
+static void complete_outbox(void* data)
+{
+  DictionaryIterator iterator;
+  dict_read_begin_from_buffer(&iterator, s_last_outbox, s_last_outbox_size);
+  s_is_outbox_busy = false;
+
+  if (s_outbox_result == APP_MSG_OK)
+  {
+    if (s_outbox_sent) s_outbox_sent(&iterator, NULL);
+  }
+  else if (s_outbox_failed)
+  {
+    s_outbox_failed(&iterator, s_outbox_result, NULL);
+  }
+}
+
+AppMessageResult app_message_outbox_send(void)
+{
+  if (!s_is_outbox_open) return APP_MSG_BUSY;
+
+  s_last_outbox_size = (uint16_t)dict_write_end(&s_outbox_iterator);
+  memcpy(s_last_outbox, s_outbox, s_last_outbox_size);
+  s_is_outbox_open = false;
+  s_is_outbox_busy = true;
+  ++s_outbox_count;
+
+  app_timer_register(0, complete_outbox, NULL);
+  return APP_MSG_OK;
+}
+
+void host_set_outbox_result(AppMessageResult result)
+{
+  s_outbox_result = result;
+}
+
+const uint8_t* host_get_last_outbox(uint16_t* size)
+{
+  if (size) *size = s_last_outbox_size;
+  return s_last_outbox_size ? s_last_outbox : NULL;
+}
+
+uint32_t host_get_outbox_count(void)
+{
+  return s_outbox_count;
+}
+
+void host_deliver_message(const uint8_t* buffer, uint16_t size)
+{
+  if (s_inbox_received == NULL) return;
+
+  DictionaryIterator iterator;
+  dict_read_begin_from_buffer(&iterator, buffer, size);
+  s_inbox_received(&iterator, NULL);
+}
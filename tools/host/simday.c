@@ -0,0 +1,27 @@
+// the face's simulated day (--sim-day, or a recorded trace with --sim-trace)
+// run on the host, its logs on stdout for tools/sim_day.py --host:
+//
+//   make -C tools/host simday                      the built-in day, every platform
+//   make -C tools/host simday TRACE=day.trace PLATFORMS=basalt
+//
+// the face runs as launched on the watch, from its own main. the simulated
+// clock only moves between handlers, so the counters of time (awake_ms and
+// the like) are 0 here, the counts of work done are the watch's.
+
+#include "face.h"
+
+#define SIMDAY_TIME   1792800000   // 2026-10-24 00:00, local
+
+int main(void)
+{
+  host_set_time(SIMDAY_TIME);
+  host_stop_on_log("SIM,done");
+  klk_main();
+
+  if (!host_is_stopped())
+  {
+    fprintf(stderr, "simday: the day did not finish\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// checks of the host tests (tools/host/test_*.c, make -C tools/host test). a
+// failed check reports where and carries on, test_finish gives main's status.
+
+static int s_test_checks = 0;
+static int s_test_failures = 0;
+
+#define CHECK(condition) \
+  test_check((condition), __FILE__, __LINE__, #condition)
+
+// integers, reporting both values
+#define CHECK_EQ(actual, expected) \
+  test_check_eq((long long)(actual), (long long)(expected), __FILE__, __LINE__, #actual)
+
+static inline bool test_check(bool condition, const char* file, int line, const char* text)
+{
+  ++s_test_checks;
+  if (!condition)
+  {
+    // the first few are enough to go on, a broken loop would flood the log
+    if (++s_test_failures <= 20) fprintf(stderr, "%s:%d: failed: %s\n", file, line, text);
+  }
+  return condition;
+}
+
+static inline bool test_check_eq(long long actual, long long expected, const char* file, int line, const char* text)
+{
+  ++s_test_checks;
+  if (actual != expected)
+  {
+    if (++s_test_failures <= 20) fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", file, line, text, actual, expected);
+    return false;
+  }
+  return true;
+}
+
+// a launch of the face in a process of its own, its statics start as they do
+// on the watch. the counts come back through a pipe, a crash is a failure
+static inline void test_launch(void (*test)(void))
+{
+  int counts[2];
+  int fds[2];
+  fflush(stdout);
+  fflush(stderr);
+  if (pipe(fds) != 0) return;
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    s_test_checks = s_test_failures = 0;
+    test();
+    counts[0] = s_test_checks;
+    counts[1] = s_test_failures;
+    if (write(fds[1], counts, sizeof(counts)) != sizeof(counts)) _exit(1);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(0);
+  }
+  close(fds[1]);
+
+  int status = 0;
+  bool is_read = read(fds[0], counts, sizeof(counts)) == sizeof(counts);
+  close(fds[0]);
+  waitpid(pid, &status, 0);
+  if (!is_read || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+  {
+    ++s_test_checks;
+    ++s_test_failures;
+    fprintf(stderr, "a launch did not finish, status %d\n", status);
+    return;
+  }
+  s_test_checks += counts[0];
+  s_test_failures += counts[1];
+}
+
+static inline int test_finish(const char* name)
+{
+  printf("%s: %d checks, %d failed\n", name, s_test_checks, s_test_failures);
+  return s_test_failures ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+// a watch without a persisted config asks the companion for all of it once
+// it is up, a busy outbox puts the request off, and a watch with a config
+// asks for nothing. each launch runs in a process of its own.
+
+#include "face.h"
+#include "test.h"
+
+#define TEST_TIME 1792804140   // 2026-10-24 01:09, local
+
+static bool is_last_outbox_request(void)
+{
+  uint16_t size;
+  const uint8_t* buffer = host_get_last_outbox(&size);
+  if (buffer == NULL) return false;
+
+  DictionaryIterator iterator;
+  dict_read_begin_from_buffer(&iterator, buffer, size);
+  return dict_find(&iterator, MSG_CONFIG_REQUEST) != NULL;
+}
+
+static void test_missing_config(void)
+{
+  start_face(TEST_TIME);
+  CHECK(is_config_missing);
+
+  host_run_for(CONFIG_REQUEST_DELAY_MS);
+  CHECK_EQ(host_get_outbox_count(), 1);
+  CHECK(is_last_outbox_request());
+
+  // the companion answers with the whole config, the watch has one from then on
+  uint8_t buffer[64];
+  DictionaryIterator iterator;
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_ENABLE_MONTH, 1);
+  host_deliver_message(buffer, dict_write_end(&iterator));
+  host_run_for(5000);
+  CHECK(!is_config_missing);
+  CHECK(persist_exists(PERSIST_CONFIG));
+  deinit();
+}
+
+static void test_saved_config(void)
+{
+  struct ConfigData saved = { .bg_color = GColorBlack, .time_color = GColorWhite, .is_enable_month = true };
+  persist_write_data(PERSIST_CONFIG, &saved, sizeof(saved));
+
+  start_face(TEST_TIME);
+  CHECK(!is_config_missing);
+  CHECK(config_data.is_enable_month);
+
+  host_run_for(CONFIG_REQUEST_DELAY_MS + 5000);
+  CHECK_EQ(host_get_outbox_count(), 0);
+  deinit();
+}
+
+static void test_busy_outbox(void)
+{
+  start_face(TEST_TIME);
+
+  // another message holds the outbox when the request is due
+  DictionaryIterator* iterator;
+  CHECK_EQ(app_message_outbox_begin(&iterator), APP_MSG_OK);
+  host_run_for(CONFIG_REQUEST_DELAY_MS);
+  CHECK_EQ(host_get_outbox_count(), 0);
+
+  dict_write_uint8(iterator, MSG_TELEMETRY_BATTERY_MIN, 0);
+  app_message_outbox_send();
+  host_run_for(CONFIG_REQUEST_RETRY_MS + 100);
+  CHECK_EQ(host_get_outbox_count(), 2);
+  CHECK(is_last_outbox_request());
+  deinit();
+}
+
+int main(void)
+{
+  test_launch(test_missing_config);
+  test_launch(test_saved_config);
+  test_launch(test_busy_outbox);
+  return test_finish("test_config_request");
+}
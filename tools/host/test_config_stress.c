@@ -0,0 +1,91 @@
+// 1,000 config applies in a row leave the heap as they found it. an apply
+// allocates the Animation of the transition it starts, freed when it ends,
+// and a row shown the first time loads its font, once: the warm-up pass below
+// measures those loads. past it, the largest free block stays flat: the
+// atlases are kept whole, and the cell cache of aplite and diorite loads and
+// drops glyphs as the numerals change in a store it allocated up front.
+
+#include "face.h"
+#include "test.h"
+
+#define TEST_TIME       1792804140   // 2026-10-24 01:09, local
+#define APPLY_NUM       1000
+#define WARM_UP_NUM     30           // every combination of the toggles below
+#define APPLY_MS        2000         // past the transition an apply starts
+
+static const char* s_colors[] = { "0x000000", "0xFFFFFF", "0x0055AA", "0xFFAA00", "0x55FF55", "0xFF0000" };
+
+// a config message of the companion, the i-th of a run through the colors and
+// the rows, lunar months and formal numerals switched on and off. returns
+// once no transition runs, a minute's included
+static void apply_config(int i)
+{
+  uint8_t buffer[256];
+  DictionaryIterator iterator;
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  dict_write_cstring(&iterator, MSG_CONFIG_BG_COLOR, s_colors[i % ARRAY_LENGTH(s_colors)]);
+  dict_write_cstring(&iterator, MSG_CONFIG_TIME_COLOR, s_colors[(i + 1) % ARRAY_LENGTH(s_colors)]);
+  dict_write_cstring(&iterator, MSG_CONFIG_DATE_COLOR, s_colors[(i + 3) % ARRAY_LENGTH(s_colors)]);
+  dict_write_cstring(&iterator, MSG_CONFIG_MONTH_COLOR, s_colors[(i + 4) % ARRAY_LENGTH(s_colors)]);
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_ENABLE_DATE, (i / 2) & 1);
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_ENABLE_MONTH, (i / 3) & 1);
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_ENABLE_YEAR, (i / 5) & 1);
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_USE_LUNAR, (i / 7) & 1);
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_USE_FORMAL, (i / 11) & 1);
+  host_deliver_message(buffer, dict_write_end(&iterator));
+
+  host_run_for(APPLY_MS);
+  while (transition_state != TRANSITION_IDLE) host_run_for(100);
+}
+
+// allocations besides the Animation of each transition
+static uint32_t get_allocations(void)
+{
+  return host_heap_allocations() - telemetry.transitions;
+}
+
+static void test_warm_up(void)
+{
+  uint32_t allocations = get_allocations();
+  size_t largest_free = host_heap_largest_free();
+  for (int i = 0; i < WARM_UP_NUM; ++i) apply_config(i);
+
+  // the rows off at launch load their fonts
+  uint32_t loads = get_allocations() - allocations;
+  printf("test_config_stress: the first %d applies allocate %u times for fonts, the largest free block %u to %u bytes\n",
+         WARM_UP_NUM, loads, (unsigned int)largest_free, (unsigned int)host_heap_largest_free());
+  CHECK(loads > 0);
+}
+
+static void test_applies(void)
+{
+  size_t largest_free = host_heap_largest_free();
+  size_t used = heap_bytes_used();
+  uint32_t allocations = get_allocations();
+  size_t min_largest_free = largest_free, max_used = used;
+
+  for (int i = WARM_UP_NUM; i < WARM_UP_NUM + APPLY_NUM; ++i)
+  {
+    apply_config(i);
+    if (host_heap_largest_free() < min_largest_free) min_largest_free = host_heap_largest_free();
+    if (heap_bytes_used() > max_used) max_used = heap_bytes_used();
+  }
+
+  printf("test_config_stress: %d applies allocate %u times, the largest free block %u to %u bytes at least\n",
+         APPLY_NUM, get_allocations() - allocations, (unsigned int)largest_free, (unsigned int)min_largest_free);
+  CHECK_EQ(get_allocations(), allocations);
+  CHECK_EQ(min_largest_free, largest_free);
+  CHECK_EQ(max_used, used);
+  CHECK_EQ(heap_bytes_used(), used);
+}
+
+int main(void)
+{
+  start_face(TEST_TIME);
+
+  test_warm_up();
+  test_applies();
+
+  deinit();
+  return test_finish("test_config_stress");
+}
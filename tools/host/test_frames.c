@@ -0,0 +1,97 @@
+// the transition's frame rate cap: frames at the firmware's pace are all
+// stepped up to ANIM_MAX_FPS, frames jittering around it are too, faster ones
+// are capped, and slower ones are all stepped without bunching up after.
+
+#include "face.h"
+#include "test.h"
+
+#define TEST_TIME 1792804140   // 2026-10-24 01:09, local
+
+#define CAP_FRAMES ((int)(STAR_TRANSITION_PERIOD * ANIM_MAX_FPS + 0.5f))
+
+// a transition of anim_update calls at the given frame times, ms from its
+// start, the transition's end included. returns the frames stepped
+static int run_frames(const int* frame_ms, int num)
+{
+  int duration_ms = (int)(STAR_TRANSITION_PERIOD * 1000);
+
+  profile_reset();
+  anim_setup(NULL);
+  for (int i = 0; i < num && frame_ms[i] < duration_ms; ++i)
+    anim_update(NULL, (AnimationProgress)((int64_t)frame_ms[i] * ANIMATION_NORMALIZED_MAX / duration_ms));
+  anim_update(NULL, ANIMATION_NORMALIZED_MAX);
+  anim_teardown(NULL);
+  return profile_get(PROFILE_ANIM_FRAMES);
+}
+
+// frames every period_ms, each moved by up to jitter_ms either way
+static int run_paced(int period_ms, int jitter_ms)
+{
+  static int frame_ms[1000];
+  uint32_t seed = 1;
+  int num = 0;
+  for (int t = period_ms; num < (int)ARRAY_LENGTH(frame_ms); t += period_ms)
+  {
+    seed = seed * 1103515245 + 12345;
+    int jitter = jitter_ms ? (int)((seed >> 16) % (2 * jitter_ms + 1)) - jitter_ms : 0;
+    frame_ms[num++] = t + jitter;
+  }
+  return run_frames(frame_ms, num);
+}
+
+// the transition as the firmware, here the host, animates it
+static void test_firmware_pace(void)
+{
+  profile_reset();
+  request_star_transition(TRANSITION_CHANGE_TIME);
+  host_run_for(3000);
+  CHECK_EQ(profile_get(PROFILE_TRANSITIONS), 1);
+
+  int frames = profile_get(PROFILE_ANIM_FRAMES);
+  int skipped = profile_get(PROFILE_FRAMES_SKIPPED);
+  if (!CHECK(frames >= CAP_FRAMES && frames <= CAP_FRAMES + 2))
+    fprintf(stderr, "  %d frames stepped, %d skipped, the cap is %d\n", frames, skipped, CAP_FRAMES);
+#ifndef PBL_PLATFORM_APLITE
+  // 30 fps frames are all stepped
+  CHECK_EQ(skipped, 0);
+#endif
+}
+
+static void test_paces(void)
+{
+  // the firmware's frames, a few ms early or late
+  int frames = run_paced(1000 / ANIM_MAX_FPS, 5);
+  if (!CHECK(frames >= CAP_FRAMES - 2 && frames <= CAP_FRAMES + 2))
+    fprintf(stderr, "  jittering frames: %d stepped, the cap is %d\n", frames, CAP_FRAMES);
+
+  // twice as fast as the cap, half of them are stepped
+  frames = run_paced(500 / ANIM_MAX_FPS, 0);
+  if (!CHECK(frames >= CAP_FRAMES - 1 && frames <= CAP_FRAMES + 2))
+    fprintf(stderr, "  fast frames: %d stepped, the cap is %d\n", frames, CAP_FRAMES);
+
+  // slower than the cap, each one is stepped
+  frames = run_paced(100, 0);
+  CHECK_EQ(frames, (int)(STAR_TRANSITION_PERIOD * 1000) / 100);
+
+  // a stall, the frames after it are not stepped any faster than the cap
+  static int stalled_ms[100];
+  int num = 0;
+  for (int t = 0; t < 200; t += 10) stalled_ms[num++] = t;
+  for (int t = 800; t < 1000; t += 10) stalled_ms[num++] = t;
+  frames = run_frames(stalled_ms, num);
+  int expected = 2 * 200 * ANIM_MAX_FPS / 1000;
+  if (!CHECK(frames >= expected && frames <= expected + 4))
+    fprintf(stderr, "  frames around a stall: %d stepped, %d expected\n", frames, expected);
+}
+
+int main(void)
+{
+  start_face(TEST_TIME);
+  host_run_for(5000);
+
+  test_firmware_pace();
+  test_paces();
+
+  deinit();
+  return test_finish("test_frames");
+}
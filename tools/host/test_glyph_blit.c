@@ -0,0 +1,166 @@
+// glyph_blit, the --blit-glyphs build's drawing of the time rows, pixel for
+// pixel against the host's compositing of a BitmapLayer: random glyph cells in
+// both compositing modes, put across the word and screen edges and, on chalk,
+// across the ends of the round display's rows. every byte of the frame buffer
+// is compared, the ones the glyph leaves alone included.
+
+#include "face.h"
+#include "test.h"
+
+#define TEST_TIME 1792804140   // 2026-10-24 01:09, local
+#define TEST_RANDOM_PLACES 400
+
+#define SOURCE_WIDTH 100       // three words and a bit of a 1-bit row
+#define SOURCE_HEIGHT 48
+
+static uint8_t s_noise[64 * 1024];
+static uint8_t s_expected[64 * 1024];
+
+static size_t get_compared_size(GBitmap* frame_buffer)
+{
+  GRect bounds = gbitmap_get_bounds(frame_buffer);
+#ifdef PBL_ROUND
+  // rows are packed, each as long as the circle is wide there
+  GBitmapDataRowInfo last_row = gbitmap_get_data_row_info(frame_buffer, bounds.size.h - 1);
+  return last_row.data + last_row.max_x + 1 - gbitmap_get_data(frame_buffer);
+#else
+  return gbitmap_get_bytes_per_row(frame_buffer) * bounds.size.h;
+#endif
+}
+
+// the display shows the low six bits of a color pixel, the alpha bits are
+// whatever the drawing left there
+static bool is_same_pixel(uint8_t actual, uint8_t expected)
+{
+#ifdef PBL_COLOR
+  return (actual & 0x3F) == (expected & 0x3F);
+#else
+  return actual == expected;
+#endif
+}
+
+static GBitmap* create_source(GColor* palette)
+{
+#ifdef PBL_COLOR
+  GBitmap* src = gbitmap_create_blank_with_palette(GSize(SOURCE_WIDTH, SOURCE_HEIGHT), GBitmapFormat1BitPalette, palette, false);
+#else
+  GBitmap* src = gbitmap_create_blank(GSize(SOURCE_WIDTH, SOURCE_HEIGHT), GBitmapFormat1Bit);
+#endif
+  uint8_t* data = gbitmap_get_data(src);
+  for (int i = 0; i < gbitmap_get_bytes_per_row(src) * SOURCE_HEIGHT; ++i) data[i] = rand();
+  return src;
+}
+
+// the cell at src_origin drawn at dest both ways over the same noise
+static void check_place(GBitmap* src, GPoint src_origin, GRect dest, GCompOp comp_op)
+{
+  GBitmap* frame_buffer = host_get_frame_buffer();
+  uint8_t* data = gbitmap_get_data(frame_buffer);
+  size_t size = get_compared_size(frame_buffer);
+  for (size_t i = 0; i < size; ++i) s_noise[i] = rand();
+
+  memcpy(data, s_noise, size);
+  GContext* ctx = host_get_layer_context(window_get_root_layer(window));
+  graphics_context_set_compositing_mode(ctx, comp_op);
+  GBitmap* cell = gbitmap_create_as_sub_bitmap(src, GRect(src_origin.x, src_origin.y, dest.size.w, dest.size.h));
+  graphics_draw_bitmap_in_rect(ctx, cell, dest);
+  gbitmap_destroy(cell);
+  memcpy(s_expected, data, size);
+
+  memcpy(data, s_noise, size);
+  if (!CHECK(glyph_blit(frame_buffer, src, src_origin, dest, comp_op))) return;
+
+  size_t differ = 0, first = 0;
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (!is_same_pixel(data[i], s_expected[i]) && differ++ == 0) first = i;
+  }
+  if (!CHECK_EQ(differ, 0))
+  {
+    fprintf(stderr, "  %s, cell (%d, %d) at (%d, %d) %dx%d, first at byte %d\n", (comp_op == GCompOpSet) ? "set" : "assign",
+            src_origin.x, src_origin.y, dest.origin.x, dest.origin.y, dest.size.w, dest.size.h, (int)first);
+  }
+}
+
+static void check_places(GBitmap* src, GCompOp comp_op)
+{
+  GRect screen = gbitmap_get_bounds(host_get_frame_buffer());
+  int right = screen.size.w, bottom = screen.size.h;
+
+  // the edges of the screen and of the words of a 1-bit row
+  static const GRect edges[] = {
+    { { 0, 0 }, { 32, 20 } }, { { 1, 1 }, { 31, 20 } }, { { 31, 5 }, { 2, 10 } }, { { 30, 5 }, { 40, 10 } },
+    { { 3, 7 }, { 1, 1 } }, { { 5, 9 }, { 90, 30 } }, { { -10, 10 }, { 30, 20 } }, { { -31, -5 }, { 40, 20 } },
+    { { -40, 0 }, { 30, 20 } }, { { 10, -30 }, { 30, 20 } },
+  };
+  for (unsigned int i = 0; i < ARRAY_LENGTH(edges); ++i) check_place(src, GPoint(i, i % 3), edges[i], comp_op);
+
+  check_place(src, GPoint(2, 0), GRect(right - 20, 30, 40, 20), comp_op);
+  check_place(src, GPoint(0, 4), GRect(right - 1, 30, 10, 20), comp_op);
+  check_place(src, GPoint(9, 1), GRect(right, 30, 10, 20), comp_op);
+  check_place(src, GPoint(0, 0), GRect(40, bottom - 10, 30, 20), comp_op);
+  check_place(src, GPoint(0, 0), GRect(right - 15, bottom - 15, 30, 30), comp_op);
+  check_place(src, GPoint(0, 0), GRect(right - SOURCE_WIDTH + 4, -4, SOURCE_WIDTH, 40), comp_op);
+
+  // the corners, cut off by the round display's rows
+  check_place(src, GPoint(0, 0), GRect(0, 0, 40, 40), comp_op);
+  check_place(src, GPoint(3, 5), GRect(right - 40, bottom - 40, 40, 40), comp_op);
+  check_place(src, GPoint(0, 0), GRect(-8, bottom / 2 - 20, 30, 40), comp_op);
+  check_place(src, GPoint(0, 0), GRect(right - 22, bottom / 2 - 20, 30, 40), comp_op);
+
+  for (int i = 0; i < TEST_RANDOM_PLACES; ++i)
+  {
+    GRect dest = GRect(rand() % (right + 60) - 30, rand() % (bottom + 60) - 30, 1 + rand() % 60, 1 + rand() % 40);
+    GPoint src_origin = GPoint(rand() % (SOURCE_WIDTH - dest.size.w + 1), rand() % (SOURCE_HEIGHT - dest.size.h + 1));
+    check_place(src, src_origin, dest, comp_op);
+  }
+}
+
+static void test_blit(void)
+{
+  start_face(TEST_TIME);
+  srand(44);
+
+#ifdef PBL_COLOR
+  // a font atlas's palettes: the colors of a row in both modes, and the
+  // transparent background of the rows drawn with GCompOpSet
+  GColor palettes[][2] = {
+    { GColorBlack, GColorWhite },
+    { GColorFromHEX(0x0055AA), GColorFromHEX(0xFFAA00) },
+    { GColorClear, GColorFromHEX(0xFFFF00) },
+    { GColorRed, GColorClear },
+  };
+  for (unsigned int i = 0; i < ARRAY_LENGTH(palettes); ++i)
+  {
+    GBitmap* src = create_source(palettes[i]);
+    check_places(src, GCompOpAssign);
+    check_places(src, GCompOpSet);
+    gbitmap_destroy(src);
+  }
+#else
+  GBitmap* src = create_source(NULL);
+  check_places(src, GCompOpAssign);
+  check_places(src, GCompOpSet);
+  gbitmap_destroy(src);
+#endif
+
+  deinit();
+}
+
+// formats it does not draw are left to the layers
+static void test_unsupported(void)
+{
+  start_face(TEST_TIME);
+  GBitmap* src = gbitmap_create_blank(GSize(16, 16), GBitmapFormat2BitPalette);
+  CHECK(!glyph_blit(host_get_frame_buffer(), src, GPoint(0, 0), GRect(10, 10, 16, 16), GCompOpAssign));
+  CHECK(!glyph_blit(NULL, src, GPoint(0, 0), GRect(10, 10, 16, 16), GCompOpAssign));
+  gbitmap_destroy(src);
+  deinit();
+}
+
+int main(void)
+{
+  test_launch(test_blit);
+  test_launch(test_unsupported);
+  return test_finish("test_glyph_blit");
+}
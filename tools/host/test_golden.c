@@ -0,0 +1,144 @@
+// frames of the face against the golden ones in golden/, pixel for pixel: as
+// launched, with every row shown in colors of its own, and with the formal
+// numerals, prefixes and the date below. each platform has its own, diorite
+// and emery included, so a layout or an atlas change shows up as the pixels
+// it moved. the --derive-small-fonts build's are in golden/derived, see the
+// Makefile.
+//
+//   make -C tools/host test
+//   make -C tools/host golden      rewrites golden/ after a change meant to move pixels
+//
+// a frame that differs is written next to the test, build/<platform>/, to
+// compare by eye with the golden one.
+
+#include <libgen.h>
+#include "face.h"
+#include "test.h"
+
+#define TEST_TIME     1792804140   // 2026-10-24 01:09, local
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR    "golden"
+#endif
+#define FRAME_SIZE    (PBL_DISPLAY_WIDTH * PBL_DISPLAY_HEIGHT * 3)
+
+static bool s_is_update = false;
+static const char* s_out_dir = ".";
+
+static void send_config(void (*write)(DictionaryIterator* iterator))
+{
+  uint8_t buffer[256];
+  DictionaryIterator iterator;
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  write(&iterator);
+  host_deliver_message(buffer, dict_write_end(&iterator));
+
+  // past the transition the config starts, the stars gone
+  host_run_for(3000);
+}
+
+// black and white watches take any color but black as white. the time row is
+// recolored before the date and month rows first load their fonts
+static void write_rows(DictionaryIterator* iterator)
+{
+  dict_write_cstring(iterator, MSG_CONFIG_BG_COLOR, PBL_IF_COLOR_ELSE("0x0055AA", "0x000000"));
+  dict_write_cstring(iterator, MSG_CONFIG_TIME_COLOR, "0xFFFF55");
+  dict_write_cstring(iterator, MSG_CONFIG_DATE_COLOR, "0xFFAA00");
+  dict_write_cstring(iterator, MSG_CONFIG_MONTH_COLOR, "0x55FF55");
+  dict_write_uint8(iterator, MSG_CONFIG_IS_ENABLE_DATE, 1);
+  dict_write_uint8(iterator, MSG_CONFIG_IS_ENABLE_MONTH, 1);
+  dict_write_uint8(iterator, MSG_CONFIG_IS_ENABLE_YEAR, 1);
+  dict_write_uint8(iterator, MSG_CONFIG_IS_USE_LUNAR, 1);
+}
+
+static void write_formal(DictionaryIterator* iterator)
+{
+  dict_write_uint8(iterator, MSG_CONFIG_IS_USE_FORMAL, 1);
+  dict_write_uint8(iterator, MSG_CONFIG_IS_USE_PREFIX, 1);
+  dict_write_uint8(iterator, MSG_CONFIG_IS_USE_AMPM, 1);
+  dict_write_uint8(iterator, MSG_CONFIG_DATE_POSITION_TYPE, DATE_POSITION_BOTTOM);
+}
+
+static bool write_ppm(const char* path, const uint8_t* rgb)
+{
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) return false;
+  fprintf(file, "P6\n%d %d\n255\n", PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT);
+  bool is_written = fwrite(rgb, 1, FRAME_SIZE, file) == FRAME_SIZE;
+  return (fclose(file) == 0) && is_written;
+}
+
+static bool read_ppm(const char* path, uint8_t* rgb)
+{
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) return false;
+  int width = 0, height = 0, max = 0;
+  bool is_read = fscanf(file, "P6 %d %d %d", &width, &height, &max) == 3 && fgetc(file) != EOF &&
+    width == PBL_DISPLAY_WIDTH && height == PBL_DISPLAY_HEIGHT && max == 255 &&
+    fread(rgb, 1, FRAME_SIZE, file) == FRAME_SIZE;
+  fclose(file);
+  return is_read;
+}
+
+static void check_frame(const char* scene)
+{
+  static uint8_t rgb[FRAME_SIZE], golden[FRAME_SIZE];
+  char path[256];
+
+  host_render();
+  host_get_frame_rgb(rgb);
+
+  snprintf(path, sizeof(path), GOLDEN_DIR "/%s_%s.ppm", get_platform_name(), scene);
+  if (s_is_update)
+  {
+    if (!CHECK(write_ppm(path, rgb))) fprintf(stderr, "  can not write %s\n", path);
+    return;
+  }
+  if (!CHECK(read_ppm(path, golden)))
+  {
+    fprintf(stderr, "  no golden frame %s, make golden writes it\n", path);
+    return;
+  }
+
+  // the pixels that differ and the box around them
+  int num = 0, min_x = PBL_DISPLAY_WIDTH, min_y = PBL_DISPLAY_HEIGHT, max_x = -1, max_y = -1;
+  for (int y = 0; y < PBL_DISPLAY_HEIGHT; ++y)
+  {
+    for (int x = 0; x < PBL_DISPLAY_WIDTH; ++x)
+    {
+      int offset = (y * PBL_DISPLAY_WIDTH + x) * 3;
+      if (memcmp(rgb + offset, golden + offset, 3) == 0) continue;
+      ++num;
+      if (x < min_x) min_x = x;
+      if (x > max_x) max_x = x;
+      if (y < min_y) min_y = y;
+      if (y > max_y) max_y = y;
+    }
+  }
+  if (!CHECK_EQ(num, 0))
+  {
+    char actual[512];
+    snprintf(actual, sizeof(actual), "%s/%s.ppm", s_out_dir, scene);
+    write_ppm(actual, rgb);
+    fprintf(stderr, "  %s: %d pixels differ in (%d, %d)-(%d, %d), the frame is in %s\n",
+            path, num, min_x, min_y, max_x, max_y, actual);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  s_is_update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  s_out_dir = dirname(strdup(argv[0]));
+
+  start_face(TEST_TIME);
+  host_run_for(3000);
+  check_frame("launch");
+
+  send_config(write_rows);
+  check_frame("rows");
+
+  send_config(write_formal);
+  check_frame("formal");
+
+  deinit();
+  return test_finish("test_golden");
+}
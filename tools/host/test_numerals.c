@@ -0,0 +1,125 @@
+// calculate_digits, the table encoder of the numerals: against the branches
+// it replaced for 0-99, the values hours, minutes and dates take, and against
+// a reference writing of japanese numerals for 0-9999, the year row's range.
+
+#include "face.h"
+#include "test.h"
+
+// calculate_digits as it was before the table, for 0-99
+static int calculate_digits_branches(int value, int* result_digits)
+{
+  int digit_num = 0;
+
+  int in_ones = value % 10;
+  int in_tens = value / 10;
+
+  if (in_tens > 1 && in_ones > 0)
+  {
+    digit_num = 3;
+    result_digits[0] = in_tens;
+    result_digits[1] = 10;
+    result_digits[2] = in_ones;
+  }
+  else if (value > 10)
+  {
+    digit_num = 2;
+    result_digits[0] = in_tens >= 2 ? in_tens : 10;
+    result_digits[1] = in_tens >= 2 ? 10 : in_ones;
+  }
+  else
+  {
+    digit_num = 1;
+    result_digits[0] = in_tens > 0 ? 10 : in_ones;
+  }
+
+  return digit_num;
+}
+
+static const char* s_numeral_glyphs[] = { "〇", "一", "二", "三", "四", "五", "六", "七", "八", "九", "十", "百", "千" };
+
+// the numeral as text: the digit of each place followed by its place glyph,
+// zero places left out, and one left out before a place glyph
+static void write_reference(int value, char* text)
+{
+  static const int places[] = { 1000, 100, 10, 1 };
+  static const char* place_glyphs[] = { "千", "百", "十", "" };
+
+  text[0] = '\0';
+  if (value == 0)
+  {
+    strcat(text, "〇");
+    return;
+  }
+  for (int i = 0; i < 4; ++i)
+  {
+    int digit = value / places[i] % 10;
+    if (digit == 0) continue;
+    if (digit > 1 || places[i] == 1) strcat(text, s_numeral_glyphs[digit]);
+    strcat(text, place_glyphs[i]);
+  }
+}
+
+static void write_digits(const int* digits, int num, char* text)
+{
+  text[0] = '\0';
+  for (int i = 0; i < num; ++i)
+  {
+    if (digits[i] >= 0 && digits[i] < (int)ARRAY_LENGTH(s_numeral_glyphs)) strcat(text, s_numeral_glyphs[digits[i]]);
+    else strcat(text, "?");
+  }
+}
+
+static void test_branches(void)
+{
+  for (int value = 0; value < 100; ++value)
+  {
+    int digits[NUMERAL_MAX_LENGTH], old_digits[NUMERAL_MAX_LENGTH];
+    int num = calculate_digits(value, digits);
+    int old_num = calculate_digits_branches(value, old_digits);
+
+    bool is_same = CHECK_EQ(num, old_num);
+    for (int i = 0; is_same && i < num; ++i) is_same = CHECK_EQ(digits[i], old_digits[i]);
+    if (!is_same) fprintf(stderr, "  at %d\n", value);
+  }
+}
+
+static void test_reference(void)
+{
+  for (int value = 0; value <= 9999; ++value)
+  {
+    int digits[NUMERAL_MAX_LENGTH];
+    int num = calculate_digits(value, digits);
+    CHECK(num >= 1 && num <= NUMERAL_MAX_LENGTH);
+
+    char text[64], expected[64];
+    write_digits(digits, num, text);
+    write_reference(value, expected);
+    if (!CHECK(strcmp(text, expected) == 0)) fprintf(stderr, "  %d is %s, expected %s\n", value, text, expected);
+  }
+}
+
+// a few written out by hand, in case the reference shares a mistake
+static void test_known(void)
+{
+  static const struct { int value; const char* text; } known[] = {
+    { 0, "〇" }, { 1, "一" }, { 10, "十" }, { 11, "十一" }, { 20, "二十" }, { 59, "五十九" },
+    { 100, "百" }, { 101, "百一" }, { 110, "百十" }, { 1000, "千" }, { 1900, "千九百" },
+    { 2026, "二千二十六" }, { 9999, "九千九百九十九" },
+  };
+
+  for (unsigned int i = 0; i < ARRAY_LENGTH(known); ++i)
+  {
+    int digits[NUMERAL_MAX_LENGTH];
+    char text[64];
+    write_digits(digits, calculate_digits(known[i].value, digits), text);
+    if (!CHECK(strcmp(text, known[i].text) == 0)) fprintf(stderr, "  %d is %s, expected %s\n", known[i].value, text, known[i].text);
+  }
+}
+
+int main(void)
+{
+  test_branches();
+  test_reference();
+  test_known();
+  return test_finish("test_numerals");
+}
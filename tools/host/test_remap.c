@@ -0,0 +1,121 @@
+// remap_gbitmap_colors against a pixel at a time remap: every palette format,
+// and the word at a time path of 8-bit bitmaps at each alignment and width,
+// inside sub-bitmaps whose surroundings must stay as they were.
+
+#include <pebble.h>
+#include "host.h"
+#include "test.h"
+#include "gbitmap_color_palette_manipulator.h"
+
+#ifdef PBL_COLOR
+
+#define TEST_WIDTH  72
+#define TEST_HEIGHT 5
+
+// a table that moves every color, swapping white and black as set_color does
+static void init_test_lut(GColor* lut)
+{
+  gcolor_lut_init_identity(lut);
+  for (int i = 0; i < GCOLOR_LUT_SIZE; ++i) lut[i].argb = 0xC0 | ((i * 37 + 11) & 0x3F);
+  gcolor_lut_set(lut, GColorWhite, GColorBlack);
+  gcolor_lut_set(lut, GColorBlack, GColorWhite);
+}
+
+static uint8_t remap_reference(const GColor* lut, uint8_t argb)
+{
+  return (argb & 0xC0) | (lut[argb & 0x3F].argb & 0x3F);
+}
+
+static void test_identity(void)
+{
+  GColor lut[GCOLOR_LUT_SIZE];
+  gcolor_lut_init_identity(lut);
+  for (int i = 0; i < 256; ++i) CHECK_EQ(remap_reference(lut, i), i);
+}
+
+static void test_palette(GBitmapFormat format, int palette_size)
+{
+  GColor lut[GCOLOR_LUT_SIZE];
+  init_test_lut(lut);
+
+  GBitmap* bitmap = gbitmap_create_blank(GSize(TEST_WIDTH, TEST_HEIGHT), format);
+  GColor* palette = gbitmap_get_palette(bitmap);
+  uint8_t before[16];
+  for (int i = 0; i < palette_size; ++i)
+  {
+    // alpha of every kind, the remap must keep it
+    palette[i].argb = (uint8_t)(i * 71 + 5);
+    before[i] = palette[i].argb;
+  }
+  uint8_t* data = gbitmap_get_data(bitmap);
+  for (int i = 0; i < gbitmap_get_bytes_per_row(bitmap) * TEST_HEIGHT; ++i) data[i] = (uint8_t)(i * 13);
+
+  remap_gbitmap_colors(lut, bitmap, NULL);
+
+  CHECK_EQ(get_num_palette_colors(bitmap), palette_size);
+  for (int i = 0; i < palette_size; ++i) CHECK_EQ(palette[i].argb, remap_reference(lut, before[i]));
+  // the pixels only index the palette
+  for (int i = 0; i < gbitmap_get_bytes_per_row(bitmap) * TEST_HEIGHT; ++i) CHECK_EQ(data[i], (uint8_t)(i * 13));
+
+  gbitmap_destroy(bitmap);
+}
+
+// a sub-bitmap at x, width w: the pixels in it remapped, the rest untouched
+static void test_8bit_span(int x, int w)
+{
+  GColor lut[GCOLOR_LUT_SIZE];
+  init_test_lut(lut);
+
+  GBitmap* base = gbitmap_create_blank(GSize(TEST_WIDTH, TEST_HEIGHT), GBitmapFormat8Bit);
+  uint8_t* data = gbitmap_get_data(base);
+  int row_size = gbitmap_get_bytes_per_row(base);
+  uint8_t before[TEST_WIDTH * TEST_HEIGHT];
+  for (int i = 0; i < row_size * TEST_HEIGHT; ++i) data[i] = before[i] = (uint8_t)(i * 29 + x);
+
+  GBitmap* sub = gbitmap_create_as_sub_bitmap(base, GRect(x, 1, w, TEST_HEIGHT - 2));
+  remap_gbitmap_colors(lut, sub, NULL);
+
+  for (int y = 0; y < TEST_HEIGHT; ++y)
+  {
+    for (int i = 0; i < TEST_WIDTH; ++i)
+    {
+      bool is_inside = y >= 1 && y < TEST_HEIGHT - 1 && i >= x && i < x + w;
+      uint8_t expected = is_inside ? remap_reference(lut, before[y * row_size + i]) : before[y * row_size + i];
+      if (!CHECK_EQ(data[y * row_size + i], expected))
+        fprintf(stderr, "  at x %d y %d of a span at %d, %d wide\n", i, y, x, w);
+    }
+  }
+
+  gbitmap_destroy(sub);
+  gbitmap_destroy(base);
+}
+
+static void test_8bit(void)
+{
+  // every start against the word, spans shorter and longer than one
+  for (int x = 0; x < 8; ++x)
+  {
+    for (int w = 0; x + w <= TEST_WIDTH && w <= 40; ++w) test_8bit_span(x, w);
+  }
+  test_8bit_span(0, TEST_WIDTH);
+}
+
+int main(void)
+{
+  test_identity();
+  test_palette(GBitmapFormat1BitPalette, 2);
+  test_palette(GBitmapFormat2BitPalette, 4);
+  test_palette(GBitmapFormat4BitPalette, 16);
+  test_8bit();
+  return test_finish("test_remap");
+}
+
+#else
+
+int main(void)
+{
+  printf("test_remap: no color bitmaps on this platform\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,139 @@
+// the daily counters: off unless the config turns them on, and then written
+// as a day starts and at most hourly after, every write counted in them. the
+// finished day goes to the companion once. each launch runs in a process of
+// its own.
+
+#include "face.h"
+#include "test.h"
+
+#define TEST_MIDNIGHT 1792886400   // 2026-10-25 00:00, local
+#define TEST_DATE 20261024         // the day before it
+
+static void save_test_config(bool is_enable_telemetry)
+{
+  struct ConfigData saved = { .bg_color = GColorBlack, .time_color = GColorWhite,
+                              .is_enable_date = true, .is_enable_telemetry = is_enable_telemetry };
+  persist_write_data(PERSIST_CONFIG, &saved, sizeof(saved));
+}
+
+// the telemetry message last sent, or 0
+static int32_t get_sent_date(int* persist_writes)
+{
+  uint16_t size;
+  const uint8_t* buffer = host_get_last_outbox(&size);
+  if (buffer == NULL) return 0;
+
+  DictionaryIterator iterator;
+  dict_read_begin_from_buffer(&iterator, buffer, size);
+  Tuple* date = dict_find(&iterator, MSG_TELEMETRY_DATE);
+  Tuple* writes = dict_find(&iterator, MSG_TELEMETRY_PERSIST_WRITES);
+  if (date == NULL || writes == NULL) return 0;
+  *persist_writes = writes->value->uint16;
+  return date->value->int32;
+}
+
+// nothing is kept or sent, and what an earlier version kept goes
+static void test_off_by_default(void)
+{
+  struct TelemetryData old = { .date = TEST_DATE, .transitions = 100 };
+  persist_write_data(PERSIST_TELEMETRY, &old, sizeof(old));
+  save_test_config(false);
+  uint32_t writes = host_get_persist_writes();
+
+  start_face(TEST_MIDNIGHT - 10 * 60);
+  CHECK(!persist_exists(PERSIST_TELEMETRY));
+  CHECK_EQ(host_get_persist_writes(), writes + 1);
+
+  host_run_for(20 * 60 * 1000);
+  deinit();
+  CHECK(!persist_exists(PERSIST_TELEMETRY));
+  CHECK(!persist_exists(PERSIST_TELEMETRY_UNSENT));
+  CHECK_EQ(host_get_outbox_count(), 0);
+  CHECK_EQ(host_get_persist_writes(), writes + 1);
+}
+
+// written on the launch that starts the day, then on the day change, the
+// finished day sent holding its own writes
+static void test_day_change(void)
+{
+  save_test_config(true);
+  uint32_t writes = host_get_persist_writes();
+
+  start_face(TEST_MIDNIGHT - 10 * 60);
+  CHECK(persist_exists(PERSIST_TELEMETRY));
+  CHECK_EQ(host_get_persist_writes(), writes + 1);
+  CHECK_EQ(telemetry.persist_writes, 1);
+
+  host_run_for(20 * 60 * 1000);
+
+  // the finished day and the new one written, the finished one deleted once sent
+  int sent_writes = -1;
+  CHECK_EQ(get_sent_date(&sent_writes), TEST_DATE);
+  CHECK_EQ(sent_writes, 2);
+  CHECK_EQ(host_get_outbox_count(), 1);
+  CHECK(!persist_exists(PERSIST_TELEMETRY_UNSENT));
+  CHECK_EQ(host_get_persist_writes(), writes + 4);
+  CHECK_EQ(telemetry.persist_writes, 2);
+  CHECK_EQ(telemetry.date, TEST_DATE + 1);
+
+  // written ten minutes before, the unload writes nothing
+  deinit();
+  CHECK_EQ(host_get_persist_writes(), writes + 4);
+}
+
+// an hour after the last write, on a minute tick or as the face unloads
+static void test_throttle(void)
+{
+  save_test_config(true);
+  start_face(TEST_MIDNIGHT + 9 * 60 * 60 + 30);
+  uint32_t writes = host_get_persist_writes();
+
+  // the 10:00 tick comes 30 s short of the hour
+  host_run_for(60 * 60 * 1000 + 10 * 1000);
+  CHECK_EQ(host_get_persist_writes(), writes);
+  deinit();
+  CHECK_EQ(host_get_persist_writes(), writes + 1);
+
+  // the hour counts from the write before the launch
+  start_face(TEST_MIDNIGHT + 10 * 60 * 60 + 30 * 60);
+  CHECK_EQ(host_get_persist_writes(), writes + 1);
+  host_run_for(2 * 60 * 60 * 1000);
+  CHECK_EQ(host_get_persist_writes(), writes + 3);
+  CHECK_EQ(telemetry.persist_writes, 4);
+  deinit();
+  CHECK_EQ(host_get_persist_writes(), writes + 3);
+}
+
+// turned off from the config page, what was kept is deleted
+static void test_turn_off(void)
+{
+  save_test_config(true);
+  start_face(TEST_MIDNIGHT - 10 * 60);
+  CHECK(persist_exists(PERSIST_TELEMETRY));
+
+  uint8_t buffer[64];
+  DictionaryIterator iterator;
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  dict_write_uint8(&iterator, MSG_CONFIG_IS_ENABLE_TELEMETRY, 0);
+  host_deliver_message(buffer, dict_write_end(&iterator));
+  CHECK(!persist_exists(PERSIST_TELEMETRY));
+  CHECK(!config_data.is_enable_telemetry);
+
+  host_run_for(20 * 60 * 1000);
+  CHECK_EQ(host_get_outbox_count(), 0);
+  CHECK(!persist_exists(PERSIST_TELEMETRY));
+  deinit();
+
+  // and it stays off
+  init_config();
+  CHECK(!config_data.is_enable_telemetry);
+}
+
+int main(void)
+{
+  test_launch(test_off_by_default);
+  test_launch(test_day_change);
+  test_launch(test_throttle);
+  test_launch(test_turn_off);
+  return test_finish("test_telemetry");
+}
@@ -0,0 +1,121 @@
+// the transition controller merges what overlaps: a config message near a
+// minute boundary joins the minute's transition while its changes can still
+// show in it, and otherwise leaves a single transition pending for after it.
+// at no point do two transitions run over the star pool at once.
+
+#include "face.h"
+#include "test.h"
+
+#define TEST_TIME 1792804140   // 2026-10-24 01:09, local
+
+static uint32_t s_max_running;
+
+// the simulated clock run in steps, the transitions running counted at each
+static void run_watching(int ms)
+{
+  for (int t = 0; t < ms; t += 10)
+  {
+    host_run_for(10);
+    if (host_get_scheduled_animations() > s_max_running) s_max_running = host_get_scheduled_animations();
+  }
+}
+
+static int get_ms_to_boundary(void)
+{
+  time_t sec;
+  uint16_t ms;
+  time_ms(&sec, &ms);
+  return (int)(SECONDS_PER_MINUTE - sec % SECONDS_PER_MINUTE) * 1000 - ms;
+}
+
+static void send_time_color(const char* color)
+{
+  uint8_t buffer[64];
+  DictionaryIterator iterator;
+  dict_write_begin(&iterator, buffer, sizeof(buffer));
+  dict_write_cstring(&iterator, MSG_CONFIG_TIME_COLOR, color);
+  host_deliver_message(buffer, dict_write_end(&iterator));
+}
+
+// a config message at offset_ms from the next minute boundary, the counters
+// taken from well before it to well after
+static void send_near_boundary(int offset_ms, const char* color)
+{
+  // clear of the last minute's transition
+  host_run_for(get_ms_to_boundary() + SECONDS_PER_MINUTE * 1000 / 2);
+  run_watching(get_ms_to_boundary() - 3000);
+  profile_reset();
+  s_max_running = 0;
+  run_watching(3000 + offset_ms);
+  send_time_color(color);
+  run_watching(5000);
+}
+
+// the message comes while the minute's transition has yet to show its changes
+static void test_join(void)
+{
+  int min = current_min;
+  send_near_boundary(-(int)(STAR_TRANSITION_PERIOD * TRANSITION_REFRESH_RATIO * 1000) / 2, "0xFF0000");
+
+  CHECK_EQ(profile_get(PROFILE_TRANSITION_REQUESTS), 2);
+  CHECK_EQ(profile_get(PROFILE_TRANSITIONS), 1);
+  CHECK_EQ(s_max_running, 1);
+  CHECK(current_min != min);
+  CHECK(gcolor_equal(config_data.time_color, PBL_IF_COLOR_ELSE(GColorRed, GColorWhite)));
+  CHECK_EQ(transition_state, TRANSITION_IDLE);
+}
+
+// the message comes once the minute's transition has shown its changes
+static void test_pending(void)
+{
+  int min = current_min;
+  send_near_boundary(200, "0x00FF00");
+
+  CHECK_EQ(profile_get(PROFILE_TRANSITION_REQUESTS), 2);
+  CHECK_EQ(profile_get(PROFILE_TRANSITIONS), 2);
+  CHECK_EQ(s_max_running, 1);
+  CHECK(current_min != min);
+  CHECK(gcolor_equal(config_data.time_color, PBL_IF_COLOR_ELSE(GColorGreen, GColorWhite)));
+  CHECK_EQ(transition_state, TRANSITION_IDLE);
+}
+
+// a minute on its own asks once, ahead of the boundary with the preroll, and
+// its tick has nothing left to ask for
+static void test_minute(void)
+{
+  host_run_for(get_ms_to_boundary() + SECONDS_PER_MINUTE * 1000 / 2);
+  profile_reset();
+  s_max_running = 0;
+  run_watching(SECONDS_PER_MINUTE * 1000);
+
+  CHECK_EQ(profile_get(PROFILE_TRANSITION_REQUESTS), 1);
+  CHECK_EQ(profile_get(PROFILE_TRANSITIONS), 1);
+  CHECK_EQ(s_max_running, 1);
+}
+
+// mid minute, a message has a transition of its own
+static void test_idle(void)
+{
+  host_run_for(get_ms_to_boundary() + SECONDS_PER_MINUTE * 1000 / 2);
+  profile_reset();
+  s_max_running = 0;
+  send_time_color("0xFFFFFF");
+  run_watching(5000);
+
+  CHECK_EQ(profile_get(PROFILE_TRANSITION_REQUESTS), 1);
+  CHECK_EQ(profile_get(PROFILE_TRANSITIONS), 1);
+  CHECK_EQ(s_max_running, 1);
+}
+
+int main(void)
+{
+  start_face(TEST_TIME);
+
+  test_join();
+  test_pending();
+  test_minute();
+  test_idle();
+
+  deinit();
+  return test_finish("test_transitions");
+}
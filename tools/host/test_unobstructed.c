@@ -0,0 +1,133 @@
+// the relayout for a timeline peek: rows that no longer fit are hidden as the
+// peek starts, the glyphs settle where a layout of the smaller screen puts
+// them, a minute changing during the peek retargets it, and the rows come
+// back with the full screen.
+
+#include "face.h"
+#include "test.h"
+
+#if PBL_API_EXISTS(unobstructed_area_service_subscribe)
+
+#define TEST_TIME       1792804140   // 2026-10-24 01:09, local
+#define PEEK_HEIGHT     51           // the timeline quick view of the rect watches
+#define PEEK_MS         250
+
+// glyph layers as a layout of the given height puts them
+static void check_rows(int height, const char* when)
+{
+  struct TimeLayout expected;
+  calculate_layout(&expected, window_width, height);
+
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    struct RowLayout* row = &expected.rows[i];
+    for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+    {
+      Layer* layer = bitmap_layer_get_layer(row_layers[i][j]);
+      bool is_ok = CHECK_EQ(layer_get_hidden(layer), j >= row->atlas.num);
+      if (j < row->atlas.num)
+      {
+        GRect frame = layer_get_frame(layer);
+        is_ok &= CHECK(grect_equal(&frame, &GRect(row->left + row->size * j, row->top, row->size, row->size)));
+        is_ok &= CHECK(frame.origin.y + frame.size.h <= height);
+      }
+      if (!is_ok) fprintf(stderr, "  row %d glyph %d, %s\n", i, j, when);
+    }
+  }
+}
+
+static int count_glyphs(int height)
+{
+  struct TimeLayout layout;
+  calculate_layout(&layout, window_width, height);
+
+  int num = 0;
+  for (int i = 0; i < ROW_NUM; ++i) num += layout.rows[i].atlas.num;
+  return num;
+}
+
+// the rows a layout of the given height has no room for are hidden
+static void check_rows_gone(int height, const char* when)
+{
+  struct TimeLayout to;
+  calculate_layout(&to, window_width, height);
+  for (int i = 0; i < ROW_NUM; ++i)
+  {
+    if (to.rows[i].atlas.num > 0) continue;
+    for (int j = 0; j < CHAR_MAX_LENGTH && row_layers[i][j]; ++j)
+    {
+      if (!CHECK(layer_get_hidden(bitmap_layer_get_layer(row_layers[i][j])))) fprintf(stderr, "  row %d glyph %d, %s\n", i, j, when);
+    }
+  }
+}
+
+static void test_peek(void)
+{
+  check_rows(PBL_DISPLAY_HEIGHT, "before the peek");
+
+  // the year goes first, the rows of the peek are fewer
+  CHECK(count_glyphs(PBL_DISPLAY_HEIGHT - PEEK_HEIGHT) < count_glyphs(PBL_DISPLAY_HEIGHT));
+
+  host_start_unobstructed_change(PEEK_HEIGHT, PEEK_MS);
+  host_run_for(PEEK_MS / 2);
+
+  // halfway, the rows that go are already hidden
+  check_rows_gone(PBL_DISPLAY_HEIGHT - PEEK_HEIGHT, "halfway through the peek");
+
+  host_run_for(PEEK_MS);
+  CHECK_EQ(window_height, PBL_DISPLAY_HEIGHT - PEEK_HEIGHT);
+  check_rows(PBL_DISPLAY_HEIGHT - PEEK_HEIGHT, "after the peek");
+
+  host_start_unobstructed_change(0, PEEK_MS);
+  host_run_for(2 * PEEK_MS);
+  CHECK_EQ(window_height, PBL_DISPLAY_HEIGHT);
+  check_rows(PBL_DISPLAY_HEIGHT, "after the peek went away");
+}
+
+// a peek still moving at the minute boundary keeps the rows it hid and ends
+// on the new minute
+static void test_peek_over_minute(void)
+{
+  int min = current_min;
+  time_t now = time(NULL);
+  host_run_for((SECONDS_PER_MINUTE - now % SECONDS_PER_MINUTE) * 1000 - 2000);
+
+  // the preroll shows the new minute a little ahead of the boundary
+  host_start_unobstructed_change(PEEK_HEIGHT, 4000);
+  host_run_for(2500);
+  CHECK(current_min != min);
+  check_rows_gone(PBL_DISPLAY_HEIGHT - PEEK_HEIGHT, "at a minute change during the peek");
+
+  host_run_for(4000);
+  check_rows(PBL_DISPLAY_HEIGHT - PEEK_HEIGHT, "after a peek over a minute change");
+
+  host_start_unobstructed_change(0, PEEK_MS);
+  host_run_for(2 * PEEK_MS);
+}
+
+int main(void)
+{
+  start_face(TEST_TIME);
+
+  config_data.is_enable_date = true;
+  config_data.is_enable_month = true;
+  config_data.is_enable_year = true;
+  refresh_time();
+  host_run_for(100);
+
+  test_peek();
+  test_peek_over_minute();
+
+  deinit();
+  return test_finish("test_unobstructed");
+}
+
+#else
+
+int main(void)
+{
+  printf("test_unobstructed: no unobstructed area on this platform\n");
+  return 0;
+}
+
+#endif
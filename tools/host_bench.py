@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+"""Run the host build's benchmarks (tools/host) and write a json report per
+platform, with the instructions per iteration perf stat counts where it can.
+
+  make -C tools/host bench
+  tools/host_bench.py --out tools/host/build/bench tools/host/build/*/bench
+  tools/profile_report.py --diff old/basalt.json new/basalt.json
+
+Reports have the layout of profile_report.py's, so the watch's and the host's
+numbers compare the same way. Instructions are counted in user space for a
+run of each benchmark less a run of none, which leaves the face's start up
+out. Without perf, or where it may not count, they are null.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+PERF_EVENT = 'instructions:u'
+
+
+def count_instructions(binary, name, iterations):
+    """User space instructions of `binary --run name`, None if perf can't count."""
+    try:
+        output = subprocess.run(['perf', 'stat', '-x,', '-e', PERF_EVENT, '--', binary,
+                                 '--run', name, '--iterations', str(iterations)],
+                                stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                                universal_newlines=True, check=True).stderr
+    except (OSError, subprocess.CalledProcessError):
+        return None
+    for line in output.splitlines():
+        fields = line.split(',')
+        if len(fields) > 2 and fields[2].startswith(PERF_EVENT.split(':')[0]):
+            return int(fields[0]) if fields[0].isdigit() else None
+    return None
+
+
+def run(binary, use_perf):
+    result = json.loads(subprocess.check_output([binary], universal_newlines=True))
+    report = {'bench': result['bench'], 'counters': result.get('counters', {})}
+    for name, bench in sorted(report['bench'].items()):
+        per_iteration = None
+        if use_perf:
+            total = count_instructions(binary, name, bench['iterations'])
+            baseline = count_instructions(binary, name, 0)
+            if total is not None and baseline is not None:
+                per_iteration = round((total - baseline) / float(bench['iterations']), 1)
+        bench['instructions_per_iteration'] = per_iteration
+    return result['platform'], report
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('binaries', nargs='+', help='bench binaries of the host build')
+    parser.add_argument('--out', default='bench', help='folder for the json reports')
+    parser.add_argument('--no-perf', action='store_true', help='skip the instruction counts')
+    args = parser.parse_args()
+
+    use_perf = not args.no_perf and count_instructions(args.binaries[0], 'hex_string_to_uint', 0) is not None
+    if not use_perf and not args.no_perf:
+        sys.stderr.write('perf stat can not count {} here, instructions are null\n'.format(PERF_EVENT))
+    if not os.path.isdir(args.out):
+        os.makedirs(args.out)
+
+    print('{:<10} {:<28} {:>12} {:>14}'.format('platform', 'bench', 'us/iter', 'instr/iter'))
+    for binary in args.binaries:
+        platform, report = run(binary, use_perf)
+        with open(os.path.join(args.out, platform + '.json'), 'w') as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write('\n')
+        for name, bench in sorted(report['bench'].items()):
+            print('{:<10} {:<28} {:>12} {:>14}'.format(platform, name, bench['us_per_iteration'],
+                                                      str(bench['instructions_per_iteration'])))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+"""Check src/lunar_calendar.c against lunargen.py, day by day.
+
+  tools/lunarcheck.py
+  tools/lunarcheck.py --cc clang --utc-offset 8
+
+Compiles lunar_calendar.c for linux against tools/host/pebble.h with a small
+driver, asks it the lunar month of every gregorian day the table covers, and
+compares each with the month lunargen.lunar_years() computes. That covers the
+packed table in src/lunar_calendar_table.h being current as well as the
+decoding of it. The days just outside the table must come back as out of it.
+"""
+
+import argparse
+import datetime
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import lunargen
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+# one "year month mday" per line in, "month is_leap" or "-" per line out
+DRIVER = r'''
+#include "lunar_calendar.h"
+
+int main(void)
+{
+  int year, month, mday;
+  while (scanf("%d %d %d", &year, &month, &mday) == 3)
+  {
+    int lunar_month = 0;
+    bool is_leap = false;
+    if (lunar_calendar_get_month(year, month, mday, &lunar_month, &is_leap)) printf("%d %d\n", lunar_month, is_leap);
+    else printf("-\n");
+  }
+  return 0;
+}
+'''
+
+
+def build(cc, folder):
+    with open(os.path.join(folder, 'driver.c'), 'w') as f:
+        f.write(DRIVER)
+    # pebble.h takes the resource ids of the build, the calendar needs none
+    open(os.path.join(folder, 'resource_ids.h'), 'w').close()
+
+    program = os.path.join(folder, 'lunarcheck')
+    subprocess.check_call([cc, '-std=gnu99', '-O1', '-Wall', '-Wno-unused-function',
+                           '-DPBL_PLATFORM_BASALT', '-DPBL_COLOR', '-DPBL_RECT',
+                           '-I', folder, '-I', os.path.join(ROOT, 'tools', 'host'), '-I', os.path.join(ROOT, 'src'),
+                           '-o', program, os.path.join(folder, 'driver.c'),
+                           os.path.join(ROOT, 'src', 'lunar_calendar.c')])
+    return program
+
+
+def expected_days(years):
+    """[(date, (month, is_leap) or None), ...] of every day of the table and one either side."""
+    days = [(years[0][0] - datetime.timedelta(days=1), None)]
+    date = years[0][0]
+    for start, months in years:
+        if start != date:
+            raise ValueError('lunar year {} starts on {}, the year before ends on {}'.format(start.year, start, date))
+        for month, is_leap, length in months:
+            for _ in range(length):
+                days.append((date, (month, is_leap)))
+                date += datetime.timedelta(days=1)
+    days.append((date, None))
+    return days
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--cc', default=os.environ.get('CC', 'cc'), help='host c compiler, default $CC or cc')
+    parser.add_argument('--utc-offset', type=int, default=9,
+                        help='hours, the offset the table was generated with, default 9 (japan)')
+    args = parser.parse_args()
+
+    days = expected_days(lunargen.lunar_years(args.utc_offset))
+
+    folder = tempfile.mkdtemp(prefix='lunarcheck-')
+    try:
+        program = build(args.cc, folder)
+        query = ''.join('{} {} {}\n'.format(date.year, date.month, date.day) for date, _ in days)
+        process = subprocess.Popen([program], stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                                   universal_newlines=True)
+        output, _ = process.communicate(query)
+    finally:
+        shutil.rmtree(folder)
+
+    answers = output.splitlines()
+    if process.returncode != 0 or len(answers) != len(days):
+        print('lunarcheck: the driver answered {} of {} days, status {}'.format(
+            len(answers), len(days), process.returncode))
+        return 1
+
+    failures = 0
+    for (date, expected), answer in zip(days, answers):
+        if answer == '-':
+            actual = None
+        else:
+            month, is_leap = answer.split()
+            actual = (int(month), is_leap == '1')
+        if actual != expected:
+            failures += 1
+            if failures <= 20:
+                print('{}: lunar_calendar.c {}, lunargen.py {}'.format(date, actual, expected))
+
+    print('lunarcheck: {} days from {} to {}, {} differ'.format(
+        len(days) - 2, days[1][0], days[-2][0], failures))
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,237 @@
+#!/usr/bin/env python
+"""Compute the lunisolar calendar and write the packed year table.
+
+  tools/lunargen.py src/lunar_calendar_table.h
+
+New moons follow Meeus, Astronomical Algorithms ch. 49, the sun's apparent
+longitude ch. 25 (about 0.01 degree). Months start on the local day of the
+new moon, the month holding the winter solstice is the 11th, and in a year
+of 13 months the first month without a principal solar term is the leap
+month. Dates are taken in Japan time, as the month names on the watch are
+the Japanese ones; --utc-offset 8 gives the Chinese calendar.
+
+Each lunar year packs into three bytes: bits 0-12 are the month lengths in
+order, leap month included (1 = 30 days), bits 13-16 the month the leap
+month follows (0 for none). tools/lunarcheck.py checks src/lunar_calendar.c
+against this, every day of the table.
+"""
+
+import argparse
+import datetime
+import math
+
+FIRST_YEAR = 1900
+LAST_YEAR = 2100
+SYNODIC_MONTH = 29.530588861
+TROPICAL_YEAR = 365.2422
+
+
+def _sin(degrees):
+    return math.sin(math.radians(degrees))
+
+
+def delta_t(year):
+    # Espenak and Meeus polynomials, seconds
+    if year < 1920:
+        t = year - 1900
+        return -2.79 + 1.494119 * t - 0.0598939 * t ** 2 + 0.0061966 * t ** 3 - 0.000197 * t ** 4
+    if year < 1941:
+        t = year - 1920
+        return 21.20 + 0.84493 * t - 0.076100 * t ** 2 + 0.0020936 * t ** 3
+    if year < 1961:
+        t = year - 1950
+        return 29.07 + 0.407 * t - t ** 2 / 233.0 + t ** 3 / 2547.0
+    if year < 1986:
+        t = year - 1975
+        return 45.45 + 1.067 * t - t ** 2 / 260.0 - t ** 3 / 718.0
+    if year < 2005:
+        t = year - 2000
+        return 63.86 + 0.3345 * t - 0.060374 * t ** 2 + 0.0017275 * t ** 3 + 0.000651814 * t ** 4 + 0.00002373599 * t ** 5
+    if year < 2050:
+        t = year - 2000
+        return 62.92 + 0.32217 * t + 0.005589 * t ** 2
+    if year < 2150:
+        return -20 + 32 * ((year - 1820) / 100.0) ** 2 - 0.5628 * (2150 - year)
+    return -20 + 32 * ((year - 1820) / 100.0) ** 2
+
+
+def new_moon(k):
+    """Julian ephemeris day of the k-th new moon after 2000-01-06."""
+    t = k / 1236.85
+    jde = (2451550.09766 + SYNODIC_MONTH * k + 0.00015437 * t ** 2
+           - 0.000000150 * t ** 3 + 0.00000000073 * t ** 4)
+    e = 1 - 0.002516 * t - 0.0000074 * t ** 2
+    m = 2.5534 + 29.10535670 * k - 0.0000014 * t ** 2 - 0.00000011 * t ** 3
+    mp = 201.5643 + 385.81693528 * k + 0.0107582 * t ** 2 + 0.00001238 * t ** 3 - 0.000000058 * t ** 4
+    f = 160.7108 + 390.67050284 * k - 0.0016118 * t ** 2 - 0.00000227 * t ** 3 + 0.000000011 * t ** 4
+    omega = 124.7746 - 1.56375588 * k + 0.0020672 * t ** 2 + 0.00000215 * t ** 3
+
+    jde += (-0.40720 * _sin(mp) + 0.17241 * e * _sin(m) + 0.01608 * _sin(2 * mp)
+            + 0.01039 * _sin(2 * f) + 0.00739 * e * _sin(mp - m) - 0.00514 * e * _sin(mp + m)
+            + 0.00208 * e * e * _sin(2 * m) - 0.00111 * _sin(mp - 2 * f) - 0.00057 * _sin(mp + 2 * f)
+            + 0.00056 * e * _sin(2 * mp + m) - 0.00042 * _sin(3 * mp) + 0.00042 * e * _sin(m + 2 * f)
+            + 0.00038 * e * _sin(m - 2 * f) - 0.00024 * e * _sin(2 * mp - m) - 0.00017 * _sin(omega)
+            - 0.00007 * _sin(mp + 2 * m) + 0.00004 * _sin(2 * mp - 2 * f) + 0.00004 * _sin(3 * m)
+            + 0.00003 * _sin(mp + m - 2 * f) + 0.00003 * _sin(2 * mp + 2 * f) - 0.00003 * _sin(mp + m + 2 * f)
+            + 0.00003 * _sin(mp - m + 2 * f) - 0.00002 * _sin(mp - m - 2 * f) - 0.00002 * _sin(3 * mp + m)
+            + 0.00002 * _sin(4 * mp))
+
+    planetary = [
+        (299.77, 0.107408, 0.000325), (251.88, 0.016321, 0.000165), (251.83, 26.651886, 0.000164),
+        (349.42, 36.412478, 0.000126), (84.66, 18.206239, 0.000110), (141.74, 53.303771, 0.000062),
+        (207.14, 2.453732, 0.000060), (154.84, 7.306860, 0.000056), (34.52, 27.261239, 0.000047),
+        (207.19, 0.121824, 0.000042), (291.34, 1.844379, 0.000040), (161.72, 24.198154, 0.000037),
+        (239.56, 25.513099, 0.000035), (331.55, 3.592518, 0.000023),
+    ]
+    for i, (base, rate, amplitude) in enumerate(planetary):
+        angle = base + rate * k - (0.009173 * t ** 2 if i == 0 else 0)
+        jde += amplitude * _sin(angle)
+
+    return jde
+
+
+def sun_longitude(jde):
+    t = (jde - 2451545.0) / 36525
+    l0 = 280.46646 + 36000.76983 * t + 0.0003032 * t ** 2
+    m = 357.52911 + 35999.05029 * t - 0.0001537 * t ** 2
+    c = ((1.914602 - 0.004817 * t - 0.000014 * t ** 2) * _sin(m)
+         + (0.019993 - 0.000101 * t) * _sin(2 * m) + 0.000289 * _sin(3 * m))
+    omega = 125.04 - 1934.136 * t
+    return (l0 + c - 0.00569 - 0.00478 * _sin(omega)) % 360
+
+
+def solar_term(year, longitude):
+    """Julian ephemeris day the sun reaches longitude in the given year."""
+    jde = 2451545.0 + (year - 2000) * TROPICAL_YEAR + ((longitude - 280.0) % 360) / 360.0 * TROPICAL_YEAR
+    for _ in range(50):
+        diff = (longitude - sun_longitude(jde) + 180) % 360 - 180
+        jde += diff * TROPICAL_YEAR / 360
+        if abs(diff) < 1e-7:
+            break
+    return jde
+
+
+def local_date(jde, utc_offset):
+    jd_ut = jde - delta_t(2000 + (jde - 2451545.0) / TROPICAL_YEAR) / 86400.0
+    # jd 2451544.5 is 2000-01-01 00:00 UT
+    days = jd_ut - 2451544.5 + utc_offset / 24.0
+    return datetime.date(2000, 1, 1) + datetime.timedelta(days=math.floor(days))
+
+
+def month_starts(utc_offset, first_year, last_year):
+    k = int(math.floor((first_year - 2000) * 12.3685)) - 2
+    starts = []
+    while True:
+        date = local_date(new_moon(k), utc_offset)
+        starts.append(date)
+        if date.year > last_year + 2:
+            return starts
+        k += 1
+
+
+def principal_terms(utc_offset, first_year, last_year):
+    terms = []
+    for year in range(first_year, last_year + 3):
+        for longitude in range(0, 360, 30):
+            terms.append(local_date(solar_term(year, longitude), utc_offset))
+    return sorted(terms)
+
+
+def lunar_years(utc_offset=9, first_year=FIRST_YEAR, last_year=LAST_YEAR):
+    """[(gregorian new year's day, [(month, is_leap, days), ...]), ...] per lunar year."""
+    starts = month_starts(utc_offset, first_year - 3, last_year)
+    terms = principal_terms(utc_offset, first_year - 3, last_year)
+
+    def month_of(date):
+        # index of the month holding date
+        for i in range(len(starts) - 1):
+            if starts[i] <= date < starts[i + 1]:
+                return i
+        raise ValueError(date)
+
+    def has_term(i):
+        return any(starts[i] <= term < starts[i + 1] for term in terms)
+
+    # number every month from the 11th of each winter solstice
+    numbered = {}
+    for year in range(first_year - 2, last_year + 1):
+        first = month_of(local_date(solar_term(year, 270), utc_offset))
+        last = month_of(local_date(solar_term(year + 1, 270), utc_offset))
+        leap = None
+        if last - first == 13:
+            leap = next(i for i in range(first + 1, last) if not has_term(i))
+        number = 11
+        for i in range(first, last):
+            if i == leap:
+                numbered[i] = (number - 1 if number > 1 else 12, True)
+                continue
+            numbered[i] = (number, False)
+            number = number % 12 + 1
+
+    years = []
+    for i in sorted(numbered):
+        month, is_leap = numbered[i]
+        entry = (month, is_leap, (starts[i + 1] - starts[i]).days)
+        if month == 1 and not is_leap:
+            if starts[i].year > last_year:
+                break
+            if starts[i].year >= first_year:
+                years.append((starts[i], []))
+        if years:
+            years[-1][1].append(entry)
+
+    return years
+
+
+def pack_year(months):
+    bits = 0
+    leap = 0
+    for index, (month, is_leap, days) in enumerate(months):
+        if days not in (29, 30):
+            raise ValueError('month of {} days'.format(days))
+        if days == 30:
+            bits |= 1 << index
+        if is_leap:
+            leap = month
+    return bits | (leap << 13)
+
+
+def table_source(years, utc_offset):
+    epoch = years[0][0]
+    lines = [
+        '// generated by tools/lunargen.py (utc offset {}), do not edit\n'.format(utc_offset),
+        '#pragma once\n',
+        '#include <pebble.h>\n',
+        '\n',
+        '#define LUNAR_FIRST_YEAR  {}\n'.format(years[0][0].year),
+        '#define LUNAR_YEAR_NUM    {}\n'.format(len(years)),
+        '\n',
+        '// first day of lunar year LUNAR_FIRST_YEAR\n',
+        '#define LUNAR_EPOCH_YEAR  {}\n'.format(epoch.year),
+        '#define LUNAR_EPOCH_MONTH {}\n'.format(epoch.month),
+        '#define LUNAR_EPOCH_MDAY  {}\n'.format(epoch.day),
+        '\n',
+        '// bits 0-12 month lengths in order (1 = 30 days), bits 13-16 month the leap month follows\n',
+        'static const uint8_t s_lunar_years[LUNAR_YEAR_NUM][3] = {\n',
+    ]
+    for start, months in years:
+        packed = pack_year(months)
+        lines.append('  {{ 0x{:02x}, 0x{:02x}, 0x{:02x} }},   // {}\n'.format(
+            packed & 0xFF, (packed >> 8) & 0xFF, packed >> 16, start.isoformat()))
+    lines.append('};\n')
+    return ''.join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('header', help='table header to write')
+    parser.add_argument('--utc-offset', type=int, default=9, help='hours, default 9 (japan)')
+    args = parser.parse_args()
+
+    with open(args.header, 'w') as f:
+        f.write(table_source(lunar_years(args.utc_offset), args.utc_offset))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python
+"""Turn the PROFILE/BENCH lines of a profiling build's log into json, or
+compare two such reports.
+
+  pebble build -- --profile
+  pebble install --emulator basalt --logs > basalt.log
+  tools/profile_report.py basalt.log > basalt.json
+  tools/profile_report.py --diff old.json new.json
+"""
+
+import argparse
+import json
+import re
+import sys
+
+BENCH_LINE = re.compile(r'BENCH,([^,]+),(\d+),(\d+)')
+PROFILE_LINE = re.compile(r'PROFILE,([^,]+),([^,]+),(-?\d+)')
+
+
+def parse(lines):
+    report = {'bench': {}, 'counters': {}}
+    for line in lines:
+        match = BENCH_LINE.search(line)
+        if match:
+            name, iterations, total_ms = match.group(1), int(match.group(2)), int(match.group(3))
+            report['bench'][name] = {
+                'iterations': iterations,
+                'total_ms': total_ms,
+                'us_per_iteration': round(total_ms * 1000.0 / iterations, 2),
+            }
+            continue
+
+        match = PROFILE_LINE.search(line)
+        if match:
+            # counters are cumulative, the last report wins
+            report['counters'].setdefault(match.group(1), {})[match.group(2)] = int(match.group(3))
+
+    return report
+
+
+def diff(old, new):
+    rows = []
+    for name in sorted(set(old['bench']) | set(new['bench'])):
+        before = old['bench'].get(name, {}).get('us_per_iteration')
+        after = new['bench'].get(name, {}).get('us_per_iteration')
+        rows.append(('bench', name, before, after))
+    for name in sorted(set(old['bench']) | set(new['bench'])):
+        # host reports (tools/host_bench.py) count instructions too
+        before = old['bench'].get(name, {}).get('instructions_per_iteration')
+        after = new['bench'].get(name, {}).get('instructions_per_iteration')
+        if before is not None or after is not None:
+            rows.append(('instructions', name, before, after))
+    for tag in sorted(set(old['counters']) | set(new['counters'])):
+        for name in sorted(set(old['counters'].get(tag, {})) | set(new['counters'].get(tag, {}))):
+            rows.append((tag, name, old['counters'].get(tag, {}).get(name), new['counters'].get(tag, {}).get(name)))
+
+    for group, name, before, after in rows:
+        change = ''
+        if before and after is not None:
+            change = '{:+.1f}%'.format((after - before) * 100.0 / before)
+        print('{:<12} {:<24} {:>12} {:>12} {:>9}'.format(group, name, before, after, change))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--diff', nargs=2, metavar=('OLD', 'NEW'), help='compare two json reports')
+    parser.add_argument('log', nargs='?', help='log capture, stdin if omitted')
+    args = parser.parse_args()
+
+    if args.diff:
+        with open(args.diff[0]) as f:
+            old = json.load(f)
+        with open(args.diff[1]) as f:
+            new = json.load(f)
+        diff(old, new)
+        return
+
+    lines = open(args.log) if args.log else sys.stdin
+    json.dump(parse(lines), sys.stdout, indent=2, sort_keys=True)
+    sys.stdout.write('\n')
+
+
+if __name__ == '__main__':
+    main()
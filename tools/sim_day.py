@@ -0,0 +1,172 @@
+#!/usr/bin/env python
+"""Run a --sim-day build in the emulator and summarize its cost per hour.
+
+  pebble build -- --sim-day
+  tools/sim_day.py --emulator basalt --json basalt.json
+  tools/profile_report.py --diff last_release.json basalt.json
+
+The build replays a day of minute ticks and a few config changes, or a trace
+recorded from the watch with --sim-trace (see simtrace.py), logging its
+counters once per simulated hour. Awake time only covers the app's own
+handlers, the firmware's compositing shows up as display updates. Emulator
+timings are for comparing builds, not absolute battery figures.
+
+The host build (tools/host) runs the same day without the sdk or an emulator,
+in seconds, and takes a trace the same way:
+
+  make -C tools/host simday TRACE=day.trace PLATFORMS=basalt
+  tools/sim_day.py --host tools/host/build/basalt/simtrace --json basalt.json
+
+Its clock is simulated, so its times are 0: it gives the counts of the work
+done (transitions, frames, path fills, layer mutations, loads, persist
+writes), exactly and the same on every run.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import profile_report
+
+
+def capture(emulator, log_path, timeout, done_marker='SIM,done'):
+    process = subprocess.Popen(['pebble', 'install', '--emulator', emulator, '--logs'],
+                               stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                               universal_newlines=True)
+    lines = []
+    deadline = time.time() + timeout
+    try:
+        with open(log_path, 'w') as log:
+            for line in process.stdout:
+                log.write(line)
+                lines.append(line)
+                if done_marker in line:
+                    break
+                if time.time() > deadline:
+                    raise RuntimeError('no {} after {} s, is this the right kind of build?'.format(done_marker, timeout))
+    finally:
+        process.terminate()
+        process.wait()
+
+    return lines
+
+
+def run_host(binary, log_path):
+    output = subprocess.check_output([binary], universal_newlines=True)
+    with open(log_path, 'w') as log:
+        log.write(output)
+    return output.splitlines(True)
+
+
+def summarize(report):
+    hours = [tag for tag in sorted(report['counters']) if tag.startswith('hour')]
+    if not hours:
+        raise RuntimeError('no hourly counters in the log')
+
+    totals = {}
+    for tag in hours:
+        for name, value in report['counters'][tag].items():
+            totals[name] = totals.get(name, 0) + value
+    per_hour = dict((name, round(value / float(len(hours)), 1)) for name, value in totals.items())
+
+    # anim_update includes the refresh_time done mid transition
+    per_hour['transition_ms'] = round(per_hour['anim_ms'] + per_hour['star_draw_ms'] - per_hour['refresh_time_ms'], 1)
+    per_hour['layout_ms'] = per_hour['refresh_time_ms']
+
+    # frame governor, a transition lasts 1.6 s
+    transitions = per_hour.get('transitions', 0)
+    updates = per_hour.get('display_updates', 0)
+    per_hour['delivered_fps'] = round(updates / (transitions * 1.6), 1) if transitions else 0
+    per_hour['frame_ms'] = round(per_hour['transition_ms'] / updates, 2) if updates else 0
+
+    # aplite glyph cache, font_resident_bytes compares against a full atlas build
+    lookups = per_hour.get('glyph_cache_hits', 0) + per_hour.get('glyph_cache_misses', 0)
+    per_hour['glyph_cache_hit_pct'] = round(per_hour.get('glyph_cache_hits', 0) * 100.0 / lookups, 1) if lookups else 0
+
+    # minute boundary to the new time on screen, negative when shown early
+    changes = per_hour.get('time_changes', 0)
+    per_hour['time_latency_ms'] = round(per_hour.get('time_latency_ms', 0) / changes, 1) if changes else 0
+    per_hour['time_latency_max_ms'] = max(report['counters'][tag].get('time_latency_max_ms', 0) for tag in hours)
+
+    # scene snapshot, frames restored from it composite no glyphs
+    per_hour['snapshot_heap_bytes'] = max(report['counters'][tag].get('snapshot_heap_bytes', 0) for tag in hours)
+
+    # draw and storage accounting, the workload builds are compared on
+    per_hour['bitmap_loads'] = per_hour.get('font_loads', 0) + per_hour.get('glyph_cache_misses', 0)
+
+    return len(hours), per_hour
+
+
+def per_day(per_hour):
+    return dict((name, round(per_hour.get(name, 0) * 24)) for name in
+                ['awake_ms', 'layer_mutations', 'star_draws', 'pixels_touched', 'bitmap_loads', 'persist_writes'])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--emulator', default='basalt', help='emulator platform, default basalt')
+    parser.add_argument('--host', metavar='BINARY',
+                        help='run a simday or simtrace program of the host build instead of the emulator')
+    parser.add_argument('--log', help='summarize an existing log capture instead of running the emulator')
+    parser.add_argument('--json', help='write the per hour averages here, for profile_report.py --diff')
+    parser.add_argument('--timeout', type=int, default=3600, help='seconds to wait for the run, default 3600')
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log) as f:
+            lines = f.readlines()
+    elif args.host:
+        lines = run_host(args.host, args.host + '.log')
+    else:
+        lines = capture(args.emulator, 'sim_day_{}.log'.format(args.emulator), args.timeout)
+
+    hours, per_hour = summarize(profile_report.parse(lines))
+
+    print('{} simulated hours, per hour:'.format(hours))
+    for label, name in [('awake ms', 'awake_ms'),
+                        ('  transition ms', 'transition_ms'),
+                        ('  layout ms', 'layout_ms'),
+                        ('  recolor ms', 'recolor_ms'),
+                        ('  font load ms', 'font_load_ms'),
+                        ('font resident bytes', 'font_resident_bytes'),
+                        ('  cache hit %', 'glyph_cache_hit_pct'),
+                        ('time latency ms', 'time_latency_ms'),
+                        ('  max', 'time_latency_max_ms'),
+                        ('transitions', 'transitions'),
+                        ('  requested', 'transition_requests'),
+                        ('frames stepped', 'anim_frames'),
+                        ('  over fps cap', 'frames_skipped'),
+                        ('  unchanged', 'frames_unchanged'),
+                        ('  from snapshot', 'snapshot_restores'),
+                        ('display updates', 'display_updates'),
+                        ('  delivered fps', 'delivered_fps'),
+                        ('  ms per frame', 'frame_ms'),
+                        ('stars drawn', 'star_draws'),
+                        ('snapshot bytes', 'snapshot_heap_bytes'),
+                        ('  snapshot ms', 'snapshot_ms'),
+                        ('config messages', 'config_messages')]:
+        print('  {:<18} {:>10}'.format(label, per_hour.get(name, 0)))
+
+    day = per_day(per_hour)
+    print('per simulated day:')
+    for label, name in [('awake ms', 'awake_ms'),
+                        ('layer mutations', 'layer_mutations'),
+                        ('path fills', 'star_draws'),
+                        ('pixels touched', 'pixels_touched'),
+                        ('bitmap loads', 'bitmap_loads'),
+                        ('persist writes', 'persist_writes')]:
+        print('  {:<18} {:>10}'.format(label, day[name]))
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump({'bench': {}, 'counters': {'per_hour': per_hour, 'per_day': day}}, f, indent=2, sort_keys=True)
+            f.write('\n')
+
+
+if __name__ == '__main__':
+    main()
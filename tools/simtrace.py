@@ -0,0 +1,129 @@
+#!/usr/bin/env python
+"""Pack the log of a --trace build into a trace, for a --sim-trace build to
+replay in place of the built-in simulated day.
+
+  pebble build -- --trace
+  pebble install --phone <ip> --logs > worn.log     (a day of wearing it)
+  tools/simtrace.py worn.log day.trace
+  pebble build -- --sim-trace day.trace
+  tools/sim_day.py --json day.json
+
+A trace is a text file: the time of day it started, its length in minutes
+(rounded up to whole hours, sim_day.py reports per hour), then one config
+change per line as <minute> <config key> <value>:
+
+  start 0717
+  minutes 960
+  124 2 #FFAA55
+  125 6 1
+
+The replay ticks every minute of the trace, minutes the face was not running
+included, and sends each config change at its minute.
+"""
+
+import argparse
+import os
+import re
+
+TRACE_LINE = re.compile(r'TRACE,(\w+),([^,\s]+)(?:,(\S+))?')
+
+
+def pack(lines):
+    """(start hhmm, minutes, [(minute, key, value), ...]) of a --trace log."""
+    start = None
+    last_minute = 0
+    steps = []
+    for line in lines:
+        match = TRACE_LINE.search(line)
+        if not match:
+            continue
+        if match.group(1) == 'start':
+            if start is not None:
+                raise ValueError('more than one TRACE,start, the face restarted mid capture')
+            start = match.group(2)
+            continue
+
+        minute = int(match.group(1))
+        last_minute = max(last_minute, minute)
+        if match.group(2) != 'tick':
+            steps.append((minute, int(match.group(2)), match.group(3)))
+
+    if start is None:
+        raise ValueError('no TRACE,start in the log, is this a --trace build?')
+
+    minutes = (last_minute // 60 + 1) * 60
+    return start, minutes, steps
+
+
+def write_trace(path, start, minutes, steps):
+    with open(path, 'w') as f:
+        f.write('start {}\n'.format(start))
+        f.write('minutes {}\n'.format(minutes))
+        for minute, key, value in steps:
+            f.write('{} {} {}\n'.format(minute, key, value))
+
+
+def read_trace(path):
+    start = minutes = None
+    steps = []
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if not fields:
+                continue
+            if fields[0] == 'start':
+                start = fields[1]
+            elif fields[0] == 'minutes':
+                minutes = int(fields[1])
+            else:
+                steps.append((int(fields[0]), int(fields[1]), fields[2]))
+    if start is None or minutes is None:
+        raise ValueError('{}: no start or minutes line'.format(path))
+    return start, minutes, steps
+
+
+def header_source(trace_name, start, minutes, steps):
+    lines = [
+        '// generated by tools/simtrace.py from {}, do not edit\n'.format(trace_name),
+        '#pragma once\n',
+        '\n',
+        '#define SIM_DAY_MINUTES       {}\n'.format(minutes),
+        '#define SIM_DAY_START_MINUTE  {}   // {}\n'.format(int(start[:2]) * 60 + int(start[2:]), start),
+        '\n',
+        'static const struct SimConfigStep s_sim_config_steps[] = {\n',
+    ]
+    for minute, key, value in steps:
+        if value.startswith('#'):
+            lines.append('  {{ {}, {}, "{}", 0 }},\n'.format(minute, key, value))
+        else:
+            lines.append('  {{ {}, {}, NULL, {} }},\n'.format(minute, key, int(value)))
+    if not steps:
+        # never reached, keeps the table from being empty
+        lines.append('  { -1, 0, NULL, 0 },\n')
+    lines.append('};\n')
+    return ''.join(lines)
+
+
+def generate(trace_path, header_path, log=None):
+    start, minutes, steps = read_trace(trace_path)
+    with open(header_path, 'w') as f:
+        f.write(header_source(os.path.basename(trace_path), start, minutes, steps))
+    if log:
+        log('simtrace: {} minutes from {}, {} config changes'.format(minutes, start, len(steps)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('log', help='log capture of a --trace build')
+    parser.add_argument('trace', help='trace file to write')
+    args = parser.parse_args()
+
+    with open(args.log) as f:
+        start, minutes, steps = pack(f)
+    write_trace(args.trace, start, minutes, steps)
+    print('{} minutes from {}, {} config changes'.format(minutes, start, len(steps)))
+
+
+if __name__ == '__main__':
+    main()
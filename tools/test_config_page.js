@@ -0,0 +1,237 @@
+// Round trip of the settings through the bundled config page, in headless
+// Chrome: the companion js opens the page with the stored config, the page
+// shows it, a change is saved, and the companion stores and sends the keys
+// that changed. It runs for the page with its fonts subset and inlined whole.
+// The companion's retry of a failed send is checked on its own.
+//
+//   npm install puppeteer      (or NODE_PATH=$(npm root -g) with a global one)
+//   node tools/test_config_page.js
+//
+// The page returns to pebblejs://close, which a browser does not load. Its
+// return_to parameter, the one the emulator uses, points it somewhere the test
+// can catch instead.
+
+"use strict";
+
+var childProcess = require("child_process");
+var fs = require("fs");
+var os = require("os");
+var path = require("path");
+var vm = require("vm");
+
+var ROOT = path.join(__dirname, "..");
+var RETURN_URL = "https://config.test/close#";
+
+var puppeteer;
+try {
+  puppeteer = require("puppeteer");
+}
+catch (e) {
+  console.error("test_config_page: needs puppeteer, npm install puppeteer");
+  process.exit(2);
+}
+
+var failures = 0;
+
+function check(condition, text) {
+  if (!condition) {
+    ++failures;
+    console.error("failed: " + text);
+  }
+}
+
+// the page as wscript bundles it, with or without subsetting its fonts
+function bundlePage(subsetFonts) {
+  var out = path.join(fs.mkdtempSync(path.join(os.tmpdir(), "config-page-")), "config_page.js");
+  var script = [
+    "import sys",
+    "sys.path.insert(0, 'tools')",
+    "import configbundle",
+    "configbundle.generate('config-web', 'config-klk.html', sys.argv[1], subset_fonts=" + (subsetFonts ? "True" : "False") + ")"
+  ].join("\n");
+  childProcess.execFileSync("python3", ["-c", script, out], { cwd: ROOT, stdio: "inherit" });
+  return fs.readFileSync(out, "utf8");
+}
+
+// pebble-js-app.js and the bundled page as the build concatenates them, with
+// stand-ins for localStorage and the Pebble object
+function loadCompanion(pageSource, stored) {
+  var context = {
+    console: { log: function() {} },
+    setTimeout: setTimeout,
+    opened: [],
+    sent: [],
+    listeners: {},
+    storage: stored,
+    encodeURIComponent: encodeURIComponent,
+    decodeURIComponent: decodeURIComponent
+  };
+  context.localStorage = {
+    getItem: function(key) { return context.storage.hasOwnProperty(key) ? context.storage[key] : null; },
+    setItem: function(key, value) { context.storage[key] = String(value); },
+    removeItem: function(key) { delete context.storage[key]; }
+  };
+  context.Pebble = {
+    addEventListener: function(name, listener) { context.listeners[name] = listener; },
+    getActiveWatchInfo: function() { return { platform: "basalt" }; },
+    openURL: function(url) { context.opened.push(url); },
+    sendAppMessage: function(msg, success) {
+      context.sent.push(msg);
+      setTimeout(function() { success({ data: { transactionId: context.sent.length } }); }, 0);
+    }
+  };
+
+  vm.createContext(context);
+  vm.runInContext(fs.readFileSync(path.join(ROOT, "src/js/pebble-js-app.js"), "utf8") + "\n" + pageSource, context);
+  return context;
+}
+
+async function testRoundTrip(browser, subsetFonts) {
+  var name = subsetFonts ? "subset fonts" : "whole fonts";
+  var config = {
+    bgColor: "0x0055AA", starColor: "0xFFFF00", timeColor: "0xFFFFFF", dateColor: "0xFFAA00", monthColor: "0xFFFFFF",
+    isEnableDate: 1, isEnableMonth: 0, isEnableYear: 1, isUseAmPm: 0, isUseLunar: 1, isUsePrefix: 1, isUseFormal: 0,
+    isEnableTelemetry: 1, datePositionType: 1
+  };
+  var companion = loadCompanion(bundlePage(subsetFonts), {
+    config: JSON.stringify(config),
+    configSent: JSON.stringify(config),
+    telemetry: JSON.stringify({ 20261023: { transitions: 1440, animMs: 52000, configApplies: 2, persistWrites: 2,
+      batterySamples: 9, chargingSamples: 0, batteryFirst: 90, batteryLast: 80, batteryMin: 80 } })
+  });
+
+  companion.listeners.showConfiguration({ payload: {} });
+  var url = companion.opened[0] || "";
+  check(url.indexOf("data:text/html") === 0, name + ": the bundled page opens, not " + url.substring(0, 40));
+
+  var params = JSON.parse(decodeURIComponent(url.substring(url.indexOf("#") + 1)));
+  params.return_to = RETURN_URL;
+  url = url.substring(0, url.indexOf("#") + 1) + encodeURIComponent(JSON.stringify(params));
+
+  var page = await browser.newPage();
+  var errors = [];
+  page.on("pageerror", function(e) { errors.push(e.message); });
+  await page.setRequestInterception(true);
+  var returned = new Promise(function(resolve) {
+    page.on("request", function(request) {
+      if (request.url().indexOf(RETURN_URL) === 0) {
+        resolve(request.url().substring(RETURN_URL.length));
+        request.abort();
+      }
+      else {
+        request.continue();
+      }
+    });
+  });
+
+  await page.goto(url);
+  await page.evaluate(function() { return document.fonts.ready; });
+
+  var shown = await page.evaluate(function() {
+    var fonts = [];
+    document.fonts.forEach(function(font) { fonts.push(font.family + " " + font.status); });
+    return {
+      fonts: fonts,
+      telemetry: document.getElementById("telemetry_days").textContent
+    };
+  });
+  check(shown.fonts.length > 0, name + ": the page has its fonts");
+  shown.fonts.forEach(function(font) {
+    check(/ loaded$/.test(font), name + ": font " + font);
+  });
+  check(shown.telemetry.indexOf("No days reported") < 0, name + ": the stored day shows");
+  check(errors.length === 0, name + ": page errors " + errors.join(", "));
+
+  // a change, saved as the page's button does
+  await page.evaluate(function() {
+    $("#time_color").val("0xFF0000");
+    $("#month_flag").prop("checked", true);
+  });
+  await page.click("input[value=SAVE]");
+  var response = await returned;
+  await page.close();
+
+  // what the page saves is what it showed, the change aside
+  var shownSettings = JSON.parse(decodeURIComponent(response));
+  for (var key in config) {
+    if (key === "timeColor" || key === "isEnableMonth") continue;
+    check(String(shownSettings[key]) === String(config[key]), name + ": " + key + " shows " + shownSettings[key] + ", stored " + config[key]);
+  }
+
+  companion.listeners.webviewclosed({ response: response });
+  await new Promise(function(resolve) { setTimeout(resolve, 10); });
+
+  var saved = JSON.parse(companion.storage.config);
+  check(saved.timeColor === "0xFF0000" && saved.isEnableMonth === 1, name + ": the change is stored, " + companion.storage.config);
+  check(saved.bgColor === config.bgColor && saved.datePositionType === config.datePositionType, name + ": the rest is kept");
+  check(companion.sent.length === 1 && JSON.stringify(companion.sent[0]) === JSON.stringify({ timeColor: "0xFF0000", isEnableMonth: 1 }),
+    name + ": only the changed keys are sent, " + JSON.stringify(companion.sent));
+  check(companion.storage.configSent === companion.storage.config, name + ": the watch has acked them");
+
+  console.log("test_config_page: " + name + ", " + url.length + " bytes of uri");
+}
+
+// without the bundled page the hosted one opens, its query string reaches the
+// server and so carries the settings only
+function testHostedPage() {
+  var companion = loadCompanion("", {
+    config: JSON.stringify({ bgColor: "0x000000", isEnableTelemetry: 1 }),
+    telemetry: JSON.stringify({ 20261023: { transitions: 1440 } })
+  });
+
+  companion.listeners.showConfiguration({ payload: {} });
+  var url = companion.opened[0] || "";
+  check(url.indexOf("https://exe44.github.io/") === 0, "hosted page: opens, not " + url.substring(0, 40));
+  check(url.indexOf("telemetry") < 0 && url.indexOf("20261023") < 0, "hosted page: no telemetry in " + url);
+
+  // turned off on the page, the kept days go
+  companion.listeners.webviewclosed({ response: encodeURIComponent(JSON.stringify({ bgColor: "0x000000", isEnableTelemetry: 0 })) });
+  check(companion.storage.telemetry === undefined, "hosted page: telemetry dropped once turned off");
+}
+
+// a failed send waits out its backoff: a save meanwhile joins the message
+// waiting for the retry, neither sent at once nor queued a second time
+function testSendRetry() {
+  var companion = loadCompanion("", {});
+  var timers = [];
+  var replies = [];
+  companion.setTimeout = function(callback) { timers.push(callback); return timers.length; };
+  companion.Pebble.sendAppMessage = function(msg, success, failure) {
+    companion.sent.push(JSON.parse(JSON.stringify(msg)));
+    replies.push({ success: success, failure: failure });
+  };
+
+  companion.listeners.webviewclosed({ response: encodeURIComponent(JSON.stringify({ bgColor: "0x000000", timeColor: "0xFFFFFF" })) });
+  replies[0].failure({ data: { transactionId: 1 }, error: { message: "NACK" } });
+  check(timers.length === 1, "send retry: the retry waits, " + timers.length + " timers");
+
+  companion.listeners.webviewclosed({ response: encodeURIComponent(JSON.stringify({ bgColor: "0x000000", timeColor: "0xFF0000" })) });
+  check(companion.sent.length === 1, "send retry: nothing sent before the backoff is over, " + JSON.stringify(companion.sent));
+
+  timers[0]();
+  check(companion.sent.length === 2 && JSON.stringify(companion.sent[1]) === JSON.stringify({ bgColor: "0x000000", timeColor: "0xFF0000" }),
+    "send retry: one message with the newer values, " + JSON.stringify(companion.sent));
+  replies[1].success({ data: { transactionId: 2 } });
+  check(companion.sent.length === 2 && companion.storage.configSent === companion.storage.config,
+    "send retry: acked once, " + JSON.stringify(companion.sent));
+}
+
+(async function() {
+  testHostedPage();
+  testSendRetry();
+
+  var browser = await puppeteer.launch({ headless: "shell", args: ["--no-sandbox"] });
+  try {
+    await testRoundTrip(browser, true);
+    await testRoundTrip(browser, false);
+  }
+  finally {
+    await browser.close();
+  }
+
+  console.log("test_config_page: " + (failures ? failures + " failed" : "ok"));
+  process.exit(failures ? 1 : 0);
+})().catch(function(e) {
+  console.error(e);
+  process.exit(1);
+});